@@ -0,0 +1,19 @@
+#ifndef CPU_SOLVER_H
+#define CPU_SOLVER_H
+
+#define CPU_BLOCK_SIZE 64
+#define CPU_COLUMN_TILE 512
+
+void generate_matrix(float* matrix, int size);
+
+void print_matrix(float* matrix, int size);
+
+void calculate_determinant_gauss(float* matrix, int size, float* out_mantissa, long long* out_exponent, int* out_sign);
+
+int cpu_thread_count(void);
+
+double wall_clock_seconds(void);
+
+void calculate_determinant_blocked(float* matrix, int size, int thread_count, float* out_mantissa, long long* out_exponent, int* out_sign);
+
+#endif
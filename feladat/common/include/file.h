@@ -0,0 +1,10 @@
+#ifndef FILE_H
+#define FILE_H
+
+void write_benchmark_to_file(const char* file_name, int matrix_size, double exec_time);
+
+int read_tuned_block_size(const char* file_name, const char* device_name);
+
+void write_tuned_block_size(const char* file_name, const char* device_name, int matrix_size, int block_size, double exec_time);
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef KERNEL_LOADER_H
+#define KERNEL_LOADER_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <CL/cl.h>
+
+#define KERNEL_CACHE_DIR "kernel_cache"
+
+char* load_kernel_source(const char* const path, int* error_code);
+
+unsigned long long hash_kernel_source(const char* source);
+
+cl_program build_program_cached(cl_context context, cl_device_id device_id, const char* source, const char* options, const char* cache_dir, int* out_from_cache, int* error_code);
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef MATRIX_FILE_H
+#define MATRIX_FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define MATRIX_FILE_MAGIC "DETMTX\r\n"
+#define MATRIX_FILE_VERSION 1
+#define MATRIX_FILE_HEADER_SIZE 64
+#define MATRIX_FILE_HAS_CHECKSUM 1u
+
+#define MATRIX_FILE_ERROR_IO -1
+#define MATRIX_FILE_ERROR_FORMAT -2
+#define MATRIX_FILE_ERROR_CHECKSUM -3
+#define MATRIX_FILE_ERROR_SIZE -4
+
+typedef enum {
+    MATRIX_ELEMENT_FLOAT32 = 1,
+    MATRIX_ELEMENT_FLOAT64 = 2
+} matrix_element_type;
+
+typedef enum {
+    MATRIX_LAYOUT_ROW_MAJOR = 0,
+    MATRIX_LAYOUT_COLUMN_MAJOR = 1
+} matrix_layout;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t rows;
+    uint64_t cols;
+    uint32_t element_type;
+    uint32_t layout;
+    uint32_t flags;
+    uint32_t reserved;
+    uint64_t checksum;
+    uint64_t reserved_tail;
+} matrix_file_header;
+
+typedef struct {
+    matrix_file_header header;
+    void* mapping;
+    size_t mapping_size;
+    void* elements;
+    float* converted;
+#ifdef _WIN32
+    void* file_handle;
+    void* mapping_handle;
+#endif
+} matrix_file;
+
+typedef struct {
+    FILE* file;
+    matrix_file_header header;
+    uint64_t written;
+    uint64_t checksum;
+} matrix_file_writer;
+
+size_t matrix_element_size(matrix_element_type element_type);
+
+uint64_t matrix_file_checksum_update(uint64_t checksum, const void* data, size_t bytes);
+
+void matrix_file_open(const char* path, matrix_file* file, int* error_code);
+
+int matrix_file_verify(const matrix_file* file);
+
+float* matrix_file_floats(matrix_file* file, int* error_code);
+
+void matrix_file_close(matrix_file* file);
+
+void matrix_file_writer_open(matrix_file_writer* writer, const char* path, uint64_t rows, uint64_t cols, matrix_element_type element_type, matrix_layout layout, uint32_t flags, int* error_code);
+
+void matrix_file_writer_write(matrix_file_writer* writer, const void* elements, size_t count, int* error_code);
+
+void matrix_file_writer_close(matrix_file_writer* writer, int* error_code);
+
+void write_matrix_file(const char* path, const float* matrix, int size, int* error_code);
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <CL/cl.h>
+
+#define PROFILER_NAME_LENGTH 48
+#define PROFILER_PHASE_LENGTH 24
+#define PROFILER_MAX_GROUPS 32
+
+typedef struct {
+    char name[PROFILER_NAME_LENGTH];
+    char phase[PROFILER_PHASE_LENGTH];
+    cl_ulong queued;
+    cl_ulong submit;
+    cl_ulong start;
+    cl_ulong end;
+    double bytes;
+} profile_record;
+
+typedef struct {
+    profile_record* records;
+    int count;
+    int capacity;
+} profiler;
+
+typedef struct {
+    const char* engine;
+    cl_device_id device_id;
+    int matrix_size;
+    int block_size;
+    const char* precision;
+    double wall_time;
+    double flops;
+} profile_info;
+
+profiler* create_profiler(void);
+
+void profiler_reset(profiler* profiler);
+
+void release_profiler(profiler* profiler);
+
+float record_event_times(profiler* profiler, cl_event* events, int count, const char* name, const char* phase, double bytes);
+
+int write_profile_json(const profiler* profiler, const profile_info* info, const char* path);
+
+int write_profile_csv(const profiler* profiler, const profile_info* info, const char* path);
+
+int write_chrome_trace(const profiler* profiler, const char* path);
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef SCALED_PRODUCT_H
+#define SCALED_PRODUCT_H
+
+#define SCALED_PRODUCT_ZERO_THRESHOLD 1e-12
+#define SCALED_PRODUCT_LANES 8
+#define SCALED_PRODUCT_RENORMALIZE_INTERVAL 256
+
+typedef struct {
+    double mantissa;
+    long long exponent;
+    int sign;
+    int is_zero;
+} scaled_product;
+
+void scaled_product_init(scaled_product* product);
+
+void scaled_product_multiply(scaled_product* product, double value);
+
+void scaled_product_multiply_strided(scaled_product* product, const float* values, int count, int stride);
+
+void scaled_product_multiply_diagonal(scaled_product* product, const float* matrix, int size);
+
+void scaled_product_to_decimal(const scaled_product* product, float* out_mantissa, long long* out_exponent, int* out_sign);
+
+void binary_to_decimal(double mantissa, long long exponent, float* out_mantissa, long long* out_exponent);
+
+#endif
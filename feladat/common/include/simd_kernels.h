@@ -0,0 +1,32 @@
+#ifndef SIMD_KERNELS_H
+#define SIMD_KERNELS_H
+
+typedef enum {
+    SIMD_SCALAR,
+    SIMD_SSE,
+    SIMD_AVX2,
+    SIMD_AVX512,
+    SIMD_ISA_COUNT
+} simd_isa;
+
+typedef void (*axpy_function)(float* target, const float* source, float factor, int length);
+
+typedef void (*axpy4_function)(float* target, const float* const* sources, const float* factors, int length);
+
+typedef int (*argmax_abs_function)(const float* values, int stride, int length);
+
+typedef struct {
+    simd_isa isa;
+    const char* name;
+    axpy_function axpy;
+    axpy4_function axpy4;
+    argmax_abs_function argmax_abs;
+} simd_kernels;
+
+int simd_isa_supported(simd_isa isa);
+
+const simd_kernels* get_simd_kernels(simd_isa isa);
+
+const simd_kernels* select_simd_kernels(void);
+
+#endif
@@ -0,0 +1,121 @@
+#include "scaled_product.h"
+#include "cpu_solver.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MIN_ELEMENTS_PER_SIZE 50000000
+
+static const int product_lengths[] = {1000, 10000, 100000, 1000000};
+
+static void fill_pivots(float* values, int count) {
+    for (int i = 0; i < count; i++) {
+        float magnitude = 0.5f + (float)(rand() % 19500) / 1000.0f;
+        values[i] = rand() % 2 == 0 ? magnitude : -magnitude;
+    }
+}
+
+static void legacy_product(const float* values, int count, float* out_mantissa, long long* out_exponent, int* out_sign) {
+    float mantissa = 1.0;
+    long long exponent = 0;
+    int sign = 1;
+
+    for (int i = 0; i < count; i++) {
+        float value = values[i];
+
+        if (fabs(value) < 1e-12) {
+            mantissa = 0.0;
+            exponent = 0;
+            break;
+        }
+
+        if (value < 0) {
+            sign = -sign;
+            value = -value;
+        }
+
+        mantissa *= value;
+
+        while (mantissa >= 10.0) {
+            mantissa /= 10.0;
+            exponent++;
+        }
+        while (mantissa < 1.0 && mantissa > 0.0) {
+            mantissa *= 10.0;
+            exponent--;
+        }
+    }
+
+    *out_mantissa = mantissa;
+    *out_exponent = exponent;
+    *out_sign = sign;
+}
+
+static void scaled_product_of(const float* values, int count, float* out_mantissa, long long* out_exponent, int* out_sign) {
+    scaled_product product;
+    scaled_product_init(&product);
+    scaled_product_multiply_strided(&product, values, count, 1);
+    scaled_product_to_decimal(&product, out_mantissa, out_exponent, out_sign);
+}
+
+static long double reference_log10(const float* values, int count) {
+    long double sum = 0.0L;
+    for (int i = 0; i < count; i++) {
+        sum += log10l(fabsl((long double)values[i]));
+    }
+    return sum;
+}
+
+static double relative_error(float mantissa, long long exponent, long double reference) {
+    long double difference = log10l((long double)mantissa) + (long double)exponent - reference;
+    return (double)fabsl(powl(10.0L, difference) - 1.0L);
+}
+
+static void benchmark_product(int count) {
+    float* values = malloc(count * sizeof(float));
+    if (values == NULL) {
+        return;
+    }
+
+    fill_pivots(values, count);
+    long double reference = reference_log10(values, count);
+
+    float legacy_mantissa = 0.0f, scaled_mantissa = 0.0f;
+    long long legacy_exponent = 0, scaled_exponent = 0;
+    int legacy_sign = 1, scaled_sign = 1;
+    int repetitions = MIN_ELEMENTS_PER_SIZE / count;
+
+    double start = wall_clock_seconds();
+    for (int run = 0; run < repetitions; run++) {
+        legacy_product(values, count, &legacy_mantissa, &legacy_exponent, &legacy_sign);
+    }
+    double legacy_time = (wall_clock_seconds() - start) / repetitions;
+
+    start = wall_clock_seconds();
+    for (int run = 0; run < repetitions; run++) {
+        scaled_product_of(values, count, &scaled_mantissa, &scaled_exponent, &scaled_sign);
+    }
+    double scaled_time = (wall_clock_seconds() - start) / repetitions;
+
+    printf("%8d  legacy %8.3f ns/elem  rel err %.2e  |  scaled %8.3f ns/elem  rel err %.2e  |  %6.2fx  %s\n",
+           count,
+           legacy_time * 1.0e9 / count, relative_error(legacy_mantissa, legacy_exponent, reference),
+           scaled_time * 1.0e9 / count, relative_error(scaled_mantissa, scaled_exponent, reference),
+           scaled_time > 0.0 ? legacy_time / scaled_time : 0.0,
+           legacy_sign == scaled_sign ? "signs match" : "SIGN MISMATCH");
+
+    free(values);
+}
+
+int main() {
+    srand(42);
+
+    printf("Diagonal product: float while-loop (legacy) vs binary scaled product\n");
+    printf("Relative error against a long double sum of log10|d_i|\n");
+    for (size_t i = 0; i < sizeof(product_lengths) / sizeof(product_lengths[0]); i++) {
+        benchmark_product(product_lengths[i]);
+    }
+
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include "simd_kernels.h"
+#include "cpu_solver.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MIN_ELEMENTS_PER_SIZE 50000000
+
+static const int axpy_lengths[] = {64, 256, 1024, 4096, 16384};
+static const int argmax_sizes[] = {256, 1024, 4096};
+
+static void fill_random(float* values, int count) {
+    for (int i = 0; i < count; i++) {
+        values[i] = (float)(rand() % 2001 - 1000) / 100.0f;
+    }
+}
+
+static void benchmark_axpy(int length) {
+    float* source = malloc(length * sizeof(float));
+    float* target = malloc(length * sizeof(float));
+    float* reference = malloc(length * sizeof(float));
+    float* initial = malloc(length * sizeof(float));
+    if (source == NULL || target == NULL || reference == NULL || initial == NULL) {
+        free(source);
+        free(target);
+        free(reference);
+        free(initial);
+        return;
+    }
+
+    fill_random(source, length);
+    fill_random(initial, length);
+
+    memcpy(reference, initial, length * sizeof(float));
+    get_simd_kernels(SIMD_SCALAR)->axpy(reference, source, 0.5f, length);
+
+    int repetitions = MIN_ELEMENTS_PER_SIZE / length;
+    double scalar_time = 0.0;
+
+    for (int isa = SIMD_SCALAR; isa < SIMD_ISA_COUNT; isa++) {
+        const simd_kernels* kernels = get_simd_kernels((simd_isa)isa);
+        if (kernels == NULL) {
+            printf("AXPY   %6d  %-8s  not supported\n", length, isa == SIMD_SSE ? "SSE2" : isa == SIMD_AVX2 ? "AVX2" : "AVX-512");
+            continue;
+        }
+
+        memcpy(target, initial, length * sizeof(float));
+        kernels->axpy(target, source, 0.5f, length);
+        float max_difference = 0.0f;
+        for (int i = 0; i < length; i++) {
+            float difference = fabsf(target[i] - reference[i]);
+            if (difference > max_difference) {
+                max_difference = difference;
+            }
+        }
+
+        double start = wall_clock_seconds();
+        for (int run = 0; run < repetitions; run++) {
+            kernels->axpy(target, source, (run & 1) ? 1e-7f : -1e-7f, length);
+        }
+        double elapsed = wall_clock_seconds() - start;
+        if (isa == SIMD_SCALAR) {
+            scalar_time = elapsed;
+        }
+
+        double elements = (double)repetitions * length;
+        printf("AXPY   %6d  %-8s  %8.3f GFLOP/s  %8.2f GB/s  %6.2fx  max diff %.2e\n",
+               length, kernels->name, 2.0 * elements / elapsed / 1.0e9, 12.0 * elements / elapsed / 1.0e9, scalar_time / elapsed, max_difference);
+    }
+
+    free(source);
+    free(target);
+    free(reference);
+    free(initial);
+}
+
+static void benchmark_argmax(int size, int strided) {
+    float* matrix = malloc((size_t)size * size * sizeof(float));
+    if (matrix == NULL) {
+        return;
+    }
+
+    fill_random(matrix, size * size);
+
+    int repetitions = MIN_ELEMENTS_PER_SIZE / 10 / size;
+    double scalar_time = 0.0;
+    int stride = strided ? size : 1;
+    int reference = get_simd_kernels(SIMD_SCALAR)->argmax_abs(matrix, stride, size);
+
+    for (int isa = SIMD_SCALAR; isa < SIMD_ISA_COUNT; isa++) {
+        const simd_kernels* kernels = get_simd_kernels((simd_isa)isa);
+        if (kernels == NULL) {
+            printf("ARGMAX %6d  %-8s  not supported\n", size, isa == SIMD_SSE ? "SSE2" : isa == SIMD_AVX2 ? "AVX2" : "AVX-512");
+            continue;
+        }
+
+        int result = kernels->argmax_abs(matrix, stride, size);
+        int checksum = 0;
+
+        double start = wall_clock_seconds();
+        for (int run = 0; run < repetitions; run++) {
+            int offset = strided ? run % size : (run % size) * size;
+            checksum += kernels->argmax_abs(matrix + offset, stride, size);
+        }
+        double elapsed = wall_clock_seconds() - start;
+        if (isa == SIMD_SCALAR) {
+            scalar_time = elapsed;
+        }
+
+        double elements = (double)repetitions * size;
+        printf("ARGMAX %6d  %-8s  %8.3f Gelem/s  %6.2fx  %s (checksum %d)\n",
+               size, kernels->name, elements / elapsed / 1.0e9, scalar_time / elapsed, result == reference ? "matches scalar" : "MISMATCH", checksum);
+    }
+
+    free(matrix);
+}
+
+int main() {
+    srand(42);
+
+    printf("Selected ISA: %s\n\n", select_simd_kernels()->name);
+
+    printf("AXPY (target -= factor * source), contiguous\n");
+    for (size_t i = 0; i < sizeof(axpy_lengths) / sizeof(axpy_lengths[0]); i++) {
+        benchmark_axpy(axpy_lengths[i]);
+    }
+
+    printf("\nARGMAX |x| down a column of a row-major NxN matrix\n");
+    for (size_t i = 0; i < sizeof(argmax_sizes) / sizeof(argmax_sizes[0]); i++) {
+        benchmark_argmax(argmax_sizes[i], 1);
+    }
+
+    printf("\nARGMAX |x| along a row of a row-major NxN matrix\n");
+    for (size_t i = 0; i < sizeof(argmax_sizes) / sizeof(argmax_sizes[0]); i++) {
+        benchmark_argmax(argmax_sizes[i], 0);
+    }
+
+    return 0;
+}
@@ -0,0 +1,277 @@
+#include "cpu_solver.h"
+#include "simd_kernels.h"
+#include "scaled_product.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <unistd.h>
+#endif
+
+typedef struct {
+    float* matrix;
+    int size;
+    int thread_count;
+    const simd_kernels* kernels;
+    int sign;
+    int singular;
+    pthread_barrier_t barrier;
+} blocked_lu_state;
+
+typedef struct {
+    blocked_lu_state* state;
+    int thread_index;
+} blocked_lu_worker;
+
+int cpu_thread_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+#endif
+}
+
+double wall_clock_seconds(void) {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1.0e9;
+#endif
+}
+
+static void factorize_panel(blocked_lu_state* state, int block_offset, int block_width) {
+    float* matrix = state->matrix;
+    int size = state->size;
+
+    for (int pivot_index = block_offset; pivot_index < block_offset + block_width; pivot_index++) {
+        int max_row = pivot_index + state->kernels->argmax_abs(matrix + pivot_index * size + pivot_index, size, size - pivot_index);
+        float max_value = fabs(matrix[max_row * size + pivot_index]);
+
+        if (max_value < 1e-12) {
+            state->singular = 1;
+            return;
+        }
+
+        if (max_row != pivot_index) {
+            float* pivot_row = matrix + pivot_index * size;
+            float* other_row = matrix + max_row * size;
+            for (int col = 0; col < size; col++) {
+                float temp = pivot_row[col];
+                pivot_row[col] = other_row[col];
+                other_row[col] = temp;
+            }
+            state->sign = -state->sign;
+        }
+
+        float pivot = matrix[pivot_index * size + pivot_index];
+        int panel_end = block_offset + block_width;
+
+        for (int row = pivot_index + 1; row < size; row++) {
+            float factor = matrix[row * size + pivot_index] / pivot;
+            matrix[row * size + pivot_index] = factor;
+            state->kernels->axpy(matrix + row * size + pivot_index + 1, matrix + pivot_index * size + pivot_index + 1, factor, panel_end - pivot_index - 1);
+        }
+    }
+}
+
+static void solve_upper_panel(blocked_lu_state* state, int block_offset, int block_width, int col_start, int col_end) {
+    float* matrix = state->matrix;
+    int size = state->size;
+
+    for (int pivot_index = block_offset; pivot_index < block_offset + block_width; pivot_index++) {
+        for (int row = pivot_index + 1; row < block_offset + block_width; row++) {
+            float factor = matrix[row * size + pivot_index];
+            state->kernels->axpy(matrix + row * size + col_start, matrix + pivot_index * size + col_start, factor, col_end - col_start);
+        }
+    }
+}
+
+static void update_trailing_rows(blocked_lu_state* state, int block_offset, int block_width, int row_start, int row_end) {
+    float* matrix = state->matrix;
+    int size = state->size;
+    int trailing_start = block_offset + block_width;
+
+    for (int col_start = trailing_start; col_start < size; col_start += CPU_COLUMN_TILE) {
+        int col_end = col_start + CPU_COLUMN_TILE < size ? col_start + CPU_COLUMN_TILE : size;
+
+        for (int row = row_start; row < row_end; row++) {
+            float* target = matrix + row * size + col_start;
+            const float* factors = matrix + row * size;
+            int inner = block_offset;
+
+            for (; inner + 4 <= trailing_start; inner += 4) {
+                const float* sources[4] = {
+                    matrix + inner * size + col_start, matrix + (inner + 1) * size + col_start,
+                    matrix + (inner + 2) * size + col_start, matrix + (inner + 3) * size + col_start
+                };
+                state->kernels->axpy4(target, sources, factors + inner, col_end - col_start);
+            }
+            for (; inner < trailing_start; inner++) {
+                state->kernels->axpy(target, matrix + inner * size + col_start, factors[inner], col_end - col_start);
+            }
+        }
+    }
+}
+
+static void split_range(int start, int end, int part, int part_count, int* out_start, int* out_end) {
+    int length = end - start;
+    *out_start = start + (int)((long long)length * part / part_count);
+    *out_end = start + (int)((long long)length * (part + 1) / part_count);
+}
+
+static void* blocked_lu_thread(void* argument) {
+    blocked_lu_worker* worker = (blocked_lu_worker*)argument;
+    blocked_lu_state* state = worker->state;
+    int size = state->size;
+
+    for (int block_offset = 0; block_offset < size; block_offset += CPU_BLOCK_SIZE) {
+        int block_width = size - block_offset < CPU_BLOCK_SIZE ? size - block_offset : CPU_BLOCK_SIZE;
+        int trailing_start = block_offset + block_width;
+
+        if (worker->thread_index == 0) {
+            factorize_panel(state, block_offset, block_width);
+        }
+        pthread_barrier_wait(&state->barrier);
+
+        if (state->singular || trailing_start >= size) {
+            break;
+        }
+
+        int part_start, part_end;
+        split_range(trailing_start, size, worker->thread_index, state->thread_count, &part_start, &part_end);
+        if (part_start < part_end) {
+            solve_upper_panel(state, block_offset, block_width, part_start, part_end);
+        }
+        pthread_barrier_wait(&state->barrier);
+
+        if (part_start < part_end) {
+            update_trailing_rows(state, block_offset, block_width, part_start, part_end);
+        }
+        pthread_barrier_wait(&state->barrier);
+    }
+
+    return NULL;
+}
+
+void calculate_determinant_blocked(float* matrix, int size, int thread_count, float* out_mantissa, long long* out_exponent, int* out_sign) {
+    if (thread_count <= 0) {
+        thread_count = cpu_thread_count();
+    }
+    if (thread_count > size) {
+        thread_count = size > 0 ? size : 1;
+    }
+
+    blocked_lu_state state;
+    state.matrix = matrix;
+    state.size = size;
+    state.thread_count = thread_count;
+    state.kernels = select_simd_kernels();
+    state.sign = 1;
+    state.singular = 0;
+    pthread_barrier_init(&state.barrier, NULL, thread_count);
+
+    pthread_t* threads = (pthread_t*)malloc(thread_count * sizeof(pthread_t));
+    blocked_lu_worker* workers = (blocked_lu_worker*)malloc(thread_count * sizeof(blocked_lu_worker));
+
+    for (int i = 0; i < thread_count; i++) {
+        workers[i].state = &state;
+        workers[i].thread_index = i;
+        if (i > 0) {
+            pthread_create(&threads[i], NULL, blocked_lu_thread, &workers[i]);
+        }
+    }
+    blocked_lu_thread(&workers[0]);
+    for (int i = 1; i < thread_count; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    pthread_barrier_destroy(&state.barrier);
+    free(threads);
+    free(workers);
+
+    if (state.singular) {
+        *out_mantissa = 0.0;
+        *out_exponent = 0;
+        *out_sign = 1;
+        return;
+    }
+
+    scaled_product product;
+    scaled_product_init(&product);
+    scaled_product_multiply_diagonal(&product, matrix, size);
+    scaled_product_to_decimal(&product, out_mantissa, out_exponent, out_sign);
+    *out_sign *= state.sign;
+}
+
+void generate_matrix(float* matrix, int size) {
+    srand(42);
+
+    for (size_t i = 0; i < (size_t)size * size; i++) {
+        matrix[i] = (float)(rand() % 10); 
+    }
+}
+
+void print_matrix(float* matrix, int size) {
+    for (int i = 0; i < size; i++) {
+        for (int j = 0; j < size; j++) {
+            printf("%.2f ", matrix[i * size + j]);
+        }
+        printf("\n");
+    }
+}
+
+void calculate_determinant_gauss(float* matrix, int size, float* out_mantissa, long long* out_exponent, int* out_sign) {
+    int sign = 1;
+    const simd_kernels* kernels = select_simd_kernels();
+
+    for (int k = 0; k < size - 1; k++) {
+        int max_row = k + kernels->argmax_abs(matrix + k * size + k, size, size - k);
+        float max_value = fabs(matrix[max_row * size + k]);
+
+        if (max_value < 1e-12) {
+            *out_mantissa = 0.0;
+            *out_exponent = 0;
+            *out_sign = 1;
+            return;
+        }
+
+        if (max_row != k) {
+            for (int j = 0; j < size; j++) {
+                float temp = matrix[k * size + j];
+                matrix[k * size + j] = matrix[max_row * size + j];
+                matrix[max_row * size + j] = temp;
+            }
+            sign = -sign;
+        }
+
+        float pivot = matrix[k * size + k];
+    
+        for (int i = k + 1; i < size; i++) {
+            float factor = matrix[i * size + k] / pivot;
+            
+            kernels->axpy(matrix + i * size + k + 1, matrix + k * size + k + 1, factor, size - k - 1);
+            
+            matrix[i * size + k] = 0.0f;
+        }
+    }
+
+    scaled_product product;
+    scaled_product_init(&product);
+    scaled_product_multiply_diagonal(&product, matrix, size);
+    scaled_product_to_decimal(&product, out_mantissa, out_exponent, out_sign);
+    *out_sign *= sign;
+}
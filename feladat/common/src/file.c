@@ -0,0 +1,71 @@
+#include "file.h"
+
+#include <stdio.h>
+#include <string.h>
+
+void write_benchmark_to_file(const char* file_name, int matrix_size, double exec_time) {
+    FILE* file = fopen(file_name, "a");
+    if (!file) {
+        printf("Failed to open file: %s\n", file_name);
+        return;
+    }
+
+    fprintf(file, "%dx%d, %.6f\n", matrix_size, matrix_size, exec_time);
+    
+    fclose(file);
+}
+
+int read_tuned_block_size(const char* file_name, const char* device_name) {
+    FILE* file = fopen(file_name, "r");
+    if (!file) {
+        return 0;
+    }
+
+    char line[512];
+    char name[256];
+    int matrix_size, block_size;
+    double exec_time;
+    int result = 0;
+
+    while (fgets(line, sizeof(line), file)) {
+        if (sscanf(line, "%d %d %lf %255[^\n]", &matrix_size, &block_size, &exec_time, name) == 4 && strcmp(name, device_name) == 0) {
+            result = block_size;
+        }
+    }
+
+    fclose(file);
+    return result;
+}
+
+void write_tuned_block_size(const char* file_name, const char* device_name, int matrix_size, int block_size, double exec_time) {
+    char kept[64][512];
+    int kept_count = 0;
+
+    FILE* file = fopen(file_name, "r");
+    if (file) {
+        char line[512];
+        char name[256];
+        int old_size, old_block_size;
+        double old_time;
+
+        while (fgets(line, sizeof(line), file) && kept_count < 64) {
+            if (sscanf(line, "%d %d %lf %255[^\n]", &old_size, &old_block_size, &old_time, name) == 4 && strcmp(name, device_name) != 0) {
+                strcpy(kept[kept_count++], line);
+            }
+        }
+        fclose(file);
+    }
+
+    file = fopen(file_name, "w");
+    if (!file) {
+        printf("Failed to open file: %s\n", file_name);
+        return;
+    }
+
+    for (int i = 0; i < kept_count; i++) {
+        fputs(kept[i], file);
+    }
+    fprintf(file, "%d %d %.6f %s\n", matrix_size, block_size, exec_time, device_name);
+
+    fclose(file);
+}
@@ -0,0 +1,259 @@
+#define CL_TARGET_OPENCL_VERSION 220
+
+#include "kernel_loader.h"
+
+#include <CL/cl.h>
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #include <direct.h>
+    #include <process.h>
+    #define mkdir(path, mode) _mkdir(path)
+    #define getpid _getpid
+#else
+    #include <sys/stat.h>
+    #include <sys/types.h>
+    #include <unistd.h>
+#endif
+
+#define BINARY_CACHE_MAGIC "CLBINCACHE1"
+
+char* load_kernel_source(const char* const path, int* error_code) {
+    FILE* source_file;
+    char* source_code;
+    int file_size;
+
+    source_file = fopen(path, "rb");
+    if (source_file == NULL) {
+        *error_code = -1;
+        return NULL;
+    }
+
+    fseek(source_file, 0, SEEK_END);
+    file_size = ftell(source_file);
+    rewind(source_file);
+    source_code = (char*)malloc(file_size + 1);
+    fread(source_code, sizeof(char), file_size, source_file);
+    source_code[file_size] = 0;
+    fclose(source_file);
+
+    *error_code = 0;
+    return source_code;
+}
+
+static unsigned long long hash_bytes(unsigned long long hash, const void* data, size_t length) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+unsigned long long hash_kernel_source(const char* source) {
+    return hash_bytes(14695981039346656037ULL, source, strlen(source));
+}
+
+static char* get_device_string(cl_device_id device_id, cl_device_info param_name) {
+    size_t length = 0;
+    clGetDeviceInfo(device_id, param_name, 0, NULL, &length);
+
+    char* value = (char*)malloc(length + 1);
+    if (value == NULL) {
+        return NULL;
+    }
+    clGetDeviceInfo(device_id, param_name, length, value, NULL);
+    value[length] = 0;
+    return value;
+}
+
+static void write_cache_string(FILE* file, const char* value) {
+    unsigned int length = (unsigned int)strlen(value);
+    fwrite(&length, sizeof(length), 1, file);
+    fwrite(value, 1, length, file);
+}
+
+static int read_cache_string_matches(FILE* file, const char* expected) {
+    unsigned int length;
+    if (fread(&length, sizeof(length), 1, file) != 1 || length != strlen(expected)) {
+        return 0;
+    }
+
+    char* value = (char*)malloc(length + 1);
+    if (value == NULL) {
+        return 0;
+    }
+    int matches = fread(value, 1, length, file) == length && memcmp(value, expected, length) == 0;
+    free(value);
+    return matches;
+}
+
+static unsigned char* read_cached_binary(const char* path, const char* device_name, const char* driver_version, const char* options, unsigned long long source_hash, size_t* out_size) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+
+    char magic[sizeof(BINARY_CACHE_MAGIC)];
+    unsigned long long cached_hash;
+    unsigned long long binary_size;
+    unsigned char* binary = NULL;
+
+    if (fread(magic, 1, sizeof(magic), file) == sizeof(magic)
+        && memcmp(magic, BINARY_CACHE_MAGIC, sizeof(magic)) == 0
+        && fread(&cached_hash, sizeof(cached_hash), 1, file) == 1
+        && cached_hash == source_hash
+        && read_cache_string_matches(file, device_name)
+        && read_cache_string_matches(file, driver_version)
+        && read_cache_string_matches(file, options)
+        && fread(&binary_size, sizeof(binary_size), 1, file) == 1
+        && binary_size > 0) {
+        binary = (unsigned char*)malloc(binary_size);
+        if (binary != NULL && fread(binary, 1, binary_size, file) != binary_size) {
+            free(binary);
+            binary = NULL;
+        }
+        *out_size = (size_t)binary_size;
+    }
+
+    fclose(file);
+    return binary;
+}
+
+static void write_cached_binary(cl_program program, const char* cache_dir, const char* path, const char* device_name, const char* driver_version, const char* options, unsigned long long source_hash) {
+    size_t binary_size = 0;
+    if (clGetProgramInfo(program, CL_PROGRAM_BINARY_SIZES, sizeof(binary_size), &binary_size, NULL) != CL_SUCCESS || binary_size == 0) {
+        return;
+    }
+
+    unsigned char* binary = (unsigned char*)malloc(binary_size);
+    if (binary == NULL) {
+        return;
+    }
+    if (clGetProgramInfo(program, CL_PROGRAM_BINARIES, sizeof(binary), &binary, NULL) != CL_SUCCESS) {
+        free(binary);
+        return;
+    }
+
+    mkdir(cache_dir, 0777);
+
+    char temp_path[1024];
+    snprintf(temp_path, sizeof(temp_path), "%s.%d.tmp", path, (int)getpid());
+
+    FILE* file = fopen(temp_path, "wb");
+    if (file == NULL) {
+        free(binary);
+        return;
+    }
+
+    unsigned long long size_field = binary_size;
+    fwrite(BINARY_CACHE_MAGIC, 1, sizeof(BINARY_CACHE_MAGIC), file);
+    fwrite(&source_hash, sizeof(source_hash), 1, file);
+    write_cache_string(file, device_name);
+    write_cache_string(file, driver_version);
+    write_cache_string(file, options);
+    fwrite(&size_field, sizeof(size_field), 1, file);
+    int written = fwrite(binary, 1, binary_size, file) == binary_size;
+    fclose(file);
+    free(binary);
+
+    if (written) {
+#ifdef _WIN32
+        remove(path);
+#endif
+        if (rename(temp_path, path) != 0) {
+            remove(temp_path);
+        }
+    } else {
+        remove(temp_path);
+    }
+}
+
+static void print_build_log(cl_program program, cl_device_id device_id) {
+    size_t log_size = 0;
+    clGetProgramBuildInfo(program, device_id, CL_PROGRAM_BUILD_LOG, 0, NULL, &log_size);
+
+    char* log = (char*)malloc(log_size + 1);
+    if (log == NULL) {
+        return;
+    }
+    clGetProgramBuildInfo(program, device_id, CL_PROGRAM_BUILD_LOG, log_size, log, NULL);
+    log[log_size] = 0;
+    printf("Kernel build failed:\n%s\n", log);
+    free(log);
+}
+
+cl_program build_program_cached(cl_context context, cl_device_id device_id, const char* source, const char* options, const char* cache_dir, int* out_from_cache, int* error_code) {
+    cl_int err;
+    cl_program program;
+
+    if (options == NULL) {
+        options = "";
+    }
+    *out_from_cache = 0;
+
+    char* device_name = get_device_string(device_id, CL_DEVICE_NAME);
+    char* driver_version = get_device_string(device_id, CL_DRIVER_VERSION);
+    unsigned long long source_hash = hash_kernel_source(source);
+
+    char path[1024] = {0};
+    if (cache_dir != NULL && device_name != NULL && driver_version != NULL) {
+        unsigned long long key = source_hash;
+        key = hash_bytes(key, device_name, strlen(device_name) + 1);
+        key = hash_bytes(key, driver_version, strlen(driver_version) + 1);
+        key = hash_bytes(key, options, strlen(options) + 1);
+        snprintf(path, sizeof(path), "%s/%016llx.bin", cache_dir, key);
+
+        size_t binary_size = 0;
+        unsigned char* binary = read_cached_binary(path, device_name, driver_version, options, source_hash, &binary_size);
+        if (binary != NULL) {
+            cl_int binary_status;
+            program = clCreateProgramWithBinary(context, 1, &device_id, &binary_size, (const unsigned char**)&binary, &binary_status, &err);
+            free(binary);
+
+            if (err == CL_SUCCESS && binary_status == CL_SUCCESS) {
+                if (clBuildProgram(program, 1, &device_id, options, NULL, NULL) == CL_SUCCESS) {
+                    free(device_name);
+                    free(driver_version);
+                    *out_from_cache = 1;
+                    *error_code = 0;
+                    return program;
+                }
+            }
+            if (err == CL_SUCCESS) {
+                clReleaseProgram(program);
+            }
+        }
+    }
+
+    program = clCreateProgramWithSource(context, 1, &source, NULL, &err);
+    if (err != CL_SUCCESS) {
+        free(device_name);
+        free(driver_version);
+        *error_code = err;
+        return NULL;
+    }
+
+    err = clBuildProgram(program, 1, &device_id, options, NULL, NULL);
+    if (err != CL_SUCCESS) {
+        print_build_log(program, device_id);
+        clReleaseProgram(program);
+        free(device_name);
+        free(driver_version);
+        *error_code = err;
+        return NULL;
+    }
+
+    if (path[0] != 0) {
+        write_cached_binary(program, cache_dir, path, device_name, driver_version, options, source_hash);
+    }
+
+    free(device_name);
+    free(driver_version);
+    *error_code = 0;
+    return program;
+}
@@ -0,0 +1,267 @@
+#include "matrix_file.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#define CHECKSUM_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define CHECKSUM_PRIME 0x100000001b3ULL
+#define WRITER_BUFFER_SIZE (1 << 20)
+
+size_t matrix_element_size(matrix_element_type element_type) {
+    switch (element_type) {
+        case MATRIX_ELEMENT_FLOAT32: return sizeof(float);
+        case MATRIX_ELEMENT_FLOAT64: return sizeof(double);
+        default: return 0;
+    }
+}
+
+uint64_t matrix_file_checksum_update(uint64_t checksum, const void* data, size_t bytes) {
+    const unsigned char* bytes_in = (const unsigned char*)data;
+    size_t word_count = bytes / sizeof(uint32_t);
+
+    for (size_t i = 0; i < word_count; i++) {
+        uint32_t word;
+        memcpy(&word, bytes_in + i * sizeof(uint32_t), sizeof(word));
+        checksum = (checksum ^ word) * CHECKSUM_PRIME;
+    }
+
+    return checksum;
+}
+
+static int validate_header(const matrix_file_header* header, size_t file_size) {
+    if (memcmp(header->magic, MATRIX_FILE_MAGIC, sizeof(header->magic)) != 0 || header->version != MATRIX_FILE_VERSION) {
+        return MATRIX_FILE_ERROR_FORMAT;
+    }
+
+    size_t element_size = matrix_element_size((matrix_element_type)header->element_type);
+    if (element_size == 0 || header->header_size < MATRIX_FILE_HEADER_SIZE || header->header_size % MATRIX_FILE_HEADER_SIZE != 0 || header->rows == 0 || header->cols == 0 ||
+        (header->layout != MATRIX_LAYOUT_ROW_MAJOR && header->layout != MATRIX_LAYOUT_COLUMN_MAJOR)) {
+        return MATRIX_FILE_ERROR_FORMAT;
+    }
+
+    if (header->rows > SIZE_MAX / header->cols / element_size) {
+        return MATRIX_FILE_ERROR_SIZE;
+    }
+
+    size_t payload = (size_t)(header->rows * header->cols) * element_size;
+    if (header->header_size > file_size || payload > file_size - header->header_size) {
+        return MATRIX_FILE_ERROR_SIZE;
+    }
+
+    return 0;
+}
+
+void matrix_file_open(const char* path, matrix_file* file, int* error_code) {
+    memset(file, 0, sizeof(*file));
+
+#ifdef _WIN32
+    HANDLE file_handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file_handle == INVALID_HANDLE_VALUE) {
+        *error_code = MATRIX_FILE_ERROR_IO;
+        return;
+    }
+
+    LARGE_INTEGER file_size;
+    HANDLE mapping_handle = NULL;
+    void* mapping = NULL;
+    if (GetFileSizeEx(file_handle, &file_size) && file_size.QuadPart >= MATRIX_FILE_HEADER_SIZE) {
+        mapping_handle = CreateFileMappingA(file_handle, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    }
+    if (mapping_handle != NULL) {
+        mapping = MapViewOfFile(mapping_handle, FILE_MAP_COPY, 0, 0, 0);
+    }
+    if (mapping == NULL) {
+        if (mapping_handle != NULL) CloseHandle(mapping_handle);
+        CloseHandle(file_handle);
+        *error_code = MATRIX_FILE_ERROR_IO;
+        return;
+    }
+
+    file->file_handle = file_handle;
+    file->mapping_handle = mapping_handle;
+    file->mapping_size = (size_t)file_size.QuadPart;
+#else
+    int descriptor = open(path, O_RDONLY);
+    if (descriptor < 0) {
+        *error_code = MATRIX_FILE_ERROR_IO;
+        return;
+    }
+
+    struct stat file_status;
+    void* mapping = MAP_FAILED;
+    if (fstat(descriptor, &file_status) == 0 && file_status.st_size >= MATRIX_FILE_HEADER_SIZE) {
+        mapping = mmap(NULL, (size_t)file_status.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, descriptor, 0);
+    }
+    close(descriptor);
+
+    if (mapping == MAP_FAILED) {
+        *error_code = MATRIX_FILE_ERROR_IO;
+        return;
+    }
+
+    posix_madvise(mapping, (size_t)file_status.st_size, POSIX_MADV_SEQUENTIAL);
+    file->mapping_size = (size_t)file_status.st_size;
+#endif
+
+    file->mapping = mapping;
+    memcpy(&file->header, mapping, sizeof(file->header));
+
+    *error_code = validate_header(&file->header, file->mapping_size);
+    if (*error_code != 0) {
+        matrix_file_close(file);
+        return;
+    }
+
+    file->elements = (char*)mapping + file->header.header_size;
+}
+
+int matrix_file_verify(const matrix_file* file) {
+    if (!(file->header.flags & MATRIX_FILE_HAS_CHECKSUM)) {
+        return 0;
+    }
+
+    size_t payload = (size_t)(file->header.rows * file->header.cols) * matrix_element_size((matrix_element_type)file->header.element_type);
+    uint64_t checksum = matrix_file_checksum_update(CHECKSUM_OFFSET_BASIS, file->elements, payload);
+    return checksum == file->header.checksum ? 0 : MATRIX_FILE_ERROR_CHECKSUM;
+}
+
+float* matrix_file_floats(matrix_file* file, int* error_code) {
+    *error_code = 0;
+
+    if (file->header.element_type == MATRIX_ELEMENT_FLOAT32) {
+        return (float*)file->elements;
+    }
+
+    if (file->converted == NULL) {
+        size_t count = (size_t)(file->header.rows * file->header.cols);
+        file->converted = (float*)malloc(count * sizeof(float));
+        if (file->converted == NULL) {
+            *error_code = MATRIX_FILE_ERROR_SIZE;
+            return NULL;
+        }
+
+        const double* source = (const double*)file->elements;
+        for (size_t i = 0; i < count; i++) {
+            file->converted[i] = (float)source[i];
+        }
+    }
+
+    return file->converted;
+}
+
+void matrix_file_close(matrix_file* file) {
+    free(file->converted);
+
+#ifdef _WIN32
+    if (file->mapping != NULL) UnmapViewOfFile(file->mapping);
+    if (file->mapping_handle != NULL) CloseHandle((HANDLE)file->mapping_handle);
+    if (file->file_handle != NULL) CloseHandle((HANDLE)file->file_handle);
+#else
+    if (file->mapping != NULL) munmap(file->mapping, file->mapping_size);
+#endif
+
+    memset(file, 0, sizeof(*file));
+}
+
+void matrix_file_writer_open(matrix_file_writer* writer, const char* path, uint64_t rows, uint64_t cols, matrix_element_type element_type, matrix_layout layout, uint32_t flags, int* error_code) {
+    memset(writer, 0, sizeof(*writer));
+
+    if (matrix_element_size(element_type) == 0 || rows == 0 || cols == 0) {
+        *error_code = MATRIX_FILE_ERROR_FORMAT;
+        return;
+    }
+
+    writer->file = fopen(path, "wb");
+    if (writer->file == NULL) {
+        *error_code = MATRIX_FILE_ERROR_IO;
+        return;
+    }
+    setvbuf(writer->file, NULL, _IOFBF, WRITER_BUFFER_SIZE);
+
+    memcpy(writer->header.magic, MATRIX_FILE_MAGIC, sizeof(writer->header.magic));
+    writer->header.version = MATRIX_FILE_VERSION;
+    writer->header.header_size = MATRIX_FILE_HEADER_SIZE;
+    writer->header.rows = rows;
+    writer->header.cols = cols;
+    writer->header.element_type = element_type;
+    writer->header.layout = layout;
+    writer->header.flags = flags;
+    writer->checksum = CHECKSUM_OFFSET_BASIS;
+
+    if (fwrite(&writer->header, sizeof(writer->header), 1, writer->file) != 1) {
+        fclose(writer->file);
+        writer->file = NULL;
+        *error_code = MATRIX_FILE_ERROR_IO;
+        return;
+    }
+
+    *error_code = 0;
+}
+
+void matrix_file_writer_write(matrix_file_writer* writer, const void* elements, size_t count, int* error_code) {
+    size_t element_size = matrix_element_size((matrix_element_type)writer->header.element_type);
+
+    if (writer->file == NULL || writer->written + count > writer->header.rows * writer->header.cols) {
+        *error_code = MATRIX_FILE_ERROR_SIZE;
+        return;
+    }
+
+    if (fwrite(elements, element_size, count, writer->file) != count) {
+        *error_code = MATRIX_FILE_ERROR_IO;
+        return;
+    }
+
+    if (writer->header.flags & MATRIX_FILE_HAS_CHECKSUM) {
+        writer->checksum = matrix_file_checksum_update(writer->checksum, elements, count * element_size);
+    }
+    writer->written += count;
+    *error_code = 0;
+}
+
+void matrix_file_writer_close(matrix_file_writer* writer, int* error_code) {
+    if (writer->file == NULL) {
+        *error_code = MATRIX_FILE_ERROR_IO;
+        return;
+    }
+
+    *error_code = writer->written == writer->header.rows * writer->header.cols ? 0 : MATRIX_FILE_ERROR_SIZE;
+
+    if (writer->header.flags & MATRIX_FILE_HAS_CHECKSUM) {
+        writer->header.checksum = writer->checksum;
+    }
+
+    if (fseek(writer->file, 0, SEEK_SET) != 0 || fwrite(&writer->header, sizeof(writer->header), 1, writer->file) != 1) {
+        *error_code = MATRIX_FILE_ERROR_IO;
+    }
+    if (fclose(writer->file) != 0 && *error_code == 0) {
+        *error_code = MATRIX_FILE_ERROR_IO;
+    }
+    writer->file = NULL;
+}
+
+void write_matrix_file(const char* path, const float* matrix, int size, int* error_code) {
+    matrix_file_writer writer;
+    matrix_file_writer_open(&writer, path, size, size, MATRIX_ELEMENT_FLOAT32, MATRIX_LAYOUT_ROW_MAJOR, MATRIX_FILE_HAS_CHECKSUM, error_code);
+    if (*error_code != 0) {
+        return;
+    }
+
+    for (int row = 0; row < size && *error_code == 0; row++) {
+        matrix_file_writer_write(&writer, matrix + (size_t)row * size, size, error_code);
+    }
+
+    int close_error;
+    matrix_file_writer_close(&writer, &close_error);
+    if (*error_code == 0) {
+        *error_code = close_error;
+    }
+}
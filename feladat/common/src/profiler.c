@@ -0,0 +1,281 @@
+#define CL_TARGET_OPENCL_VERSION 220
+
+#include "profiler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    const char* key;
+    int count;
+    double time;
+    double bytes;
+} profile_group;
+
+profiler* create_profiler(void) {
+    return (profiler*)calloc(1, sizeof(profiler));
+}
+
+void profiler_reset(profiler* profiler) {
+    profiler->count = 0;
+}
+
+void release_profiler(profiler* profiler) {
+    if (profiler == NULL) return;
+
+    free(profiler->records);
+    free(profiler);
+}
+
+static profile_record* append_record(profiler* profiler) {
+    if (profiler->count == profiler->capacity) {
+        int capacity = profiler->capacity > 0 ? 2 * profiler->capacity : 256;
+        profile_record* records = (profile_record*)realloc(profiler->records, capacity * sizeof(profile_record));
+        if (records == NULL) {
+            return NULL;
+        }
+        profiler->records = records;
+        profiler->capacity = capacity;
+    }
+    return &profiler->records[profiler->count++];
+}
+
+float record_event_times(profiler* profiler, cl_event* events, int count, const char* name, const char* phase, double bytes) {
+    float total = 0.0f;
+
+    for (int i = 0; i < count; i++) {
+        cl_ulong queued = 0, submit = 0, start = 0, end = 0;
+        clGetEventProfilingInfo(events[i], CL_PROFILING_COMMAND_START, sizeof(start), &start, NULL);
+        clGetEventProfilingInfo(events[i], CL_PROFILING_COMMAND_END, sizeof(end), &end, NULL);
+        total += (float)(end - start) / 1.0e9;
+
+        profile_record* record = profiler != NULL ? append_record(profiler) : NULL;
+        if (record != NULL) {
+            clGetEventProfilingInfo(events[i], CL_PROFILING_COMMAND_QUEUED, sizeof(queued), &queued, NULL);
+            clGetEventProfilingInfo(events[i], CL_PROFILING_COMMAND_SUBMIT, sizeof(submit), &submit, NULL);
+            snprintf(record->name, sizeof(record->name), "%s", name);
+            snprintf(record->phase, sizeof(record->phase), "%s", phase);
+            record->queued = queued;
+            record->submit = submit;
+            record->start = start;
+            record->end = end;
+            record->bytes = bytes / count;
+        }
+
+        clReleaseEvent(events[i]);
+    }
+
+    return total;
+}
+
+static int group_records(const profiler* profiler, int by_phase, profile_group* groups) {
+    int group_count = 0;
+
+    for (int i = 0; i < profiler->count; i++) {
+        const profile_record* record = &profiler->records[i];
+        const char* key = by_phase ? record->phase : record->name;
+
+        int group = 0;
+        while (group < group_count && strcmp(groups[group].key, key) != 0) {
+            group++;
+        }
+        if (group == group_count) {
+            if (group_count == PROFILER_MAX_GROUPS) continue;
+            groups[group_count].key = key;
+            groups[group_count].count = 0;
+            groups[group_count].time = 0.0;
+            groups[group_count].bytes = 0.0;
+            group_count++;
+        }
+
+        groups[group].count++;
+        groups[group].time += (double)(record->end - record->start) / 1.0e9;
+        groups[group].bytes += record->bytes;
+    }
+
+    return group_count;
+}
+
+static cl_ulong profile_origin(const profiler* profiler) {
+    cl_ulong origin = 0;
+    for (int i = 0; i < profiler->count; i++) {
+        if (i == 0 || profiler->records[i].queued < origin) {
+            origin = profiler->records[i].queued;
+        }
+    }
+    return origin;
+}
+
+static const char* device_string(cl_device_id device_id, cl_device_info param, char* buffer, size_t size) {
+    buffer[0] = '\0';
+    if (device_id != NULL) {
+        clGetDeviceInfo(device_id, param, size, buffer, NULL);
+    }
+    return buffer;
+}
+
+static void write_json_string(FILE* file, const char* text) {
+    fputc('"', file);
+    for (; text != NULL && *text != '\0'; text++) {
+        if (*text == '"' || *text == '\\') {
+            fprintf(file, "\\%c", *text);
+        } else if ((unsigned char)*text < 0x20) {
+            fprintf(file, "\\u%04x", (unsigned char)*text);
+        } else {
+            fputc(*text, file);
+        }
+    }
+    fputc('"', file);
+}
+
+int write_profile_json(const profiler* profiler, const profile_info* info, const char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        printf("Failed to open file: %s\n", path);
+        return -1;
+    }
+
+    char text[256];
+    cl_uint compute_units = 0, clock_frequency = 0;
+    cl_ulong global_memory = 0;
+    if (info->device_id != NULL) {
+        clGetDeviceInfo(info->device_id, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(compute_units), &compute_units, NULL);
+        clGetDeviceInfo(info->device_id, CL_DEVICE_MAX_CLOCK_FREQUENCY, sizeof(clock_frequency), &clock_frequency, NULL);
+        clGetDeviceInfo(info->device_id, CL_DEVICE_GLOBAL_MEM_SIZE, sizeof(global_memory), &global_memory, NULL);
+    }
+
+    double compute_time = 0.0, transfer_time = 0.0, transfer_bytes = 0.0;
+    for (int i = 0; i < profiler->count; i++) {
+        const profile_record* record = &profiler->records[i];
+        double duration = (double)(record->end - record->start) / 1.0e9;
+        if (record->bytes > 0.0) {
+            transfer_time += duration;
+            transfer_bytes += record->bytes;
+        } else {
+            compute_time += duration;
+        }
+    }
+
+    fprintf(file, "{\n  \"engine\": ");
+    write_json_string(file, info->engine);
+    fprintf(file, ",\n  \"device\": {\n    \"name\": ");
+    write_json_string(file, device_string(info->device_id, CL_DEVICE_NAME, text, sizeof(text)));
+    fprintf(file, ",\n    \"vendor\": ");
+    write_json_string(file, device_string(info->device_id, CL_DEVICE_VENDOR, text, sizeof(text)));
+    fprintf(file, ",\n    \"version\": ");
+    write_json_string(file, device_string(info->device_id, CL_DEVICE_VERSION, text, sizeof(text)));
+    fprintf(file, ",\n    \"driver_version\": ");
+    write_json_string(file, device_string(info->device_id, CL_DRIVER_VERSION, text, sizeof(text)));
+    fprintf(file, ",\n    \"compute_units\": %u,\n    \"max_clock_mhz\": %u,\n    \"global_memory_bytes\": %llu\n  },\n", compute_units, clock_frequency, (unsigned long long)global_memory);
+
+    fprintf(file, "  \"matrix_size\": %d,\n  \"block_size\": %d,\n  \"precision\": ", info->matrix_size, info->block_size);
+    write_json_string(file, info->precision);
+    fprintf(file, ",\n  \"wall_time_s\": %.9f,\n  \"device_time_s\": %.9f,\n  \"compute_time_s\": %.9f,\n  \"transfer_time_s\": %.9f,\n  \"transfer_bytes\": %.0f,\n",
+            info->wall_time, compute_time + transfer_time, compute_time, transfer_time, transfer_bytes);
+    fprintf(file, "  \"gflops\": %.3f,\n  \"effective_gflops\": %.3f,\n  \"bandwidth_gb_s\": %.3f,\n",
+            compute_time > 0.0 ? info->flops / compute_time / 1.0e9 : 0.0,
+            info->wall_time > 0.0 ? info->flops / info->wall_time / 1.0e9 : 0.0,
+            transfer_time > 0.0 ? transfer_bytes / transfer_time / 1.0e9 : 0.0);
+
+    profile_group groups[PROFILER_MAX_GROUPS];
+    int group_count = group_records(profiler, 1, groups);
+    fprintf(file, "  \"phases\": [");
+    for (int i = 0; i < group_count; i++) {
+        fprintf(file, "%s\n    {\"phase\": ", i > 0 ? "," : "");
+        write_json_string(file, groups[i].key);
+        fprintf(file, ", \"commands\": %d, \"time_s\": %.9f, \"bytes\": %.0f, \"bandwidth_gb_s\": %.3f}", groups[i].count, groups[i].time, groups[i].bytes,
+                groups[i].bytes > 0.0 && groups[i].time > 0.0 ? groups[i].bytes / groups[i].time / 1.0e9 : 0.0);
+    }
+
+    group_count = group_records(profiler, 0, groups);
+    fprintf(file, "\n  ],\n  \"kernels\": [");
+    for (int i = 0; i < group_count; i++) {
+        fprintf(file, "%s\n    {\"name\": ", i > 0 ? "," : "");
+        write_json_string(file, groups[i].key);
+        fprintf(file, ", \"commands\": %d, \"time_s\": %.9f}", groups[i].count, groups[i].time);
+    }
+
+    cl_ulong origin = profile_origin(profiler);
+    fprintf(file, "\n  ],\n  \"commands\": [");
+    for (int i = 0; i < profiler->count; i++) {
+        const profile_record* record = &profiler->records[i];
+        fprintf(file, "%s\n    {\"name\": ", i > 0 ? "," : "");
+        write_json_string(file, record->name);
+        fprintf(file, ", \"phase\": ");
+        write_json_string(file, record->phase);
+        fprintf(file, ", \"queued_ns\": %llu, \"submit_ns\": %llu, \"start_ns\": %llu, \"end_ns\": %llu, \"bytes\": %.0f}",
+                (unsigned long long)(record->queued - origin), (unsigned long long)(record->submit - origin),
+                (unsigned long long)(record->start - origin), (unsigned long long)(record->end - origin), record->bytes);
+    }
+    fprintf(file, "\n  ]\n}\n");
+
+    fclose(file);
+    return 0;
+}
+
+int write_profile_csv(const profiler* profiler, const profile_info* info, const char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        printf("Failed to open file: %s\n", path);
+        return -1;
+    }
+
+    char device_name[256];
+    device_string(info->device_id, CL_DEVICE_NAME, device_name, sizeof(device_name));
+    for (char* c = device_name; *c != '\0'; c++) {
+        if (*c == '"' || *c == ',') *c = ' ';
+    }
+
+    cl_ulong origin = profile_origin(profiler);
+    fprintf(file, "engine,device,matrix_size,block_size,precision,name,phase,queued_ns,submit_ns,start_ns,end_ns,duration_ns,bytes\n");
+    for (int i = 0; i < profiler->count; i++) {
+        const profile_record* record = &profiler->records[i];
+        fprintf(file, "%s,%s,%d,%d,%s,%s,%s,%llu,%llu,%llu,%llu,%llu,%.0f\n", info->engine, device_name, info->matrix_size, info->block_size, info->precision,
+                record->name, record->phase, (unsigned long long)(record->queued - origin), (unsigned long long)(record->submit - origin),
+                (unsigned long long)(record->start - origin), (unsigned long long)(record->end - origin),
+                (unsigned long long)(record->end - record->start), record->bytes);
+    }
+
+    fclose(file);
+    return 0;
+}
+
+int write_chrome_trace(const profiler* profiler, const char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        printf("Failed to open file: %s\n", path);
+        return -1;
+    }
+
+    profile_group phases[PROFILER_MAX_GROUPS];
+    int phase_count = group_records(profiler, 1, phases);
+    cl_ulong origin = profile_origin(profiler);
+
+    fprintf(file, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [");
+    for (int i = 0; i < phase_count; i++) {
+        fprintf(file, "%s\n  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": ", i > 0 ? "," : "", i + 1);
+        write_json_string(file, phases[i].key);
+        fprintf(file, "}}");
+    }
+
+    for (int i = 0; i < profiler->count; i++) {
+        const profile_record* record = &profiler->records[i];
+        int tid = 0;
+        while (tid < phase_count && strcmp(phases[tid].key, record->phase) != 0) {
+            tid++;
+        }
+
+        fprintf(file, "%s\n  {\"name\": ", phase_count > 0 || i > 0 ? "," : "");
+        write_json_string(file, record->name);
+        fprintf(file, ", \"cat\": ");
+        write_json_string(file, record->phase);
+        fprintf(file, ", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f, \"args\": {\"queued_us\": %.3f, \"submit_us\": %.3f}}",
+                tid + 1, (double)(record->start - origin) / 1.0e3, (double)(record->end - record->start) / 1.0e3,
+                (double)(record->queued - origin) / 1.0e3, (double)(record->submit - origin) / 1.0e3);
+    }
+    fprintf(file, "\n]}\n");
+
+    fclose(file);
+    return 0;
+}
@@ -0,0 +1,154 @@
+#include "scaled_product.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#define LOG10_2 0.301029995663981195213738894724493027L
+
+static float split_float(float value, int* exponent) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    *exponent = (int)((bits >> 23) & 0xff) - 127;
+    bits = (bits & 0x007fffff) | 0x3f800000;
+
+    float mantissa;
+    memcpy(&mantissa, &bits, sizeof(mantissa));
+    return mantissa;
+}
+
+static void renormalize(double* mantissa, long long* exponent) {
+    int binary_exponent;
+    *mantissa = frexp(*mantissa, &binary_exponent);
+    *exponent += binary_exponent;
+}
+
+void scaled_product_init(scaled_product* product) {
+    product->mantissa = 1.0;
+    product->exponent = 0;
+    product->sign = 1;
+    product->is_zero = 0;
+}
+
+void scaled_product_multiply(scaled_product* product, double value) {
+    if (product->is_zero) {
+        return;
+    }
+
+    if (fabs(value) < SCALED_PRODUCT_ZERO_THRESHOLD) {
+        product->is_zero = 1;
+        return;
+    }
+
+    if (value < 0) {
+        product->sign = -product->sign;
+        value = -value;
+    }
+
+    int binary_exponent;
+    product->mantissa *= frexp(value, &binary_exponent);
+    product->exponent += binary_exponent;
+    renormalize(&product->mantissa, &product->exponent);
+}
+
+void scaled_product_multiply_strided(scaled_product* product, const float* values, int count, int stride) {
+    if (product->is_zero) {
+        return;
+    }
+
+    double lane_mantissas[SCALED_PRODUCT_LANES];
+    long long lane_exponents[SCALED_PRODUCT_LANES];
+    for (int lane = 0; lane < SCALED_PRODUCT_LANES; lane++) {
+        lane_mantissas[lane] = 1.0;
+        lane_exponents[lane] = 0;
+    }
+
+    int negative_count = 0;
+    int zero_found = 0;
+    int vector_count = count - count % SCALED_PRODUCT_LANES;
+    int index = 0;
+
+    while (index < vector_count && !zero_found) {
+        int chunk_end = index + SCALED_PRODUCT_RENORMALIZE_INTERVAL * SCALED_PRODUCT_LANES;
+        if (chunk_end > vector_count) {
+            chunk_end = vector_count;
+        }
+
+        for (; index < chunk_end; index += SCALED_PRODUCT_LANES) {
+            for (int lane = 0; lane < SCALED_PRODUCT_LANES; lane++) {
+                float value = values[(size_t)(index + lane) * stride];
+                int binary_exponent;
+
+                zero_found |= fabsf(value) < SCALED_PRODUCT_ZERO_THRESHOLD;
+                negative_count += value < 0.0f;
+                lane_mantissas[lane] *= split_float(value, &binary_exponent);
+                lane_exponents[lane] += binary_exponent;
+            }
+        }
+
+        for (int lane = 0; lane < SCALED_PRODUCT_LANES; lane++) {
+            renormalize(&lane_mantissas[lane], &lane_exponents[lane]);
+        }
+    }
+
+    if (zero_found) {
+        product->is_zero = 1;
+        return;
+    }
+
+    for (int lane = 0; lane < SCALED_PRODUCT_LANES; lane++) {
+        product->mantissa *= lane_mantissas[lane];
+        product->exponent += lane_exponents[lane];
+        renormalize(&product->mantissa, &product->exponent);
+    }
+
+    if (negative_count % 2 != 0) {
+        product->sign = -product->sign;
+    }
+
+    for (; index < count; index++) {
+        scaled_product_multiply(product, values[(size_t)index * stride]);
+    }
+}
+
+void scaled_product_multiply_diagonal(scaled_product* product, const float* matrix, int size) {
+    scaled_product_multiply_strided(product, matrix, size, size + 1);
+}
+
+void scaled_product_to_decimal(const scaled_product* product, float* out_mantissa, long long* out_exponent, int* out_sign) {
+    if (product->is_zero) {
+        *out_mantissa = 0.0;
+        *out_exponent = 0;
+        *out_sign = 1;
+        return;
+    }
+
+    binary_to_decimal(product->mantissa, product->exponent, out_mantissa, out_exponent);
+    *out_sign = product->sign;
+}
+
+void binary_to_decimal(double mantissa, long long exponent, float* out_mantissa, long long* out_exponent) {
+    if (mantissa == 0.0) {
+        *out_mantissa = 0.0;
+        *out_exponent = 0;
+        return;
+    }
+
+    long double log10_value = log10l(fabsl((long double)mantissa)) + (long double)exponent * LOG10_2;
+    long double decimal_exponent = floorl(log10_value);
+    long double decimal_mantissa = powl(10.0L, log10_value - decimal_exponent);
+
+    if (decimal_mantissa >= 10.0L) {
+        decimal_mantissa /= 10.0L;
+        decimal_exponent += 1.0L;
+    }
+
+    *out_mantissa = (float)decimal_mantissa;
+    *out_exponent = (long long)decimal_exponent;
+
+    if (*out_mantissa >= 10.0f) {
+        *out_mantissa = 1.0f;
+        *out_exponent += 1;
+    }
+}
@@ -0,0 +1,345 @@
+#include "simd_kernels.h"
+
+#include <math.h>
+#include <stddef.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #define SIMD_X86 1
+    #include <cpuid.h>
+    #include <immintrin.h>
+#else
+    #define SIMD_X86 0
+#endif
+
+static void axpy_scalar(float* target, const float* source, float factor, int length) {
+    for (int i = 0; i < length; i++) {
+        target[i] -= factor * source[i];
+    }
+}
+
+static void axpy4_scalar(float* target, const float* const* sources, const float* factors, int length) {
+    for (int i = 0; i < length; i++) {
+        target[i] -= factors[0] * sources[0][i] + factors[1] * sources[1][i] + factors[2] * sources[2][i] + factors[3] * sources[3][i];
+    }
+}
+
+static int argmax_abs_scalar(const float* values, int stride, int length) {
+    int max_index = 0;
+    float max_value = length > 0 ? fabsf(values[0]) : 0.0f;
+
+    for (int i = 1; i < length; i++) {
+        float value = fabsf(values[(size_t)i * stride]);
+        if (value > max_value) {
+            max_value = value;
+            max_index = i;
+        }
+    }
+
+    return max_index;
+}
+
+static int finish_argmax(const float* lane_values, const int* lane_indices, int lane_count, const float* values, int stride, int start, int length) {
+    int max_index = lane_indices[0];
+    float max_value = lane_values[0];
+
+    for (int lane = 1; lane < lane_count; lane++) {
+        if (lane_values[lane] > max_value || (lane_values[lane] == max_value && lane_indices[lane] < max_index)) {
+            max_value = lane_values[lane];
+            max_index = lane_indices[lane];
+        }
+    }
+
+    for (int i = start; i < length; i++) {
+        float value = fabsf(values[(size_t)i * stride]);
+        if (value > max_value) {
+            max_value = value;
+            max_index = i;
+        }
+    }
+
+    return max_index;
+}
+
+#if SIMD_X86
+
+__attribute__((target("sse2")))
+static void axpy_sse(float* target, const float* source, float factor, int length) {
+    __m128 factor_vector = _mm_set1_ps(factor);
+    int i = 0;
+
+    for (; i + 4 <= length; i += 4) {
+        __m128 result = _mm_sub_ps(_mm_loadu_ps(target + i), _mm_mul_ps(factor_vector, _mm_loadu_ps(source + i)));
+        _mm_storeu_ps(target + i, result);
+    }
+    for (; i < length; i++) {
+        target[i] -= factor * source[i];
+    }
+}
+
+__attribute__((target("sse2")))
+static void axpy4_sse(float* target, const float* const* sources, const float* factors, int length) {
+    __m128 factor0 = _mm_set1_ps(factors[0]);
+    __m128 factor1 = _mm_set1_ps(factors[1]);
+    __m128 factor2 = _mm_set1_ps(factors[2]);
+    __m128 factor3 = _mm_set1_ps(factors[3]);
+    int i = 0;
+
+    for (; i + 4 <= length; i += 4) {
+        __m128 sum = _mm_mul_ps(factor0, _mm_loadu_ps(sources[0] + i));
+        sum = _mm_add_ps(sum, _mm_mul_ps(factor1, _mm_loadu_ps(sources[1] + i)));
+        sum = _mm_add_ps(sum, _mm_mul_ps(factor2, _mm_loadu_ps(sources[2] + i)));
+        sum = _mm_add_ps(sum, _mm_mul_ps(factor3, _mm_loadu_ps(sources[3] + i)));
+        _mm_storeu_ps(target + i, _mm_sub_ps(_mm_loadu_ps(target + i), sum));
+    }
+    for (; i < length; i++) {
+        target[i] -= factors[0] * sources[0][i] + factors[1] * sources[1][i] + factors[2] * sources[2][i] + factors[3] * sources[3][i];
+    }
+}
+
+__attribute__((target("sse2")))
+static int argmax_abs_sse(const float* values, int stride, int length) {
+    if (length < 8) {
+        return argmax_abs_scalar(values, stride, length);
+    }
+
+    __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 best_values = _mm_set1_ps(-1.0f);
+    __m128i best_indices = _mm_setzero_si128();
+    __m128i current_indices = _mm_setr_epi32(0, 1, 2, 3);
+    __m128i step = _mm_set1_epi32(4);
+    int i = 0;
+
+    for (; i + 4 <= length; i += 4) {
+        const float* base = values + (size_t)i * stride;
+        __m128 current = _mm_setr_ps(base[0], base[stride], base[2 * (size_t)stride], base[3 * (size_t)stride]);
+        current = _mm_and_ps(current, abs_mask);
+
+        __m128 greater = _mm_cmpgt_ps(current, best_values);
+        best_values = _mm_or_ps(_mm_and_ps(greater, current), _mm_andnot_ps(greater, best_values));
+        __m128i greater_indices = _mm_castps_si128(greater);
+        best_indices = _mm_or_si128(_mm_and_si128(greater_indices, current_indices), _mm_andnot_si128(greater_indices, best_indices));
+        current_indices = _mm_add_epi32(current_indices, step);
+    }
+
+    float lane_values[4];
+    int lane_indices[4];
+    _mm_storeu_ps(lane_values, best_values);
+    _mm_storeu_si128((__m128i*)lane_indices, best_indices);
+
+    return finish_argmax(lane_values, lane_indices, 4, values, stride, i, length);
+}
+
+__attribute__((target("avx2,fma")))
+static void axpy_avx2(float* target, const float* source, float factor, int length) {
+    __m256 factor_vector = _mm256_set1_ps(factor);
+    int i = 0;
+
+    for (; i + 8 <= length; i += 8) {
+        __m256 result = _mm256_fnmadd_ps(factor_vector, _mm256_loadu_ps(source + i), _mm256_loadu_ps(target + i));
+        _mm256_storeu_ps(target + i, result);
+    }
+    for (; i < length; i++) {
+        target[i] -= factor * source[i];
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static void axpy4_avx2(float* target, const float* const* sources, const float* factors, int length) {
+    __m256 factor0 = _mm256_set1_ps(factors[0]);
+    __m256 factor1 = _mm256_set1_ps(factors[1]);
+    __m256 factor2 = _mm256_set1_ps(factors[2]);
+    __m256 factor3 = _mm256_set1_ps(factors[3]);
+    int i = 0;
+
+    for (; i + 8 <= length; i += 8) {
+        __m256 result = _mm256_loadu_ps(target + i);
+        result = _mm256_fnmadd_ps(factor0, _mm256_loadu_ps(sources[0] + i), result);
+        result = _mm256_fnmadd_ps(factor1, _mm256_loadu_ps(sources[1] + i), result);
+        result = _mm256_fnmadd_ps(factor2, _mm256_loadu_ps(sources[2] + i), result);
+        result = _mm256_fnmadd_ps(factor3, _mm256_loadu_ps(sources[3] + i), result);
+        _mm256_storeu_ps(target + i, result);
+    }
+    for (; i < length; i++) {
+        target[i] -= factors[0] * sources[0][i] + factors[1] * sources[1][i] + factors[2] * sources[2][i] + factors[3] * sources[3][i];
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static int argmax_abs_avx2(const float* values, int stride, int length) {
+    if (length < 16) {
+        return argmax_abs_scalar(values, stride, length);
+    }
+
+    __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 best_values = _mm256_set1_ps(-1.0f);
+    __m256i best_indices = _mm256_setzero_si256();
+    __m256i current_indices = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i step = _mm256_set1_epi32(8);
+    __m256i offsets = _mm256_mullo_epi32(current_indices, _mm256_set1_epi32(stride));
+    int i = 0;
+
+    for (; i + 8 <= length; i += 8) {
+        const float* base = values + (size_t)i * stride;
+        __m256 current = stride == 1 ? _mm256_loadu_ps(base) : _mm256_i32gather_ps(base, offsets, 4);
+        current = _mm256_and_ps(current, abs_mask);
+
+        __m256 greater = _mm256_cmp_ps(current, best_values, _CMP_GT_OQ);
+        best_values = _mm256_blendv_ps(best_values, current, greater);
+        best_indices = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(best_indices), _mm256_castsi256_ps(current_indices), greater));
+        current_indices = _mm256_add_epi32(current_indices, step);
+    }
+
+    float lane_values[8];
+    int lane_indices[8];
+    _mm256_storeu_ps(lane_values, best_values);
+    _mm256_storeu_si256((__m256i*)lane_indices, best_indices);
+
+    return finish_argmax(lane_values, lane_indices, 8, values, stride, i, length);
+}
+
+__attribute__((target("avx512f")))
+static void axpy_avx512(float* target, const float* source, float factor, int length) {
+    __m512 factor_vector = _mm512_set1_ps(factor);
+    int i = 0;
+
+    for (; i + 16 <= length; i += 16) {
+        __m512 result = _mm512_fnmadd_ps(factor_vector, _mm512_loadu_ps(source + i), _mm512_loadu_ps(target + i));
+        _mm512_storeu_ps(target + i, result);
+    }
+    if (i < length) {
+        __mmask16 mask = (__mmask16)((1u << (length - i)) - 1);
+        __m512 result = _mm512_fnmadd_ps(factor_vector, _mm512_maskz_loadu_ps(mask, source + i), _mm512_maskz_loadu_ps(mask, target + i));
+        _mm512_mask_storeu_ps(target + i, mask, result);
+    }
+}
+
+__attribute__((target("avx512f")))
+static void axpy4_avx512(float* target, const float* const* sources, const float* factors, int length) {
+    __m512 factor0 = _mm512_set1_ps(factors[0]);
+    __m512 factor1 = _mm512_set1_ps(factors[1]);
+    __m512 factor2 = _mm512_set1_ps(factors[2]);
+    __m512 factor3 = _mm512_set1_ps(factors[3]);
+    int i = 0;
+
+    for (; i < length; i += 16) {
+        __mmask16 mask = length - i >= 16 ? (__mmask16)0xffff : (__mmask16)((1u << (length - i)) - 1);
+        __m512 result = _mm512_maskz_loadu_ps(mask, target + i);
+        result = _mm512_fnmadd_ps(factor0, _mm512_maskz_loadu_ps(mask, sources[0] + i), result);
+        result = _mm512_fnmadd_ps(factor1, _mm512_maskz_loadu_ps(mask, sources[1] + i), result);
+        result = _mm512_fnmadd_ps(factor2, _mm512_maskz_loadu_ps(mask, sources[2] + i), result);
+        result = _mm512_fnmadd_ps(factor3, _mm512_maskz_loadu_ps(mask, sources[3] + i), result);
+        _mm512_mask_storeu_ps(target + i, mask, result);
+    }
+}
+
+__attribute__((target("avx512f")))
+static int argmax_abs_avx512(const float* values, int stride, int length) {
+    if (length < 32) {
+        return argmax_abs_scalar(values, stride, length);
+    }
+
+    __m512 best_values = _mm512_set1_ps(-1.0f);
+    __m512i best_indices = _mm512_setzero_si512();
+    __m512i current_indices = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    __m512i step = _mm512_set1_epi32(16);
+    __m512i offsets = _mm512_mullo_epi32(current_indices, _mm512_set1_epi32(stride));
+    int i = 0;
+
+    for (; i + 16 <= length; i += 16) {
+        const float* base = values + (size_t)i * stride;
+        __m512 current = stride == 1 ? _mm512_loadu_ps(base) : _mm512_i32gather_ps(offsets, base, 4);
+        current = _mm512_abs_ps(current);
+
+        __mmask16 greater = _mm512_cmp_ps_mask(current, best_values, _CMP_GT_OQ);
+        best_values = _mm512_mask_mov_ps(best_values, greater, current);
+        best_indices = _mm512_mask_mov_epi32(best_indices, greater, current_indices);
+        current_indices = _mm512_add_epi32(current_indices, step);
+    }
+
+    float lane_values[16];
+    int lane_indices[16];
+    _mm512_storeu_ps(lane_values, best_values);
+    _mm512_storeu_si512(lane_indices, best_indices);
+
+    return finish_argmax(lane_values, lane_indices, 16, values, stride, i, length);
+}
+
+static unsigned long long read_xcr0(void) {
+    unsigned int low, high;
+    __asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+    return ((unsigned long long)high << 32) | low;
+}
+
+static int detect_simd_isa(void) {
+    unsigned int eax, ebx, ecx, edx;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(edx & bit_SSE2)) {
+        return SIMD_SCALAR;
+    }
+
+    int has_avx = (ecx & bit_AVX) != 0;
+    int has_fma = (ecx & bit_FMA) != 0;
+    int has_osxsave = (ecx & bit_OSXSAVE) != 0;
+    unsigned long long xcr0 = has_osxsave ? read_xcr0() : 0;
+    int ymm_enabled = (xcr0 & 0x6) == 0x6;
+    int zmm_enabled = (xcr0 & 0xe6) == 0xe6;
+
+    int has_avx2 = 0;
+    int has_avx512 = 0;
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        has_avx2 = (ebx & bit_AVX2) != 0;
+        has_avx512 = (ebx & bit_AVX512F) != 0;
+    }
+
+    if (has_avx512 && zmm_enabled) {
+        return SIMD_AVX512;
+    }
+    if (has_avx && has_avx2 && has_fma && ymm_enabled) {
+        return SIMD_AVX2;
+    }
+    return SIMD_SSE;
+}
+
+#else
+
+static int detect_simd_isa(void) {
+    return SIMD_SCALAR;
+}
+
+#endif
+
+static const simd_kernels kernel_table[SIMD_ISA_COUNT] = {
+    {SIMD_SCALAR, "scalar", axpy_scalar, axpy4_scalar, argmax_abs_scalar},
+#if SIMD_X86
+    {SIMD_SSE, "SSE2", axpy_sse, axpy4_sse, argmax_abs_sse},
+    {SIMD_AVX2, "AVX2", axpy_avx2, axpy4_avx2, argmax_abs_avx2},
+    {SIMD_AVX512, "AVX-512", axpy_avx512, axpy4_avx512, argmax_abs_avx512},
+#else
+    {SIMD_SSE, "SSE2", axpy_scalar, axpy4_scalar, argmax_abs_scalar},
+    {SIMD_AVX2, "AVX2", axpy_scalar, axpy4_scalar, argmax_abs_scalar},
+    {SIMD_AVX512, "AVX-512", axpy_scalar, axpy4_scalar, argmax_abs_scalar},
+#endif
+};
+
+static int detected_isa = -1;
+
+int simd_isa_supported(simd_isa isa) {
+    if (detected_isa < 0) {
+        detected_isa = detect_simd_isa();
+    }
+    return isa >= SIMD_SCALAR && (int)isa <= detected_isa;
+}
+
+const simd_kernels* get_simd_kernels(simd_isa isa) {
+    if (!simd_isa_supported(isa)) {
+        return NULL;
+    }
+    return &kernel_table[isa];
+}
+
+const simd_kernels* select_simd_kernels(void) {
+    if (detected_isa < 0) {
+        detected_isa = detect_simd_isa();
+    }
+    return &kernel_table[detected_isa];
+}
@@ -1,16 +1,85 @@
 #ifndef MATRIX_H
 #define MATRIX_H
 
+#include "cpu_solver.h"
 #include "kernel_loader.h"
+#include "profiler.h"
 
 #include <CL/cl.h>
+#include <CL/cl_ext.h>
 
-void generate_matrix(float* matrix, int size);
+#ifndef KERNEL_SOURCE_PATH
+#define KERNEL_SOURCE_PATH "kernel/sample.cl"
+#endif
 
-void print_matrix(float* matrix, int size);
+#define BATCH_MAX_SIZE 256
+#define PERSISTENT_MAX_SIZE 512
 
-void calculate_determinant_gauss(float* matrix, int size, float* out_mantissa, long long* out_exponent, int* out_sign);
+typedef struct {
+    cl_device_id device_id;
+    cl_context context;
+    cl_command_queue queue;
+    cl_program program;
+    int program_from_cache;
+    float time_build;
+    cl_kernel kernel_pivot_search;
+    cl_kernel kernel_pivot_swap;
+    cl_kernel kernel_eliminate;
+    cl_kernel kernel_persistent;
+    cl_kernel kernel_batched;
+    cl_kernel kernel_determinant;
+    int pivot_group_size;
+    int elimination_tile;
+    int batch_group_size;
+    int persistent_max_size;
+    int persistent_size_limit;
+    int used_persistent_kernel;
+    cl_mem gpu_matrix;
+    size_t gpu_matrix_capacity;
+    cl_mem gpu_sign;
+    cl_mem gpu_result_mantissa;
+    cl_mem gpu_result_exponent;
+    int read_back_matrix;
+    cl_mem gpu_factors;
+    cl_mem gpu_group_values;
+    cl_mem gpu_group_rows;
+    size_t gpu_vector_capacity;
+    cl_mem gpu_step;
+    int bound_size;
+    int use_command_buffer;
+    int command_buffer_supported;
+    int used_command_buffer;
+#ifdef cl_khr_command_buffer
+    cl_command_buffer_khr command_buffer;
+    clCreateCommandBufferKHR_fn create_command_buffer;
+    clCommandNDRangeKernelKHR_fn command_ndrange_kernel;
+    clFinalizeCommandBufferKHR_fn finalize_command_buffer;
+    clEnqueueCommandBufferKHR_fn enqueue_command_buffer;
+    clReleaseCommandBufferKHR_fn release_command_buffer;
+#endif
+    float time_host_enqueue;
+    float time_pivot;
+    float time_elimination;
+    float time_reduction;
+    cl_mem gpu_batch_matrices;
+    size_t gpu_batch_matrices_capacity;
+    cl_mem gpu_batch_sizes;
+    cl_mem gpu_batch_offsets;
+    cl_mem gpu_batch_mantissas;
+    cl_mem gpu_batch_exponents;
+    cl_mem gpu_batch_signs;
+    size_t gpu_batch_capacity;
+    profiler* profiler;
+} gauss_solver;
 
 void calculate_determinant_gauss_opencl(float* matrix, int size, float* out_mantissa, long long* out_exponent, int* out_sign, float* out_time_write, float* out_time_calc, float* out_time_read);
 
+gauss_solver* gauss_solver_create(int* error_code);
+
+void gauss_solver_calculate_determinant(gauss_solver* solver, float* matrix, int size, float* out_mantissa, long long* out_exponent, int* out_sign, float* out_time_write, float* out_time_calc, float* out_time_read);
+
+void gauss_solver_calculate_determinants_batched(gauss_solver* solver, const float* matrices, int batch_count, int size, const int* sizes, const long long* offsets, float* out_mantissas, long long* out_exponents, int* out_signs, float* out_time_calc, int* error_code);
+
+void gauss_solver_release(gauss_solver* solver);
+
 #endif
@@ -1,43 +1,357 @@
-__kernel void pivot_and_swap(__global float* matrix, int pivot_index, int size, __global int* sign) {
-    int id = get_global_id(0);
-    if (id != 0) {
-        return; 
+#ifndef PIVOT_GROUP_SIZE
+#define PIVOT_GROUP_SIZE 256
+#endif
+
+#ifndef ELIMINATION_TILE
+#define ELIMINATION_TILE 16
+#endif
+
+#ifndef BATCH_GROUP_SIZE
+#define BATCH_GROUP_SIZE 64
+#endif
+
+#ifndef BATCH_MAX_SIZE
+#define BATCH_MAX_SIZE 256
+#endif
+
+int is_better_pivot(float value, int row, float best_value, int best_row) {
+    return value > best_value || (value == best_value && row < best_row);
+}
+
+void reduce_pivot_candidates(__local float* values, __local int* rows, int local_id, int group_size) {
+    for (int stride = group_size / 2; stride > 0; stride /= 2) {
+        if (local_id < stride && is_better_pivot(values[local_id + stride], rows[local_id + stride], values[local_id], rows[local_id])) {
+            values[local_id] = values[local_id + stride];
+            rows[local_id] = rows[local_id + stride];
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
     }
+}
+
+__kernel void pivot_search(__global const float* matrix, int pivot_index, int size, __global float* group_values, __global int* group_rows) {
+    __local float local_values[PIVOT_GROUP_SIZE];
+    __local int local_rows[PIVOT_GROUP_SIZE];
 
-    int max_row = pivot_index;
-    float max_value = fabs(matrix[pivot_index * size + pivot_index]);
-    
-    for (int row = pivot_index + 1; row < size; row++) {
+    int local_id = get_local_id(0);
+    float best_value = -1.0f;
+    int best_row = size;
+
+    for (int row = pivot_index + get_global_id(0); row < size; row += get_global_size(0)) {
         float current_value = fabs(matrix[row * size + pivot_index]);
-        if (current_value > max_value) {
-            max_value = current_value;
-            max_row = row;
+        if (current_value > best_value) {
+            best_value = current_value;
+            best_row = row;
+        }
+    }
+
+    local_values[local_id] = best_value;
+    local_rows[local_id] = best_row;
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    reduce_pivot_candidates(local_values, local_rows, local_id, PIVOT_GROUP_SIZE);
+
+    if (local_id == 0) {
+        group_values[get_group_id(0)] = local_values[0];
+        group_rows[get_group_id(0)] = local_rows[0];
+    }
+}
+
+__kernel void pivot_select_and_swap(__global float* matrix, __global int* step, int size, __global const float* group_values, __global const int* group_rows, int search_groups, __global int* sign, __global float* factors) {
+    __local float local_values[PIVOT_GROUP_SIZE];
+    __local int local_rows[PIVOT_GROUP_SIZE];
+
+    int local_id = get_local_id(0);
+    int pivot_index = *step;
+    int group_count = pivot_index == 0 ? search_groups : (size - pivot_index + ELIMINATION_TILE - 1) / ELIMINATION_TILE;
+    float best_value = -1.0f;
+    int best_row = size;
+
+    for (int group = local_id; group < group_count; group += PIVOT_GROUP_SIZE) {
+        if (is_better_pivot(group_values[group], group_rows[group], best_value, best_row)) {
+            best_value = group_values[group];
+            best_row = group_rows[group];
         }
     }
 
+    local_values[local_id] = best_value;
+    local_rows[local_id] = best_row;
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    reduce_pivot_candidates(local_values, local_rows, local_id, PIVOT_GROUP_SIZE);
+
+    int max_row = local_rows[0];
+    if (max_row >= size) {
+        max_row = pivot_index;
+    }
+
+    float pivot = matrix[max_row * size + pivot_index];
+    barrier(CLK_GLOBAL_MEM_FENCE);
+
     if (max_row != pivot_index) {
-        for (int col = 0; col < size; col++) {
+        for (int col = pivot_index + local_id; col < size; col += PIVOT_GROUP_SIZE) {
             float temp = matrix[pivot_index * size + col];
             matrix[pivot_index * size + col] = matrix[max_row * size + col];
             matrix[max_row * size + col] = temp;
         }
+
+        if (local_id == 0) {
+            *sign = -(*sign);
+        }
+    }
+    barrier(CLK_GLOBAL_MEM_FENCE);
+
+    for (int row = pivot_index + 1 + local_id; row < size; row += PIVOT_GROUP_SIZE) {
+        factors[row] = fabs(pivot) < 1e-12f ? 0.0f : matrix[row * size + pivot_index] / pivot;
+    }
+
+    if (local_id == 0) {
+        *step = pivot_index + 1;
+    }
+}
+
+__kernel void eliminate_tiled(__global float* matrix, __global const int* step, int size, __global const float* factors, __global float* group_values, __global int* group_rows) {
+    __local float pivot_row[ELIMINATION_TILE];
+    __local float row_factors[ELIMINATION_TILE];
+    __local float next_column[ELIMINATION_TILE];
+
+    int pivot_index = *step - 1;
+    int local_col = get_local_id(0);
+    int local_row = get_local_id(1);
+    int col = pivot_index + 1 + get_global_id(0);
+    int row = pivot_index + 1 + get_global_id(1);
+    int holds_next_column = get_group_id(0) == 0 && local_col == 0;
+
+    if (local_row == 0) {
+        pivot_row[local_col] = col < size ? matrix[pivot_index * size + col] : 0.0f;
+    }
+    if (local_col == 0) {
+        row_factors[local_row] = row < size ? factors[row] : 0.0f;
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    if (row < size && col < size) {
+        float value = matrix[row * size + col] - row_factors[local_row] * pivot_row[local_col];
+        matrix[row * size + col] = value;
+        if (holds_next_column) {
+            next_column[local_row] = fabs(value);
+        }
+    } else if (holds_next_column) {
+        next_column[local_row] = -1.0f;
+    }
+
+    if (get_group_id(0) == 0) {
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        if (local_col == 0 && local_row == 0) {
+            float best_value = -1.0f;
+            int best_row = size;
+            int first_row = pivot_index + 1 + get_group_id(1) * ELIMINATION_TILE;
+            for (int i = 0; i < ELIMINATION_TILE; i++) {
+                if (next_column[i] > best_value) {
+                    best_value = next_column[i];
+                    best_row = first_row + i;
+                }
+            }
+            group_values[get_group_id(1)] = best_value;
+            group_rows[get_group_id(1)] = best_row;
+        }
+    }
+}
+
+__kernel void eliminate_persistent(__global float* matrix, int size, __global int* sign, __local float* pivot_row, __local float* row_factors) {
+    __local float local_values[PIVOT_GROUP_SIZE];
+    __local int local_rows[PIVOT_GROUP_SIZE];
+
+    int local_id = get_local_id(0);
+    int swap_sign = 1;
+
+    for (int pivot_index = 0; pivot_index < size - 1; pivot_index++) {
+        float best_value = -1.0f;
+        int best_row = size;
+        for (int row = pivot_index + local_id; row < size; row += PIVOT_GROUP_SIZE) {
+            float current_value = fabs(matrix[row * size + pivot_index]);
+            if (is_better_pivot(current_value, row, best_value, best_row)) {
+                best_value = current_value;
+                best_row = row;
+            }
+        }
+
+        local_values[local_id] = best_value;
+        local_rows[local_id] = best_row;
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        reduce_pivot_candidates(local_values, local_rows, local_id, PIVOT_GROUP_SIZE);
+
+        int max_row = local_rows[0];
+        float pivot = matrix[max_row * size + pivot_index];
+        barrier(CLK_GLOBAL_MEM_FENCE);
+
+        if (max_row != pivot_index) {
+            for (int col = pivot_index + local_id; col < size; col += PIVOT_GROUP_SIZE) {
+                float temp = matrix[pivot_index * size + col];
+                matrix[pivot_index * size + col] = matrix[max_row * size + col];
+                matrix[max_row * size + col] = temp;
+            }
+            swap_sign = -swap_sign;
+        }
+        barrier(CLK_GLOBAL_MEM_FENCE);
+
+        for (int index = pivot_index + 1 + local_id; index < size; index += PIVOT_GROUP_SIZE) {
+            pivot_row[index] = matrix[pivot_index * size + index];
+            row_factors[index] = fabs(pivot) < 1e-12f ? 0.0f : matrix[index * size + pivot_index] / pivot;
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        int width = size - pivot_index - 1;
+        for (int index = local_id; index < width * width; index += PIVOT_GROUP_SIZE) {
+            int row = pivot_index + 1 + index / width;
+            int col = pivot_index + 1 + index % width;
+            matrix[row * size + col] -= row_factors[row] * pivot_row[col];
+        }
+        barrier(CLK_GLOBAL_MEM_FENCE);
+    }
+
+    if (local_id == 0 && swap_sign < 0) {
         *sign = -(*sign);
     }
 }
 
-__kernel void calculate_determinant_gauss(__global float* matrix, int pivot_index, int size) {
-    int row = get_global_id(1) + pivot_index + 1;
-    int col = get_global_id(0) + pivot_index + 1;
-    
-    if (row >= size || col >= size) {
-        return;
+__kernel void batched_determinant(__global float* matrices, __global const int* sizes, __global const long* offsets, __global float* out_mantissas, __global int* out_exponents, __global int* out_signs) {
+    __local float local_values[BATCH_GROUP_SIZE];
+    __local int local_rows[BATCH_GROUP_SIZE];
+    __local float pivot_row[BATCH_MAX_SIZE];
+    __local float row_factors[BATCH_MAX_SIZE];
+
+    int matrix_index = get_group_id(0);
+    int local_id = get_local_id(0);
+    int size = sizes[matrix_index];
+    __global float* matrix = matrices + offsets[matrix_index];
+
+    float mantissa = 1.0f;
+    int exponent = 0;
+    int sign = 1;
+
+    for (int pivot_index = 0; pivot_index < size; pivot_index++) {
+        float best_value = -1.0f;
+        int best_row = size;
+        for (int row = pivot_index + local_id; row < size; row += BATCH_GROUP_SIZE) {
+            float current_value = fabs(matrix[row * size + pivot_index]);
+            if (is_better_pivot(current_value, row, best_value, best_row)) {
+                best_value = current_value;
+                best_row = row;
+            }
+        }
+
+        local_values[local_id] = best_value;
+        local_rows[local_id] = best_row;
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        reduce_pivot_candidates(local_values, local_rows, local_id, BATCH_GROUP_SIZE);
+
+        int pivot_row_index = local_rows[0];
+        float pivot = matrix[pivot_row_index * size + pivot_index];
+        barrier(CLK_GLOBAL_MEM_FENCE);
+
+        if (fabs(pivot) < 1e-12f) {
+            mantissa = 0.0f;
+            exponent = 0;
+            sign = 1;
+            break;
+        }
+
+        if (pivot_row_index != pivot_index) {
+            for (int col = pivot_index + local_id; col < size; col += BATCH_GROUP_SIZE) {
+                float temp = matrix[pivot_index * size + col];
+                matrix[pivot_index * size + col] = matrix[pivot_row_index * size + col];
+                matrix[pivot_row_index * size + col] = temp;
+            }
+            sign = -sign;
+        }
+        barrier(CLK_GLOBAL_MEM_FENCE);
+
+        for (int index = pivot_index + 1 + local_id; index < size; index += BATCH_GROUP_SIZE) {
+            pivot_row[index] = matrix[pivot_index * size + index];
+            row_factors[index] = matrix[index * size + pivot_index] / pivot;
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        int width = size - pivot_index - 1;
+        for (int index = local_id; index < width * width; index += BATCH_GROUP_SIZE) {
+            int row = pivot_index + 1 + index / width;
+            int col = pivot_index + 1 + index % width;
+            matrix[row * size + col] -= row_factors[row] * pivot_row[col];
+        }
+        barrier(CLK_GLOBAL_MEM_FENCE);
+
+        int pivot_exponent;
+        mantissa *= frexp(fabs(pivot), &pivot_exponent);
+        exponent += pivot_exponent;
+        mantissa = frexp(mantissa, &pivot_exponent);
+        exponent += pivot_exponent;
+        if (pivot < 0.0f) {
+            sign = -sign;
+        }
     }
-    
-    float pivot = matrix[pivot_index * size + pivot_index];
-    if (fabs(pivot) < 1e-12f) {
-        return;
+
+    if (local_id == 0) {
+        out_mantissas[matrix_index] = mantissa;
+        out_exponents[matrix_index] = exponent;
+        out_signs[matrix_index] = sign;
+    }
+}
+
+__kernel void diagonal_determinant(__global const float* matrix, int size, __global int* sign, __global float* out_mantissa, __global int* out_exponent) {
+    __local float local_mantissas[PIVOT_GROUP_SIZE];
+    __local int local_exponents[PIVOT_GROUP_SIZE];
+    __local int local_signs[PIVOT_GROUP_SIZE];
+
+    int local_id = get_local_id(0);
+    float mantissa = 1.0f;
+    int exponent = 0;
+    int diagonal_sign = 1;
+
+    for (int i = local_id; i < size; i += get_local_size(0)) {
+        float value = matrix[(long)i * size + i];
+        if (fabs(value) < 1e-12f) {
+            diagonal_sign = 0;
+        }
+        if (value < 0.0f) {
+            diagonal_sign = -diagonal_sign;
+        }
+
+        int value_exponent;
+        mantissa *= frexp(fabs(value), &value_exponent);
+        exponent += value_exponent;
+
+        int mantissa_exponent;
+        mantissa = frexp(mantissa, &mantissa_exponent);
+        exponent += mantissa_exponent;
+    }
+
+    local_mantissas[local_id] = mantissa;
+    local_exponents[local_id] = exponent;
+    local_signs[local_id] = diagonal_sign;
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    for (int stride = get_local_size(0) / 2; stride > 0; stride /= 2) {
+        if (local_id < stride) {
+            int mantissa_exponent;
+            local_mantissas[local_id] = frexp(local_mantissas[local_id] * local_mantissas[local_id + stride], &mantissa_exponent);
+            local_exponents[local_id] += local_exponents[local_id + stride] + mantissa_exponent;
+            local_signs[local_id] *= local_signs[local_id + stride];
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    if (local_id == 0) {
+        if (local_signs[0] == 0) {
+            out_mantissa[0] = 0.0f;
+            out_exponent[0] = 0;
+            sign[0] = 1;
+        } else {
+            out_mantissa[0] = local_mantissas[0];
+            out_exponent[0] = local_exponents[0];
+            sign[0] *= local_signs[0];
+        }
     }
-    
-    float factor = matrix[row * size + pivot_index] / pivot;
-    matrix[row * size + col] -= factor * matrix[pivot_index * size + col];
 }
@@ -1,12 +1,15 @@
 #define CL_TARGET_OPENCL_VERSION 220
 
 #include "matrix.h"
+#include "matrix_file.h"
 #include "file.h"
+#include "cpu_solver.h"
+#include "simd_kernels.h"
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
 #include <math.h>
+#include <string.h>
 
 #ifdef _WIN32
     #include <direct.h>
@@ -19,14 +22,381 @@
 int MATRIX_SIZE = 10;
 
 #define MAX_MATRIX_SIZE_CPU 2000
+#define MAX_MATRIX_SIZE_INT_INDEX 46340
+
+static const char* launch_mode_name(const gauss_solver* solver) {
+    if (solver->used_persistent_kernel) {
+        return "single persistent launch";
+    }
+    return solver->used_command_buffer ? "command buffer replay" : "per-step launches";
+}
+
+static void run_solver_benchmark(int size, int warm_runs, int use_command_buffer) {
+    float* source = malloc(size * size * sizeof(float));
+    float* work = malloc(size * size * sizeof(float));
+    if (source == NULL || work == NULL) {
+        free(source);
+        free(work);
+        return;
+    }
+
+    generate_matrix(source, size);
+
+    float mantissa;
+    long long exponent;
+    int sign;
+    int error_code;
+
+    memcpy(work, source, size * size * sizeof(float));
+
+    double start_cold = wall_clock_seconds();
+
+    gauss_solver* solver = gauss_solver_create(&error_code);
+    if (solver == NULL) {
+        printf("Failed to initialize OpenCL solver (error %d)\n", error_code);
+        free(source);
+        free(work);
+        return;
+    }
+    solver->use_command_buffer = use_command_buffer;
+    gauss_solver_calculate_determinant(solver, work, size, &mantissa, &exponent, &sign, NULL, NULL, NULL);
+
+    double end_cold = wall_clock_seconds();
+    float cold_time = (float)(end_cold - start_cold);
+
+    float warm_total = 0.0f;
+    float warm_best = 0.0f;
+    float enqueue_total = 0.0f;
+    float device_total = 0.0f;
+
+    for (int run = 0; run < warm_runs; run++) {
+        memcpy(work, source, size * size * sizeof(float));
+
+        double start_warm = wall_clock_seconds();
+        float device_time;
+        gauss_solver_calculate_determinant(solver, work, size, &mantissa, &exponent, &sign, NULL, &device_time, NULL);
+        double end_warm = wall_clock_seconds();
+        enqueue_total += solver->time_host_enqueue;
+        device_total += device_time;
+
+        float warm_time = (float)(end_warm - start_warm);
+        warm_total += warm_time;
+        if (run == 0 || warm_time < warm_best) {
+            warm_best = warm_time;
+        }
+    }
+
+    float warm_average = warm_total / warm_runs;
+
+    printf("\n===================================\n");
+    printf("Solver benchmark (%d warm runs)\n", warm_runs);
+    printf("-----------------------------------\n");
+    printf("Cold call (setup + solve): %.6f s\n", cold_time);
+    printf("Warm call (average): %.6f s\n", warm_average);
+    printf("Warm call (best): %.6f s\n", warm_best);
+    printf("Host enqueue (average): %.6f s, %s\n", enqueue_total / warm_runs, launch_mode_name(solver));
+    printf("Device compute (average): %.6f s\n", device_total / warm_runs);
+    if (warm_average > 0.0f) {
+        printf("Cold / warm ratio: %.2fx\n", cold_time / warm_average);
+    }
+    printf("===================================\n");
+
+    write_benchmark_to_file("outputs/benchmark_gpu_cold.txt", size, cold_time);
+    write_benchmark_to_file("outputs/benchmark_gpu_warm.txt", size, warm_average);
+
+    gauss_solver_release(solver);
+    free(source);
+    free(work);
+}
+
+static float best_solve_time(gauss_solver* solver, const float* source, float* work, int size, int runs) {
+    float mantissa;
+    long long exponent;
+    int sign;
+    float best = 0.0f;
+
+    for (int run = 0; run <= runs; run++) {
+        memcpy(work, source, (size_t)size * size * sizeof(float));
+        double start = wall_clock_seconds();
+        gauss_solver_calculate_determinant(solver, work, size, &mantissa, &exponent, &sign, NULL, NULL, NULL);
+        float elapsed = (float)(wall_clock_seconds() - start);
+        if (run == 1 || (run > 1 && elapsed < best)) {
+            best = elapsed;
+        }
+    }
+
+    return best;
+}
+
+static void run_persistent_benchmark(int max_size) {
+    int error_code;
+    gauss_solver* solver = gauss_solver_create(&error_code);
+    if (solver == NULL) {
+        printf("Failed to initialize OpenCL solver (error %d)\n", error_code);
+        return;
+    }
+
+    printf("\n===================================\n");
+    printf("Persistent kernel benchmark (limit %d, threshold %d)\n", solver->persistent_size_limit, solver->persistent_max_size);
+    printf("-----------------------------------\n");
+    printf("%-6s | %-14s | %-14s | %-8s\n", "Size", "Per-step (s)", "Persistent (s)", "Speedup");
+    printf("--------------------------------------------------\n");
+
+    int crossover = 0;
+    int size = 16 < max_size ? 16 : max_size;
+    while (size > 1 && size <= solver->persistent_size_limit) {
+        float* source = malloc((size_t)size * size * sizeof(float));
+        float* work = malloc((size_t)size * size * sizeof(float));
+        if (source == NULL || work == NULL) {
+            free(source);
+            free(work);
+            break;
+        }
+        generate_matrix(source, size);
+
+        solver->persistent_max_size = 0;
+        float per_step_time = best_solve_time(solver, source, work, size, 3);
+        solver->persistent_max_size = solver->persistent_size_limit;
+        float persistent_time = best_solve_time(solver, source, work, size, 3);
+
+        printf("%-6d | %-14.6f | %-14.6f | %-8.2f\n", size, per_step_time, persistent_time, persistent_time > 0.0f ? per_step_time / persistent_time : 0.0f);
+        write_benchmark_to_file("outputs/benchmark_gpu_per_step.txt", size, per_step_time);
+        write_benchmark_to_file("outputs/benchmark_gpu_persistent.txt", size, persistent_time);
+        if (persistent_time < per_step_time) {
+            crossover = size;
+        }
+
+        free(source);
+        free(work);
+        if (size == max_size) break;
+        size = 2 * size < max_size ? 2 * size : max_size;
+    }
+
+    printf("Largest measured size where the persistent kernel wins: %d (default threshold %d)\n", crossover, PERSISTENT_MAX_SIZE);
+    printf("===================================\n");
+
+    gauss_solver_release(solver);
+}
+
+static void run_batch_benchmark(void) {
+    const int sizes[] = {8, 32, 128, 256};
+    const int batch_counts[] = {1, 64, 1024};
+    const int size_count = sizeof(sizes) / sizeof(sizes[0]);
+    const int batch_count_count = sizeof(batch_counts) / sizeof(batch_counts[0]);
+
+    int error_code;
+    gauss_solver* solver = gauss_solver_create(&error_code);
+    if (solver == NULL) {
+        printf("Failed to initialize OpenCL solver (error %d)\n", error_code);
+        return;
+    }
+
+    printf("\n===================================\n");
+    printf("Batched determinant benchmark\n");
+    printf("-----------------------------------\n");
+    printf("%-6s | %-6s | %-14s | %-14s | %-14s\n", "Size", "Batch", "Batched det/s", "Kernel det/s", "Single det/s");
+    printf("------------------------------------------------------------------\n");
+
+    for (int s = 0; s < size_count; s++) {
+        int size = sizes[s];
+        size_t elements = (size_t)size * size;
+
+        for (int b = 0; b < batch_count_count; b++) {
+            int batch_count = batch_counts[b];
+
+            float* matrices = malloc(batch_count * elements * sizeof(float));
+            float* work = malloc(elements * sizeof(float));
+            float* mantissas = malloc(batch_count * sizeof(float));
+            long long* exponents = malloc(batch_count * sizeof(long long));
+            int* signs = malloc(batch_count * sizeof(int));
+            if (matrices == NULL || work == NULL || mantissas == NULL || exponents == NULL || signs == NULL) {
+                free(matrices);
+                free(work);
+                free(mantissas);
+                free(exponents);
+                free(signs);
+                continue;
+            }
+
+            for (int i = 0; i < batch_count; i++) {
+                generate_matrix(matrices + i * elements, size);
+            }
+
+            float kernel_time = 0.0f;
+            double start_batched = wall_clock_seconds();
+            gauss_solver_calculate_determinants_batched(solver, matrices, batch_count, size, NULL, NULL, mantissas, exponents, signs, &kernel_time, &error_code);
+            double batched_time = wall_clock_seconds() - start_batched;
+
+            if (error_code != 0) {
+                printf("%-6d | %-6d | failed (error %d)\n", size, batch_count, error_code);
+            } else {
+                float mantissa;
+                long long exponent;
+                int sign;
+                int single_runs = batch_count < 64 ? batch_count : 64;
+
+                double start_single = wall_clock_seconds();
+                for (int i = 0; i < single_runs; i++) {
+                    memcpy(work, matrices + i * elements, elements * sizeof(float));
+                    gauss_solver_calculate_determinant(solver, work, size, &mantissa, &exponent, &sign, NULL, NULL, NULL);
+                }
+                double single_time = wall_clock_seconds() - start_single;
+
+                printf("%-6d | %-6d | %-14.1f | %-14.1f | %-14.1f\n", size, batch_count,
+                       batched_time > 0.0 ? batch_count / batched_time : 0.0,
+                       kernel_time > 0.0f ? batch_count / kernel_time : 0.0,
+                       single_time > 0.0 ? single_runs / single_time : 0.0);
+            }
+
+            free(matrices);
+            free(work);
+            free(mantissas);
+            free(exponents);
+            free(signs);
+        }
+    }
+
+    printf("===================================\n");
+
+    gauss_solver_release(solver);
+}
+
+static float* load_matrix_input(const char* path, int verify, matrix_file* file, int* size) {
+    int error_code;
+    double start = wall_clock_seconds();
+
+    matrix_file_open(path, file, &error_code);
+    if (error_code != 0) {
+        printf("Failed to open matrix file %s (error %d)\n", path, error_code);
+        return NULL;
+    }
+
+    if (file->header.rows != file->header.cols || file->header.rows > MAX_MATRIX_SIZE_INT_INDEX) {
+        printf("Matrix file %s is %llux%llu, expected a square matrix up to %d\n", path,
+               (unsigned long long)file->header.rows, (unsigned long long)file->header.cols, MAX_MATRIX_SIZE_INT_INDEX);
+        matrix_file_close(file);
+        return NULL;
+    }
+
+    if (verify && matrix_file_verify(file) != 0) {
+        printf("Checksum mismatch in matrix file %s\n", path);
+        matrix_file_close(file);
+        return NULL;
+    }
+
+    float* matrix = matrix_file_floats(file, &error_code);
+    if (matrix == NULL) {
+        printf("Failed to convert matrix file %s (error %d)\n", path, error_code);
+        matrix_file_close(file);
+        return NULL;
+    }
+
+    double elapsed = wall_clock_seconds() - start;
+    double bytes = (double)file->header.rows * file->header.cols * matrix_element_size((matrix_element_type)file->header.element_type);
+    *size = (int)file->header.rows;
+
+    printf("Loaded %s: %dx%d %s, %s, %.1f MB in %.4f s", path, *size, *size,
+           file->header.element_type == MATRIX_ELEMENT_FLOAT64 ? "float64" : "float32",
+           file->header.layout == MATRIX_LAYOUT_COLUMN_MAJOR ? "column-major" : "row-major", bytes / 1048576.0, elapsed);
+    if (elapsed > 0.0) {
+        printf(" (%.2f GB/s%s)", bytes / elapsed / 1.0e9, verify && (file->header.flags & MATRIX_FILE_HAS_CHECKSUM) ? ", checksum verified" : ", mapped only");
+    }
+    printf("\n");
+
+    return matrix;
+}
+
+static void release_matrix_source(float* matrix_source, matrix_file* input_file) {
+    if (input_file != NULL) {
+        matrix_file_close(input_file);
+    } else {
+        free(matrix_source);
+    }
+}
+
+static void write_profile_outputs(const gauss_solver* solver, int size, double wall_time, const char* profile_base, const char* trace_path) {
+    profile_info info;
+    info.engine = "opencl_gauss";
+    info.device_id = solver->device_id;
+    info.matrix_size = size;
+    info.block_size = solver->elimination_tile;
+    info.precision = "fp32";
+    info.wall_time = wall_time;
+    info.flops = 2.0 * size * size * size / 3.0;
+
+    if (profile_base != NULL) {
+        char json_path[1024], csv_path[1024];
+        snprintf(json_path, sizeof(json_path), "%s.json", profile_base);
+        snprintf(csv_path, sizeof(csv_path), "%s.csv", profile_base);
+        if (write_profile_json(solver->profiler, &info, json_path) == 0 && write_profile_csv(solver->profiler, &info, csv_path) == 0) {
+            printf("Profile written to %s and %s\n", json_path, csv_path);
+        }
+    }
+
+    if (trace_path != NULL && write_chrome_trace(solver->profiler, trace_path) == 0) {
+        printf("Chrome trace written to %s\n", trace_path);
+    }
+}
 
 int main(int argc, char* argv[]) {
-    if (argc > 1) {
-        MATRIX_SIZE = atoi(argv[1]);
+    int warm_runs = 0;
+    int cpu_blocked = 1;
+    int cpu_threads = 0;
+    int compare_diagonal = 0;
+    int batch_benchmark = 0;
+    const char* input_path = NULL;
+    const char* save_path = NULL;
+    int verify_input = 1;
+    const char* profile_base = NULL;
+    const char* trace_path = NULL;
+    int use_command_buffer = 1;
+    int persistent_threshold = -1;
+    int persistent_benchmark = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--warm") == 0 && i + 1 < argc) {
+            warm_runs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--cpu") == 0 && i + 1 < argc) {
+            cpu_blocked = strcmp(argv[++i], "naive") != 0;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            cpu_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--compare-diagonal") == 0) {
+            compare_diagonal = 1;
+        } else if (strcmp(argv[i], "--batch-benchmark") == 0) {
+            batch_benchmark = 1;
+        } else if (strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+            input_path = argv[++i];
+        } else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc) {
+            save_path = argv[++i];
+        } else if (strcmp(argv[i], "--no-verify") == 0) {
+            verify_input = 0;
+        } else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            profile_base = argv[++i];
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (strcmp(argv[i], "--no-command-buffer") == 0) {
+            use_command_buffer = 0;
+        } else if (strcmp(argv[i], "--persistent-threshold") == 0 && i + 1 < argc) {
+            persistent_threshold = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--persistent-benchmark") == 0) {
+            persistent_benchmark = 1;
+        } else {
+            MATRIX_SIZE = atoi(argv[i]);
+        }
     }
 
-    float* matrix_gpu = malloc(MATRIX_SIZE * MATRIX_SIZE * sizeof(float));
-    float* matrix_cpu = malloc(MATRIX_SIZE * MATRIX_SIZE * sizeof(float));
+    int error_code;
+    matrix_file input_file;
+    float* matrix_input = NULL;
+    if (input_path != NULL) {
+        matrix_input = load_matrix_input(input_path, verify_input, &input_file, &MATRIX_SIZE);
+        if (matrix_input == NULL) {
+            return -1;
+        }
+    }
+
+    float* matrix_gpu = matrix_input != NULL ? matrix_input : malloc((size_t)MATRIX_SIZE * MATRIX_SIZE * sizeof(float));
+    float* matrix_cpu = malloc((size_t)MATRIX_SIZE * MATRIX_SIZE * sizeof(float));
 
     if (matrix_gpu == NULL || matrix_cpu == NULL) return -1;
 
@@ -36,9 +406,20 @@ int main(int argc, char* argv[]) {
         mkdir("outputs", 0777);
     #endif
 
-    generate_matrix(matrix_gpu, MATRIX_SIZE);
-    for (int i = 0; i < MATRIX_SIZE * MATRIX_SIZE; i++) {
-        matrix_cpu[i] = matrix_gpu[i];
+    if (matrix_input == NULL) {
+        generate_matrix(matrix_gpu, MATRIX_SIZE);
+    }
+    memcpy(matrix_cpu, matrix_gpu, (size_t)MATRIX_SIZE * MATRIX_SIZE * sizeof(float));
+
+    if (save_path != NULL) {
+        double start_save = wall_clock_seconds();
+        write_matrix_file(save_path, matrix_gpu, MATRIX_SIZE, &error_code);
+        double save_time = wall_clock_seconds() - start_save;
+        if (error_code != 0) {
+            printf("Failed to write matrix file %s (error %d)\n", save_path, error_code);
+        } else {
+            printf("Saved %s: %.1f MB in %.4f s\n", save_path, (double)MATRIX_SIZE * MATRIX_SIZE * sizeof(float) / 1048576.0, save_time);
+        }
     }
 
     if (MATRIX_SIZE <= 10) {
@@ -59,13 +440,24 @@ int main(int argc, char* argv[]) {
     printf("CPU\n");
     printf("-----------------------------------\n");
 
-    if (MATRIX_SIZE <= MAX_MATRIX_SIZE_CPU) {
-        clock_t start_cpu = clock();
+    int cpu_computed = cpu_blocked || MATRIX_SIZE <= MAX_MATRIX_SIZE_CPU;
+
+    if (cpu_computed) {
+        double start_cpu = wall_clock_seconds();
         
-        calculate_determinant_gauss(matrix_cpu, MATRIX_SIZE, &cpu_mantissa, &cpu_exponent, &cpu_sign);
+        if (cpu_blocked) {
+            if (cpu_threads <= 0) {
+                cpu_threads = cpu_thread_count();
+            }
+            printf("Engine: blocked LU, %d threads, %s\n", cpu_threads, select_simd_kernels()->name);
+            calculate_determinant_blocked(matrix_cpu, MATRIX_SIZE, cpu_threads, &cpu_mantissa, &cpu_exponent, &cpu_sign);
+        } else {
+            printf("Engine: naive Gauss, %s\n", select_simd_kernels()->name);
+            calculate_determinant_gauss(matrix_cpu, MATRIX_SIZE, &cpu_mantissa, &cpu_exponent, &cpu_sign);
+        }
         
-        clock_t end_cpu = clock();
-        float cpu_time = (float)(end_cpu - start_cpu) / CLOCKS_PER_SEC;
+        double end_cpu = wall_clock_seconds();
+        float cpu_time = (float)(end_cpu - start_cpu);
 
         printf("Execution time (CPU): %.4f s\n", cpu_time);
         
@@ -77,7 +469,7 @@ int main(int argc, char* argv[]) {
         
         write_benchmark_to_file("outputs/benchmark_cpu.txt", MATRIX_SIZE, cpu_time);
     } else {
-        printf("Skipped (Matrix size > %d)\n", MAX_MATRIX_SIZE_CPU);
+        printf("Skipped (Matrix size > %d, use --cpu blocked)\n", MAX_MATRIX_SIZE_CPU);
     }
 
     printf("===================================\n");
@@ -89,12 +481,32 @@ int main(int argc, char* argv[]) {
     int gpu_sign;
     float gpu_time_write, gpu_time_calc, gpu_time_read;
 
-    clock_t start_gpu = clock();
+    double start_gpu = wall_clock_seconds();
+
+    gauss_solver* solver = gauss_solver_create(&error_code);
+    if (solver == NULL) {
+        printf("Failed to initialize OpenCL solver (error %d)\n", error_code);
+        release_matrix_source(matrix_gpu, matrix_input != NULL ? &input_file : NULL);
+        free(matrix_cpu);
+        return -1;
+    }
+
+    solver->read_back_matrix = compare_diagonal;
+    solver->use_command_buffer = use_command_buffer;
+    if (persistent_threshold >= 0) {
+        solver->persistent_max_size = persistent_threshold;
+    }
+    if (profile_base != NULL || trace_path != NULL) {
+        solver->profiler = create_profiler();
+    }
+
+    double end_setup = wall_clock_seconds();
+    float gpu_time_setup = (float)(end_setup - start_gpu);
     
-    calculate_determinant_gauss_opencl(matrix_gpu, MATRIX_SIZE, &gpu_mantissa, &gpu_exponent, &gpu_sign, &gpu_time_write, &gpu_time_calc, &gpu_time_read);
+    gauss_solver_calculate_determinant(solver, matrix_gpu, MATRIX_SIZE, &gpu_mantissa, &gpu_exponent, &gpu_sign, &gpu_time_write, &gpu_time_calc, &gpu_time_read);
     
-    clock_t end_gpu = clock();
-    float gpu_time = (float)(end_gpu - start_gpu) / CLOCKS_PER_SEC;
+    double end_gpu = wall_clock_seconds();
+    float gpu_time = (float)(end_gpu - start_gpu);
 
     if (gpu_mantissa == 0.0) {
         printf("Determinant (GPU): 0\n");
@@ -102,24 +514,37 @@ int main(int argc, char* argv[]) {
         printf("Determinant (GPU): %s%.4f * 10^%lld\n", gpu_sign < 0 ? "-" : "", gpu_mantissa, gpu_exponent);
     }
     
+    printf("OpenCL setup: %.4f s (program %s in %.4f s)\n", gpu_time_setup, solver->program_from_cache ? "loaded from binary cache" : "built from source", solver->time_build);
     printf("CPU -> GPU: %.4f s\n", gpu_time_write);
+    printf("Host enqueue: %.4f s (%s)\n", solver->time_host_enqueue, launch_mode_name(solver));
     printf("GPU Computing: %.4f s\n", gpu_time_calc);
+    printf("  Pivot search and swap: %.4f s\n", solver->time_pivot);
+    printf("  Elimination: %.4f s\n", solver->time_elimination);
+    printf("  Determinant reduction: %.4f s\n", solver->time_reduction);
     printf("GPU -> CPU: %.4f s\n", gpu_time_read);
     printf("Total execution time (GPU): %.4f s\n", gpu_time);
+    if (solver->profiler != NULL) {
+        write_profile_outputs(solver, MATRIX_SIZE, end_gpu - end_setup, profile_base, trace_path);
+    }
     printf("===================================\n");
+
+    release_profiler(solver->profiler);
+    gauss_solver_release(solver);
     
-    if (MATRIX_SIZE <= MAX_MATRIX_SIZE_CPU) {
-        printf("\nDiagonal comparison:\n");
-        printf("%-5s | %-15s | %-15s | %-10s\n", "Index", "CPU Diagonal", "GPU Diagonal", "Diff");
-        printf("------------------------------------------------------------\n");
-
-        int limit = (MATRIX_SIZE < 10) ? MATRIX_SIZE : 10;
-        for (int i = 0; i < limit; i++) {
-            float c_val = matrix_cpu[i * MATRIX_SIZE + i];
-            float g_val = matrix_gpu[i * MATRIX_SIZE + i];
-            printf("%-5d | %-15.6f | %-15.6f | %-10.6e\n", i, c_val, g_val, fabs(c_val - g_val));
+    if (cpu_computed) {
+        if (compare_diagonal) {
+            printf("\nDiagonal comparison:\n");
+            printf("%-5s | %-15s | %-15s | %-10s\n", "Index", "CPU Diagonal", "GPU Diagonal", "Diff");
+            printf("------------------------------------------------------------\n");
+
+            int limit = (MATRIX_SIZE < 10) ? MATRIX_SIZE : 10;
+            for (int i = 0; i < limit; i++) {
+                float c_val = matrix_cpu[i * MATRIX_SIZE + i];
+                float g_val = matrix_gpu[i * MATRIX_SIZE + i];
+                printf("%-5d | %-15.6f | %-15.6f | %-10.6e\n", i, c_val, g_val, fabs(c_val - g_val));
+            }
+            printf("===================================\n");
         }
-        printf("===================================\n");
 
         if (cpu_mantissa != 0.0) {
             double gpu_part = (double)(gpu_sign * gpu_mantissa);
@@ -135,7 +560,19 @@ int main(int argc, char* argv[]) {
 
     write_benchmark_to_file("outputs/benchmark_gpu.txt", MATRIX_SIZE, gpu_time);
 
-    free(matrix_gpu);
+    if (warm_runs > 0) {
+        run_solver_benchmark(MATRIX_SIZE, warm_runs, use_command_buffer);
+    }
+
+    if (batch_benchmark) {
+        run_batch_benchmark();
+    }
+
+    if (persistent_benchmark) {
+        run_persistent_benchmark(MATRIX_SIZE);
+    }
+
+    release_matrix_source(matrix_gpu, matrix_input != NULL ? &input_file : NULL);
     free(matrix_cpu);
     
     return 0;
@@ -3,189 +3,406 @@
 #include "matrix.h"
 #include "file.h"
 #include "kernel_loader.h"
+#include "simd_kernels.h"
+#include "scaled_product.h"
+#include "cpu_solver.h"
 
 #include <CL/cl.h>
+#include <CL/cl_ext.h>
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
-#include <time.h>
 
-void generate_matrix(float* matrix, int size) {
-    srand(42);
-    
-    for (int i = 0; i < size * size; i++) {
-        matrix[i] = (float)(rand() % 10); 
+#define PIVOT_GROUP_SIZE 256
+#define PIVOT_MAX_GROUPS 64
+#define ELIMINATION_TILE 16
+#define BATCH_GROUP_SIZE 64
+
+static void load_command_buffer_functions(gauss_solver* solver, cl_platform_id platform_id) {
+#ifdef cl_khr_command_buffer
+    size_t length = 0;
+    clGetDeviceInfo(solver->device_id, CL_DEVICE_EXTENSIONS, 0, NULL, &length);
+    char* extensions = (char*)malloc(length + 1);
+    if (extensions == NULL) {
+        return;
     }
+    extensions[0] = '\0';
+    clGetDeviceInfo(solver->device_id, CL_DEVICE_EXTENSIONS, length, extensions, NULL);
+    extensions[length] = '\0';
+    int has_extension = strstr(extensions, "cl_khr_command_buffer") != NULL;
+    free(extensions);
+    if (!has_extension) {
+        return;
+    }
+
+    solver->create_command_buffer = (clCreateCommandBufferKHR_fn)clGetExtensionFunctionAddressForPlatform(platform_id, "clCreateCommandBufferKHR");
+    solver->command_ndrange_kernel = (clCommandNDRangeKernelKHR_fn)clGetExtensionFunctionAddressForPlatform(platform_id, "clCommandNDRangeKernelKHR");
+    solver->finalize_command_buffer = (clFinalizeCommandBufferKHR_fn)clGetExtensionFunctionAddressForPlatform(platform_id, "clFinalizeCommandBufferKHR");
+    solver->enqueue_command_buffer = (clEnqueueCommandBufferKHR_fn)clGetExtensionFunctionAddressForPlatform(platform_id, "clEnqueueCommandBufferKHR");
+    solver->release_command_buffer = (clReleaseCommandBufferKHR_fn)clGetExtensionFunctionAddressForPlatform(platform_id, "clReleaseCommandBufferKHR");
+    solver->command_buffer_supported = solver->create_command_buffer != NULL && solver->command_ndrange_kernel != NULL && solver->finalize_command_buffer != NULL && solver->enqueue_command_buffer != NULL && solver->release_command_buffer != NULL;
+#else
+    (void)solver;
+    (void)platform_id;
+#endif
 }
 
-void print_matrix(float* matrix, int size) {
-    for (int i = 0; i < size; i++) {
-        for (int j = 0; j < size; j++) {
-            printf("%.2f ", matrix[i * size + j]);
-        }
-        printf("\n");
+static void discard_command_buffer(gauss_solver* solver) {
+#ifdef cl_khr_command_buffer
+    if (solver->command_buffer != NULL) {
+        solver->release_command_buffer(solver->command_buffer);
+        solver->command_buffer = NULL;
     }
+#else
+    (void)solver;
+#endif
 }
 
-void calculate_determinant_gauss(float* matrix, int size, float* out_mantissa, long long* out_exponent, int* out_sign) {
-    int sign = 1;
+gauss_solver* gauss_solver_create(int* error_code) {
+    cl_int err;
+    cl_platform_id platform_id;
+    cl_uint n_platforms, n_devices;
 
-    for (int pivot_index = 0; pivot_index < size - 1; pivot_index++) {
-        int max_row = pivot_index;
-        float max_value = fabs(matrix[pivot_index * size + pivot_index]);
+    gauss_solver* solver = (gauss_solver*)calloc(1, sizeof(gauss_solver));
+    if (solver == NULL) {
+        *error_code = -1;
+        return NULL;
+    }
 
-        for (int row = pivot_index + 1; row < size; row++) {
-            if (fabs(matrix[row * size + pivot_index]) > max_value) {
-                max_value = fabs(matrix[row * size + pivot_index]);
-                max_row = row;
-            }
-        }
+    clGetPlatformIDs(1, &platform_id, &n_platforms);
+    err = clGetDeviceIDs(platform_id, CL_DEVICE_TYPE_GPU, 1, &solver->device_id, &n_devices);
+    if (err != CL_SUCCESS) {
+        err = clGetDeviceIDs(platform_id, CL_DEVICE_TYPE_CPU, 1, &solver->device_id, &n_devices);
+    }
+    if (err != CL_SUCCESS) {
+        free(solver);
+        *error_code = err;
+        return NULL;
+    }
 
-        if (max_value < 1e-12) {
-            *out_mantissa = 0.0;
-            *out_exponent = 0;
-            *out_sign = 1;
-            return;
-        }
+    solver->context = clCreateContext(NULL, 1, &solver->device_id, NULL, NULL, &err);
 
-        if (max_row != pivot_index) {
-            for (int col = 0; col < size; col++) {
-                float temp = matrix[pivot_index * size + col];
-                matrix[pivot_index * size + col] = matrix[max_row * size + col];
-                matrix[max_row * size + col] = temp;
-            }
-            sign = -sign; 
-        }
+    cl_queue_properties props[] = {CL_QUEUE_PROPERTIES, CL_QUEUE_PROFILING_ENABLE, 0};
+    solver->queue = clCreateCommandQueueWithProperties(solver->context, solver->device_id, props, &err);
 
-        float pivot = matrix[pivot_index * size + pivot_index];
-    
-        for (int row = pivot_index + 1; row < size; row++) {
-            float factor = matrix[row * size + pivot_index] / pivot;
-            
-            for (int col = pivot_index + 1; col < size; col++) {
-                matrix[row * size + col] -= factor * matrix[pivot_index * size + col];
-            }
-            
-            matrix[row * size + pivot_index] = 0.0f;
-        }
+    int load_error;
+    char* kernel_code = load_kernel_source(KERNEL_SOURCE_PATH, &load_error);
+    if (load_error != 0) {
+        kernel_code = load_kernel_source("sample.cl", &load_error);
+    }
+    if (load_error != 0) {
+        gauss_solver_release(solver);
+        *error_code = load_error;
+        return NULL;
     }
 
-    float mantissa = 1.0;
-    long long exponent = 0;
+    size_t max_work_group_size = 1;
+    clGetDeviceInfo(solver->device_id, CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(max_work_group_size), &max_work_group_size, NULL);
+    solver->pivot_group_size = PIVOT_GROUP_SIZE;
+    while (solver->pivot_group_size > 1 && (size_t)solver->pivot_group_size > max_work_group_size) {
+        solver->pivot_group_size /= 2;
+    }
 
-    for (int diag_index = 0; diag_index < size; diag_index++) {
-        float value = matrix[diag_index * size + diag_index];
+    solver->elimination_tile = ELIMINATION_TILE;
+    while (solver->elimination_tile > 1 && (size_t)(solver->elimination_tile * solver->elimination_tile) > max_work_group_size) {
+        solver->elimination_tile /= 2;
+    }
 
-        if (fabs(value) < 1e-12) {
-            mantissa = 0.0;
-            exponent = 0; 
-            break;
-        }
+    solver->batch_group_size = BATCH_GROUP_SIZE;
+    while (solver->batch_group_size > 1 && (size_t)solver->batch_group_size > max_work_group_size) {
+        solver->batch_group_size /= 2;
+    }
 
-        if (value < 0) {
-            sign = -sign;
-            value = -value;
-        }
+    cl_ulong local_memory_size = 0;
+    clGetDeviceInfo(solver->device_id, CL_DEVICE_LOCAL_MEM_SIZE, sizeof(local_memory_size), &local_memory_size, NULL);
+    size_t reduction_bytes = (size_t)solver->pivot_group_size * (sizeof(float) + sizeof(int));
+    solver->persistent_size_limit = local_memory_size > reduction_bytes ? (int)((local_memory_size - reduction_bytes) / (2 * sizeof(float))) : 0;
+    solver->persistent_max_size = PERSISTENT_MAX_SIZE;
+
+    char build_options[128];
+    snprintf(build_options, sizeof(build_options), "-D PIVOT_GROUP_SIZE=%d -D ELIMINATION_TILE=%d -D BATCH_GROUP_SIZE=%d -D BATCH_MAX_SIZE=%d", solver->pivot_group_size, solver->elimination_tile, solver->batch_group_size, BATCH_MAX_SIZE);
+
+    int build_error;
+    double start_build = wall_clock_seconds();
+    solver->program = build_program_cached(solver->context, solver->device_id, kernel_code, build_options, KERNEL_CACHE_DIR, &solver->program_from_cache, &build_error);
+    solver->time_build = (float)(wall_clock_seconds() - start_build);
+    free(kernel_code);
+    if (solver->program == NULL) {
+        gauss_solver_release(solver);
+        *error_code = build_error;
+        return NULL;
+    }
+
+    solver->kernel_pivot_search = clCreateKernel(solver->program, "pivot_search", &err);
+    solver->kernel_pivot_swap = clCreateKernel(solver->program, "pivot_select_and_swap", &err);
+    solver->kernel_eliminate = clCreateKernel(solver->program, "eliminate_tiled", &err);
+    solver->kernel_persistent = clCreateKernel(solver->program, "eliminate_persistent", &err);
+    solver->kernel_batched = clCreateKernel(solver->program, "batched_determinant", &err);
+    solver->kernel_determinant = clCreateKernel(solver->program, "diagonal_determinant", &err);
 
-        mantissa *= value;
+    int initial_sign = 1;
+    solver->gpu_sign = clCreateBuffer(solver->context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, sizeof(int), &initial_sign, &err);
+    solver->gpu_result_mantissa = clCreateBuffer(solver->context, CL_MEM_READ_WRITE, sizeof(float), NULL, &err);
+    solver->gpu_result_exponent = clCreateBuffer(solver->context, CL_MEM_READ_WRITE, sizeof(int), NULL, &err);
+    solver->gpu_step = clCreateBuffer(solver->context, CL_MEM_READ_WRITE, sizeof(int), NULL, &err);
+
+    solver->use_command_buffer = 1;
+    load_command_buffer_functions(solver, platform_id);
+
+    *error_code = 0;
+    return solver;
+}
 
-        while (mantissa >= 10.0) {
-            mantissa /= 10.0;
-            exponent++;
+static cl_int reserve_solver_buffers(gauss_solver* solver, int size) {
+    cl_int err = CL_SUCCESS;
+
+    size_t required = (size_t)size * size * sizeof(float);
+    if (required > solver->gpu_matrix_capacity) {
+        solver->bound_size = 0;
+        if (solver->gpu_matrix != NULL) {
+            clReleaseMemObject(solver->gpu_matrix);
+            solver->gpu_matrix = NULL;
+            solver->gpu_matrix_capacity = 0;
         }
-        while (mantissa < 1.0 && mantissa > 0.0) {
-            mantissa *= 10.0;
-            exponent--;
+
+        solver->gpu_matrix = clCreateBuffer(solver->context, CL_MEM_READ_WRITE, required, NULL, &err);
+        if (err != CL_SUCCESS) {
+            return err;
         }
+        solver->gpu_matrix_capacity = required;
+    }
+
+    size_t vector_length = size > PIVOT_MAX_GROUPS ? (size_t)size : PIVOT_MAX_GROUPS;
+    if (vector_length > solver->gpu_vector_capacity) {
+        solver->bound_size = 0;
+        if (solver->gpu_factors != NULL) clReleaseMemObject(solver->gpu_factors);
+        if (solver->gpu_group_values != NULL) clReleaseMemObject(solver->gpu_group_values);
+        if (solver->gpu_group_rows != NULL) clReleaseMemObject(solver->gpu_group_rows);
+        solver->gpu_vector_capacity = 0;
+
+        cl_int factors_err, values_err, rows_err;
+        solver->gpu_factors = clCreateBuffer(solver->context, CL_MEM_READ_WRITE, vector_length * sizeof(float), NULL, &factors_err);
+        solver->gpu_group_values = clCreateBuffer(solver->context, CL_MEM_READ_WRITE, vector_length * sizeof(float), NULL, &values_err);
+        solver->gpu_group_rows = clCreateBuffer(solver->context, CL_MEM_READ_WRITE, vector_length * sizeof(int), NULL, &rows_err);
+        if (factors_err != CL_SUCCESS) return factors_err;
+        if (values_err != CL_SUCCESS) return values_err;
+        if (rows_err != CL_SUCCESS) return rows_err;
+        solver->gpu_vector_capacity = vector_length;
     }
 
-    *out_mantissa = mantissa;
-    *out_exponent = exponent;
-    *out_sign = sign;
+    return err;
 }
 
-void calculate_determinant_gauss_opencl(float* matrix, int size, float* out_mantissa, long long* out_exponent, int* out_sign, float* out_time_write, float* out_time_calc, float* out_time_read) {
-    cl_int err;
-    cl_platform_id platform_id;
-    cl_device_id device_id;
-    cl_uint n_platforms, n_devices;
+static void bind_elimination_args(gauss_solver* solver, int size, int search_groups) {
+    int first_pivot = 0;
+
+    clSetKernelArg(solver->kernel_pivot_search, 0, sizeof(cl_mem), &solver->gpu_matrix);
+    clSetKernelArg(solver->kernel_pivot_search, 1, sizeof(int), &first_pivot);
+    clSetKernelArg(solver->kernel_pivot_search, 2, sizeof(int), &size);
+    clSetKernelArg(solver->kernel_pivot_search, 3, sizeof(cl_mem), &solver->gpu_group_values);
+    clSetKernelArg(solver->kernel_pivot_search, 4, sizeof(cl_mem), &solver->gpu_group_rows);
+
+    clSetKernelArg(solver->kernel_pivot_swap, 0, sizeof(cl_mem), &solver->gpu_matrix);
+    clSetKernelArg(solver->kernel_pivot_swap, 1, sizeof(cl_mem), &solver->gpu_step);
+    clSetKernelArg(solver->kernel_pivot_swap, 2, sizeof(int), &size);
+    clSetKernelArg(solver->kernel_pivot_swap, 3, sizeof(cl_mem), &solver->gpu_group_values);
+    clSetKernelArg(solver->kernel_pivot_swap, 4, sizeof(cl_mem), &solver->gpu_group_rows);
+    clSetKernelArg(solver->kernel_pivot_swap, 5, sizeof(int), &search_groups);
+    clSetKernelArg(solver->kernel_pivot_swap, 6, sizeof(cl_mem), &solver->gpu_sign);
+    clSetKernelArg(solver->kernel_pivot_swap, 7, sizeof(cl_mem), &solver->gpu_factors);
+
+    clSetKernelArg(solver->kernel_eliminate, 0, sizeof(cl_mem), &solver->gpu_matrix);
+    clSetKernelArg(solver->kernel_eliminate, 1, sizeof(cl_mem), &solver->gpu_step);
+    clSetKernelArg(solver->kernel_eliminate, 2, sizeof(int), &size);
+    clSetKernelArg(solver->kernel_eliminate, 3, sizeof(cl_mem), &solver->gpu_factors);
+    clSetKernelArg(solver->kernel_eliminate, 4, sizeof(cl_mem), &solver->gpu_group_values);
+    clSetKernelArg(solver->kernel_eliminate, 5, sizeof(cl_mem), &solver->gpu_group_rows);
+
+    clSetKernelArg(solver->kernel_persistent, 0, sizeof(cl_mem), &solver->gpu_matrix);
+    clSetKernelArg(solver->kernel_persistent, 1, sizeof(int), &size);
+    clSetKernelArg(solver->kernel_persistent, 2, sizeof(cl_mem), &solver->gpu_sign);
+    clSetKernelArg(solver->kernel_persistent, 3, size * sizeof(float), NULL);
+    clSetKernelArg(solver->kernel_persistent, 4, size * sizeof(float), NULL);
+
+    clSetKernelArg(solver->kernel_determinant, 0, sizeof(cl_mem), &solver->gpu_matrix);
+    clSetKernelArg(solver->kernel_determinant, 1, sizeof(int), &size);
+    clSetKernelArg(solver->kernel_determinant, 2, sizeof(cl_mem), &solver->gpu_sign);
+    clSetKernelArg(solver->kernel_determinant, 3, sizeof(cl_mem), &solver->gpu_result_mantissa);
+    clSetKernelArg(solver->kernel_determinant, 4, sizeof(cl_mem), &solver->gpu_result_exponent);
+
+    discard_command_buffer(solver);
+    solver->bound_size = size;
+}
 
-    clGetPlatformIDs(1, &platform_id, &n_platforms);
-    err = clGetDeviceIDs(platform_id, CL_DEVICE_TYPE_GPU, 1, &device_id, &n_devices);
+static cl_int record_elimination(gauss_solver* solver, int size, size_t search_work_size) {
+#ifdef cl_khr_command_buffer
+    if (solver->command_buffer != NULL) {
+        return CL_SUCCESS;
+    }
+
+    cl_int err;
+    cl_command_buffer_khr command_buffer = solver->create_command_buffer(1, &solver->queue, NULL, &err);
     if (err != CL_SUCCESS) {
-        err = clGetDeviceIDs(platform_id, CL_DEVICE_TYPE_CPU, 1, &device_id, &n_devices);
+        return err;
     }
 
-    cl_context context = clCreateContext(NULL, 1, &device_id, NULL, NULL, &err);
-    
-    cl_queue_properties props[] = {CL_QUEUE_PROPERTIES, CL_QUEUE_PROFILING_ENABLE, 0};
-    cl_command_queue queue = clCreateCommandQueueWithProperties(context, device_id, props, &err);
+    size_t pivot_group_size = solver->pivot_group_size;
+    size_t tile = solver->elimination_tile;
+    size_t local_work_size[2] = {tile, tile};
+    cl_sync_point_khr previous, current;
 
-    int error_code;
-    char* kernel_code = load_kernel_source("kernel/sample.cl", &error_code);
-    if (error_code != 0) {
-        kernel_code = load_kernel_source("sample.cl", &error_code);
+    err = solver->command_ndrange_kernel(command_buffer, NULL, NULL, solver->kernel_pivot_search, 1, NULL, &search_work_size, &pivot_group_size, 0, NULL, &previous, NULL);
+    for (int pivot_index = 0; pivot_index < size - 1 && err == CL_SUCCESS; pivot_index++) {
+        err = solver->command_ndrange_kernel(command_buffer, NULL, NULL, solver->kernel_pivot_swap, 1, NULL, &pivot_group_size, &pivot_group_size, 1, &previous, &current, NULL);
+        if (err != CL_SUCCESS) {
+            break;
+        }
+
+        size_t tiles = (size - 1 - pivot_index + tile - 1) / tile;
+        size_t global_work_size[2] = {tiles * tile, tiles * tile};
+        err = solver->command_ndrange_kernel(command_buffer, NULL, NULL, solver->kernel_eliminate, 2, NULL, global_work_size, local_work_size, 1, &current, &previous, NULL);
     }
 
-    cl_program program = clCreateProgramWithSource(context, 1, (const char**)&kernel_code, NULL, &err);
-    free(kernel_code);
-    clBuildProgram(program, 1, &device_id, NULL, NULL, NULL);
+    if (err == CL_SUCCESS) {
+        err = solver->finalize_command_buffer(command_buffer);
+    }
+    if (err != CL_SUCCESS) {
+        solver->release_command_buffer(command_buffer);
+        return err;
+    }
+
+    solver->command_buffer = command_buffer;
+    return CL_SUCCESS;
+#else
+    (void)solver;
+    (void)size;
+    (void)search_work_size;
+    return CL_INVALID_OPERATION;
+#endif
+}
+
+static int enqueue_recorded_elimination(gauss_solver* solver, cl_event* event) {
+#ifdef cl_khr_command_buffer
+    return solver->enqueue_command_buffer(0, NULL, solver->command_buffer, 0, NULL, event) == CL_SUCCESS;
+#else
+    (void)solver;
+    (void)event;
+    return 0;
+#endif
+}
 
-    cl_kernel kernel_pivot = clCreateKernel(program, "pivot_and_swap", &err);
-    cl_kernel kernel_gauss = clCreateKernel(program, "calculate_determinant_gauss", &err);
+void gauss_solver_calculate_determinant(gauss_solver* solver, float* matrix, int size, float* out_mantissa, long long* out_exponent, int* out_sign, float* out_time_write, float* out_time_calc, float* out_time_read) {
+    cl_command_queue queue = solver->queue;
+    cl_kernel kernel_pivot_search = solver->kernel_pivot_search;
+    cl_kernel kernel_pivot_swap = solver->kernel_pivot_swap;
+    cl_kernel kernel_eliminate = solver->kernel_eliminate;
+
+    if (reserve_solver_buffers(solver, size) != CL_SUCCESS) {
+        *out_mantissa = 0.0;
+        *out_exponent = 0;
+        *out_sign = 1;
+        return;
+    }
+    cl_mem gpu_matrix = solver->gpu_matrix;
+    cl_mem gpu_sign = solver->gpu_sign;
+    size_t pivot_group_size = solver->pivot_group_size;
+    size_t tile = solver->elimination_tile;
+
+    cl_event write_event, elimination_event;
+    cl_event* kernel_events = (cl_event*)malloc(size * sizeof(cl_event));
+    cl_event* pivot_events = (cl_event*)malloc(size * sizeof(cl_event));
+
+    size_t search_groups = (size + pivot_group_size - 1) / pivot_group_size;
+    if (search_groups > PIVOT_MAX_GROUPS) {
+        search_groups = PIVOT_MAX_GROUPS;
+    }
+    size_t search_work_size = search_groups * pivot_group_size;
+
+    if (solver->bound_size != size) {
+        bind_elimination_args(solver, size, (int)search_groups);
+    }
 
-    cl_event write_event, read_event;
-    cl_event* kernel_events = (cl_event*)malloc((size - 1) * sizeof(cl_event));
+    int persistent = size > 1 && size <= solver->persistent_max_size && size <= solver->persistent_size_limit;
+    int replay = !persistent && size > 1 && solver->use_command_buffer && solver->command_buffer_supported && solver->profiler == NULL;
+    if (replay && record_elimination(solver, size, search_work_size) != CL_SUCCESS) {
+        solver->command_buffer_supported = 0;
+        replay = 0;
+    }
 
-    cl_mem gpu_matrix = clCreateBuffer(context, CL_MEM_READ_WRITE, size * size * sizeof(float), NULL, &err);
     clEnqueueWriteBuffer(queue, gpu_matrix, CL_FALSE, 0, size * size * sizeof(float), matrix, 0, NULL, &write_event);
-    
+
     int initial_sign = 1;
-    cl_mem gpu_sign = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, sizeof(int), &initial_sign, &err);
-
-    for (int pivot_index = 0; pivot_index < size - 1; pivot_index++) {
-        clSetKernelArg(kernel_pivot, 0, sizeof(cl_mem), &gpu_matrix);
-        clSetKernelArg(kernel_pivot, 1, sizeof(int), &pivot_index);
-        clSetKernelArg(kernel_pivot, 2, sizeof(int), &size);
-        clSetKernelArg(kernel_pivot, 3, sizeof(cl_mem), &gpu_sign);
-        size_t pivot_work_size = 1;
-        clEnqueueNDRangeKernel(queue, kernel_pivot, 1, NULL, &pivot_work_size, NULL, 0, NULL, NULL);
-
-        clSetKernelArg(kernel_gauss, 0, sizeof(cl_mem), &gpu_matrix);
-        clSetKernelArg(kernel_gauss, 1, sizeof(int), &pivot_index);
-        clSetKernelArg(kernel_gauss, 2, sizeof(int), &size);
-        size_t global_work_size[2] = {size - 1 - pivot_index, size - 1 - pivot_index};
-        if (global_work_size[0] > 0 && global_work_size[1] > 0) {
-            clEnqueueNDRangeKernel(queue, kernel_gauss, 2, NULL, global_work_size, NULL, 0, NULL, &kernel_events[pivot_index]);
+    int initial_step = 0;
+    cl_event state_events[2];
+    clEnqueueWriteBuffer(queue, gpu_sign, CL_FALSE, 0, sizeof(int), &initial_sign, 0, NULL, &state_events[0]);
+    clEnqueueWriteBuffer(queue, solver->gpu_step, CL_FALSE, 0, sizeof(int), &initial_step, 0, NULL, &state_events[1]);
+
+    double start_enqueue = wall_clock_seconds();
+    if (persistent) {
+        clEnqueueNDRangeKernel(queue, solver->kernel_persistent, 1, NULL, &pivot_group_size, &pivot_group_size, 0, NULL, &elimination_event);
+    } else if (replay) {
+        replay = enqueue_recorded_elimination(solver, &elimination_event);
+    }
+
+    if (!persistent && !replay && size > 1) {
+        clEnqueueNDRangeKernel(queue, kernel_pivot_search, 1, NULL, &search_work_size, &pivot_group_size, 0, NULL, &pivot_events[0]);
+
+        size_t local_work_size[2] = {tile, tile};
+        for (int pivot_index = 0; pivot_index < size - 1; pivot_index++) {
+            clEnqueueNDRangeKernel(queue, kernel_pivot_swap, 1, NULL, &pivot_group_size, &pivot_group_size, 0, NULL, &pivot_events[pivot_index + 1]);
+
+            size_t tiles = (size - 1 - pivot_index + tile - 1) / tile;
+            size_t global_work_size[2] = {tiles * tile, tiles * tile};
+            clEnqueueNDRangeKernel(queue, kernel_eliminate, 2, NULL, global_work_size, local_work_size, 0, NULL, &kernel_events[pivot_index]);
         }
     }
-    clFinish(queue);
 
-    clEnqueueReadBuffer(queue, gpu_matrix, CL_TRUE, 0, size * size * sizeof(float), matrix, 0, NULL, &read_event);
+    cl_event reduction_event;
+    clEnqueueNDRangeKernel(queue, solver->kernel_determinant, 1, NULL, &pivot_group_size, &pivot_group_size, 0, NULL, &reduction_event);
+    solver->time_host_enqueue = (float)(wall_clock_seconds() - start_enqueue);
+    solver->used_command_buffer = replay;
+    solver->used_persistent_kernel = persistent;
+
+    cl_event matrix_read_event;
+    if (solver->read_back_matrix) {
+        clEnqueueReadBuffer(queue, gpu_matrix, CL_FALSE, 0, size * size * sizeof(float), matrix, 0, NULL, &matrix_read_event);
+    }
+
+    float binary_mantissa = 0.0f;
+    int binary_exponent = 0;
     int final_gpu_sign = 1;
-    clEnqueueReadBuffer(queue, gpu_sign, CL_TRUE, 0, sizeof(int), &final_gpu_sign, 0, NULL, NULL);
-
-    cl_ulong time_start, time_end;
-    
-    clGetEventProfilingInfo(write_event, CL_PROFILING_COMMAND_START, sizeof(time_start), &time_start, NULL);
-    clGetEventProfilingInfo(write_event, CL_PROFILING_COMMAND_END, sizeof(time_end), &time_end, NULL);
-    float time_write_sec = (float)(time_end - time_start) / 1.0e9;
-
-    clGetEventProfilingInfo(read_event, CL_PROFILING_COMMAND_START, sizeof(time_start), &time_start, NULL);
-    clGetEventProfilingInfo(read_event, CL_PROFILING_COMMAND_END, sizeof(time_end), &time_end, NULL);
-    float time_read_sec = (float)(time_end - time_start) / 1.0e9;
-
-    cl_ulong total_kernel_ns = 0;
-    for (int pivot_index = 0; pivot_index < size - 1; pivot_index++) {
-        if ((size - 1 - pivot_index) > 0) {
-            clGetEventProfilingInfo(kernel_events[pivot_index], CL_PROFILING_COMMAND_START, sizeof(time_start), &time_start, NULL);
-            clGetEventProfilingInfo(kernel_events[pivot_index], CL_PROFILING_COMMAND_END, sizeof(time_end), &time_end, NULL);
-            total_kernel_ns += (time_end - time_start);
-            clReleaseEvent(kernel_events[pivot_index]);
-        }
+    cl_event result_events[3];
+    clEnqueueReadBuffer(queue, solver->gpu_result_mantissa, CL_FALSE, 0, sizeof(float), &binary_mantissa, 0, NULL, &result_events[0]);
+    clEnqueueReadBuffer(queue, solver->gpu_result_exponent, CL_FALSE, 0, sizeof(int), &binary_exponent, 0, NULL, &result_events[1]);
+    clEnqueueReadBuffer(queue, gpu_sign, CL_TRUE, 0, sizeof(int), &final_gpu_sign, 0, NULL, &result_events[2]);
+
+    profiler* profiler = solver->profiler;
+    size_t matrix_bytes = (size_t)size * size * sizeof(float);
+    float time_write_sec = record_event_times(profiler, &write_event, 1, "write_matrix", "upload", (double)matrix_bytes);
+    time_write_sec += record_event_times(profiler, state_events, 2, "write_state", "upload", 2.0 * sizeof(int));
+    float time_read_sec = record_event_times(profiler, result_events, 3, "read_determinant", "download", (double)(sizeof(float) + 2 * sizeof(int)));
+
+    if (solver->read_back_matrix) {
+        time_read_sec += record_event_times(profiler, &matrix_read_event, 1, "read_matrix", "download", (double)matrix_bytes);
+    }
+
+    solver->time_reduction = record_event_times(profiler, &reduction_event, 1, "diagonal_determinant", "reduction", 0.0);
+
+    if (persistent) {
+        solver->time_pivot = 0.0f;
+        solver->time_elimination = record_event_times(profiler, &elimination_event, 1, "eliminate_persistent", "elimination", 0.0);
+    } else if (replay) {
+        solver->time_pivot = 0.0f;
+        solver->time_elimination = record_event_times(profiler, &elimination_event, 1, "elimination_command_buffer", "elimination", 0.0);
+    } else {
+        int pivot_event_count = size > 1 ? size : 0;
+        solver->time_pivot = record_event_times(profiler, pivot_events, pivot_event_count > 0 ? 1 : 0, "pivot_search", "pivot", 0.0);
+        solver->time_pivot += record_event_times(profiler, pivot_events + 1, pivot_event_count > 0 ? pivot_event_count - 1 : 0, "pivot_select_and_swap", "pivot", 0.0);
+        solver->time_elimination = record_event_times(profiler, kernel_events, size - 1, "eliminate_tiled", "elimination", 0.0);
     }
-    float gpu_calc = (float)total_kernel_ns / 1.0e9;
+    float gpu_calc = solver->time_pivot + solver->time_elimination + solver->time_reduction;
 
     if (out_time_write != NULL) {
         *out_time_write = time_write_sec;
@@ -197,55 +414,195 @@ void calculate_determinant_gauss_opencl(float* matrix, int size, float* out_mant
         *out_time_read = time_read_sec;
     }
 
-    float mantissa = 1.0;
-    long long exponent = 0;
-    int sign = 1;
+    binary_to_decimal(binary_mantissa, binary_exponent, out_mantissa, out_exponent);
+    *out_sign = final_gpu_sign;
 
-    for (int diag_index = 0; diag_index < size; diag_index++) {
-        float value = matrix[diag_index * size + diag_index];
+    free(kernel_events);
+    free(pivot_events);
+}
 
-        if (fabs(value) < 1e-12) {
-            mantissa = 0.0;
-            exponent = 0; 
-            break;
-        }
+static cl_int reserve_buffer(cl_context context, cl_mem* buffer, size_t* capacity, size_t required) {
+    if (required <= *capacity && *buffer != NULL) {
+        return CL_SUCCESS;
+    }
 
-        if (value == 0.0) {
-            mantissa = 0.0;
-            exponent = 0; 
-            break;
-        }
+    if (*buffer != NULL) {
+        clReleaseMemObject(*buffer);
+        *buffer = NULL;
+        *capacity = 0;
+    }
+
+    cl_int err;
+    *buffer = clCreateBuffer(context, CL_MEM_READ_WRITE, required, NULL, &err);
+    if (err == CL_SUCCESS) {
+        *capacity = required;
+    }
+    return err;
+}
+
+static cl_int reserve_batch_buffers(gauss_solver* solver, size_t total_elements, int batch_count) {
+    cl_int err = reserve_buffer(solver->context, &solver->gpu_batch_matrices, &solver->gpu_batch_matrices_capacity, total_elements * sizeof(float));
+    if (err != CL_SUCCESS) {
+        return err;
+    }
+
+    if ((size_t)batch_count <= solver->gpu_batch_capacity) {
+        return CL_SUCCESS;
+    }
+
+    cl_mem* buffers[5] = {&solver->gpu_batch_sizes, &solver->gpu_batch_offsets, &solver->gpu_batch_mantissas, &solver->gpu_batch_exponents, &solver->gpu_batch_signs};
+    size_t element_sizes[5] = {sizeof(cl_int), sizeof(cl_long), sizeof(cl_float), sizeof(cl_int), sizeof(cl_int)};
 
-        if (value < 0) {
-            sign = -sign;
-            value = -value;
+    solver->gpu_batch_capacity = 0;
+    for (int i = 0; i < 5; i++) {
+        size_t capacity = 0;
+        err = reserve_buffer(solver->context, buffers[i], &capacity, batch_count * element_sizes[i]);
+        if (err != CL_SUCCESS) {
+            return err;
         }
+    }
+    solver->gpu_batch_capacity = batch_count;
+
+    return CL_SUCCESS;
+}
 
-        mantissa *= value;
+void gauss_solver_calculate_determinants_batched(gauss_solver* solver, const float* matrices, int batch_count, int size, const int* sizes, const long long* offsets, float* out_mantissas, long long* out_exponents, int* out_signs, float* out_time_calc, int* error_code) {
+    if (batch_count <= 0) {
+        *error_code = 0;
+        return;
+    }
 
-        while (mantissa >= 10.0) {
-            mantissa /= 10.0;
-            exponent++;
+    cl_int* host_sizes = (cl_int*)malloc(batch_count * sizeof(cl_int));
+    cl_long* host_offsets = (cl_long*)malloc(batch_count * sizeof(cl_long));
+    float* host_mantissas = (float*)malloc(batch_count * sizeof(float));
+    cl_int* host_exponents = (cl_int*)malloc(batch_count * sizeof(cl_int));
+    if (host_sizes == NULL || host_offsets == NULL || host_mantissas == NULL || host_exponents == NULL) {
+        free(host_sizes);
+        free(host_offsets);
+        free(host_mantissas);
+        free(host_exponents);
+        *error_code = -1;
+        return;
+    }
+
+    size_t total_elements = 0;
+    for (int i = 0; i < batch_count; i++) {
+        host_sizes[i] = sizes != NULL ? sizes[i] : size;
+        host_offsets[i] = offsets != NULL ? offsets[i] : (cl_long)i * size * size;
+
+        size_t end = (size_t)host_offsets[i] + (size_t)host_sizes[i] * host_sizes[i];
+        if (end > total_elements) {
+            total_elements = end;
         }
 
-        while (mantissa < 1.0 && mantissa > 0.0) {
-            mantissa *= 10.0;
-            exponent--;
+        if (host_sizes[i] < 1 || host_sizes[i] > BATCH_MAX_SIZE || host_offsets[i] < 0) {
+            free(host_sizes);
+            free(host_offsets);
+            free(host_mantissas);
+            free(host_exponents);
+            *error_code = CL_INVALID_VALUE;
+            return;
         }
     }
 
-    sign *= final_gpu_sign;
+    cl_int err = reserve_batch_buffers(solver, total_elements, batch_count);
+    if (err != CL_SUCCESS) {
+        free(host_sizes);
+        free(host_offsets);
+        free(host_mantissas);
+        free(host_exponents);
+        *error_code = err;
+        return;
+    }
+
+    cl_command_queue queue = solver->queue;
+    cl_kernel kernel_batched = solver->kernel_batched;
+
+    cl_event write_events[3];
+    clEnqueueWriteBuffer(queue, solver->gpu_batch_matrices, CL_FALSE, 0, total_elements * sizeof(float), matrices, 0, NULL, &write_events[0]);
+    clEnqueueWriteBuffer(queue, solver->gpu_batch_sizes, CL_FALSE, 0, batch_count * sizeof(cl_int), host_sizes, 0, NULL, &write_events[1]);
+    clEnqueueWriteBuffer(queue, solver->gpu_batch_offsets, CL_FALSE, 0, batch_count * sizeof(cl_long), host_offsets, 0, NULL, &write_events[2]);
+
+    clSetKernelArg(kernel_batched, 0, sizeof(cl_mem), &solver->gpu_batch_matrices);
+    clSetKernelArg(kernel_batched, 1, sizeof(cl_mem), &solver->gpu_batch_sizes);
+    clSetKernelArg(kernel_batched, 2, sizeof(cl_mem), &solver->gpu_batch_offsets);
+    clSetKernelArg(kernel_batched, 3, sizeof(cl_mem), &solver->gpu_batch_mantissas);
+    clSetKernelArg(kernel_batched, 4, sizeof(cl_mem), &solver->gpu_batch_exponents);
+    clSetKernelArg(kernel_batched, 5, sizeof(cl_mem), &solver->gpu_batch_signs);
+
+    cl_event kernel_event;
+    size_t local_work_size = solver->batch_group_size;
+    size_t global_work_size = (size_t)batch_count * solver->batch_group_size;
+    clEnqueueNDRangeKernel(queue, kernel_batched, 1, NULL, &global_work_size, &local_work_size, 0, NULL, &kernel_event);
+
+    cl_event read_events[3];
+    clEnqueueReadBuffer(queue, solver->gpu_batch_mantissas, CL_FALSE, 0, batch_count * sizeof(float), host_mantissas, 0, NULL, &read_events[0]);
+    clEnqueueReadBuffer(queue, solver->gpu_batch_exponents, CL_FALSE, 0, batch_count * sizeof(cl_int), host_exponents, 0, NULL, &read_events[1]);
+    clEnqueueReadBuffer(queue, solver->gpu_batch_signs, CL_TRUE, 0, batch_count * sizeof(cl_int), out_signs, 0, NULL, &read_events[2]);
+
+    record_event_times(solver->profiler, &write_events[0], 1, "write_batch_matrices", "upload", (double)(total_elements * sizeof(float)));
+    record_event_times(solver->profiler, &write_events[1], 2, "write_batch_layout", "upload", (double)(batch_count * (sizeof(cl_int) + sizeof(cl_long))));
+    float time_calc = record_event_times(solver->profiler, &kernel_event, 1, "batched_determinant", "batched", 0.0);
+    record_event_times(solver->profiler, read_events, 3, "read_batch_results", "download", (double)(batch_count * (sizeof(float) + 2 * sizeof(cl_int))));
+    if (out_time_calc != NULL) {
+        *out_time_calc = time_calc;
+    }
 
-    *out_mantissa = mantissa;
-    *out_exponent = exponent;
-    *out_sign = sign;
+    for (int i = 0; i < batch_count; i++) {
+        binary_to_decimal(host_mantissas[i], host_exponents[i], &out_mantissas[i], &out_exponents[i]);
+    }
 
-    free(kernel_events);
-    clReleaseMemObject(gpu_matrix);
-    clReleaseMemObject(gpu_sign);
-    clReleaseKernel(kernel_pivot);
-    clReleaseKernel(kernel_gauss);
-    clReleaseProgram(program);
-    clReleaseCommandQueue(queue);
-    clReleaseContext(context);
+    free(host_sizes);
+    free(host_offsets);
+    free(host_mantissas);
+    free(host_exponents);
+    *error_code = 0;
+}
+
+void gauss_solver_release(gauss_solver* solver) {
+    if (solver == NULL) {
+        return;
+    }
+
+    discard_command_buffer(solver);
+    if (solver->gpu_matrix != NULL) clReleaseMemObject(solver->gpu_matrix);
+    if (solver->gpu_sign != NULL) clReleaseMemObject(solver->gpu_sign);
+    if (solver->gpu_step != NULL) clReleaseMemObject(solver->gpu_step);
+    if (solver->gpu_factors != NULL) clReleaseMemObject(solver->gpu_factors);
+    if (solver->gpu_group_values != NULL) clReleaseMemObject(solver->gpu_group_values);
+    if (solver->gpu_group_rows != NULL) clReleaseMemObject(solver->gpu_group_rows);
+    if (solver->kernel_pivot_search != NULL) clReleaseKernel(solver->kernel_pivot_search);
+    if (solver->kernel_pivot_swap != NULL) clReleaseKernel(solver->kernel_pivot_swap);
+    if (solver->kernel_eliminate != NULL) clReleaseKernel(solver->kernel_eliminate);
+    if (solver->kernel_persistent != NULL) clReleaseKernel(solver->kernel_persistent);
+    if (solver->kernel_batched != NULL) clReleaseKernel(solver->kernel_batched);
+    if (solver->kernel_determinant != NULL) clReleaseKernel(solver->kernel_determinant);
+    if (solver->gpu_result_mantissa != NULL) clReleaseMemObject(solver->gpu_result_mantissa);
+    if (solver->gpu_result_exponent != NULL) clReleaseMemObject(solver->gpu_result_exponent);
+    if (solver->gpu_batch_matrices != NULL) clReleaseMemObject(solver->gpu_batch_matrices);
+    if (solver->gpu_batch_sizes != NULL) clReleaseMemObject(solver->gpu_batch_sizes);
+    if (solver->gpu_batch_offsets != NULL) clReleaseMemObject(solver->gpu_batch_offsets);
+    if (solver->gpu_batch_mantissas != NULL) clReleaseMemObject(solver->gpu_batch_mantissas);
+    if (solver->gpu_batch_exponents != NULL) clReleaseMemObject(solver->gpu_batch_exponents);
+    if (solver->gpu_batch_signs != NULL) clReleaseMemObject(solver->gpu_batch_signs);
+    if (solver->program != NULL) clReleaseProgram(solver->program);
+    if (solver->queue != NULL) clReleaseCommandQueue(solver->queue);
+    if (solver->context != NULL) clReleaseContext(solver->context);
+    free(solver);
+}
+
+void calculate_determinant_gauss_opencl(float* matrix, int size, float* out_mantissa, long long* out_exponent, int* out_sign, float* out_time_write, float* out_time_calc, float* out_time_read) {
+    int error_code;
+    gauss_solver* solver = gauss_solver_create(&error_code);
+    if (solver == NULL) {
+        printf("Failed to initialize OpenCL solver (error %d)\n", error_code);
+        *out_mantissa = 0.0;
+        *out_exponent = 0;
+        *out_sign = 1;
+        return;
+    }
+
+    gauss_solver_calculate_determinant(solver, matrix, size, out_mantissa, out_exponent, out_sign, out_time_write, out_time_calc, out_time_read);
+
+    gauss_solver_release(solver);
 }
@@ -7,9 +7,14 @@
 #include <cmocka.h>
 
 #include "matrix.h"
+#include "cpu_solver.h"
+#include "simd_kernels.h"
+#include "scaled_product.h"
+#include "matrix_file.h"
 
 #include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #ifdef _WIN32
@@ -95,6 +100,144 @@ static void test_cpu_determinant_6x6_zero() {
     assert_true(fabs(result - 0.0) < 0.0001);
 }
 
+static void test_cpu_blocked_determinant_4x4() {
+    float test_matrix[16] = {
+        4, 4, 4, 4,
+        6, 4, 1, 9,
+        5, 6, 6, 5,
+        9, 2, 6, 8
+    };
+
+    float mantissa = 0.0f;
+    long long int exponent = 0;
+    int sign = 1;
+
+    calculate_determinant_blocked(test_matrix, 4, 2, &mantissa, &exponent, &sign);
+    double result = (double)sign * (double)mantissa * pow(10.0, (double)exponent);
+
+    assert_true(fabs(result - 36.0) < 0.0001);
+}
+
+static void test_cpu_blocked_determinant_6x6_zero() {
+    float test_matrix[36] = {
+        1, 2, 3, 4, 5, 6,
+        1, 2, 3, 4, 5, 6,  
+        0, 0, 1, 0, 0, 0,
+        0, 0, 0, 1, 0, 0,
+        0, 0, 0, 0, 1, 0,
+        0, 0, 0, 0, 0, 1
+    };
+
+    float mantissa = 0.0f;
+    long long int exponent = 0;
+    int sign = 1;
+
+    calculate_determinant_blocked(test_matrix, 6, 3, &mantissa, &exponent, &sign);
+    double result = (double)sign * (double)mantissa * pow(10.0, (double)exponent);
+
+    assert_true(fabs(result - 0.0) < 0.0001);
+}
+
+static void test_cpu_blocked_matches_naive() {
+    int size = 200;
+    float* naive_matrix = malloc(size * size * sizeof(float));
+    float* blocked_matrix = malloc(size * size * sizeof(float));
+    assert_non_null(naive_matrix);
+    assert_non_null(blocked_matrix);
+
+    generate_matrix(naive_matrix, size);
+    memcpy(blocked_matrix, naive_matrix, size * size * sizeof(float));
+
+    float naive_mantissa = 0.0f, blocked_mantissa = 0.0f;
+    long long int naive_exponent = 0, blocked_exponent = 0;
+    int naive_sign = 1, blocked_sign = 1;
+
+    calculate_determinant_gauss(naive_matrix, size, &naive_mantissa, &naive_exponent, &naive_sign);
+    calculate_determinant_blocked(blocked_matrix, size, 4, &blocked_mantissa, &blocked_exponent, &blocked_sign);
+
+    assert_int_equal(blocked_sign, naive_sign);
+    double ratio = ((double)blocked_mantissa / (double)naive_mantissa) * pow(10.0, (double)(blocked_exponent - naive_exponent));
+    assert_true(fabs(ratio - 1.0) < 1e-3);
+
+    free(naive_matrix);
+    free(blocked_matrix);
+}
+
+static void test_simd_kernels_match_scalar() {
+    float source[185];
+    float reference[37];
+    float target[37];
+
+    for (int i = 0; i < 185; i++) {
+        source[i] = (float)((i * 37) % 101 - 50);
+    }
+    source[5 * 29] = 75.0f;
+    source[5 * 33] = -75.0f;
+
+    const simd_kernels* scalar = get_simd_kernels(SIMD_SCALAR);
+    assert_non_null(scalar);
+    assert_int_equal(scalar->argmax_abs(source, 5, 37), 29);
+
+    for (int isa = SIMD_SCALAR; isa < SIMD_ISA_COUNT; isa++) {
+        const simd_kernels* kernels = get_simd_kernels((simd_isa)isa);
+        if (kernels == NULL) {
+            continue;
+        }
+
+        assert_int_equal(kernels->argmax_abs(source, 5, 37), 29);
+        assert_int_equal(kernels->argmax_abs(source, 1, 185), scalar->argmax_abs(source, 1, 185));
+
+        for (int i = 0; i < 37; i++) {
+            reference[i] = (float)i;
+            target[i] = (float)i;
+        }
+        scalar->axpy(reference, source, 0.25f, 37);
+        kernels->axpy(target, source, 0.25f, 37);
+        for (int i = 0; i < 37; i++) {
+            assert_true(fabs(target[i] - reference[i]) < 1e-4);
+        }
+    }
+}
+
+static void test_scaled_product_large_and_signed() {
+    float values[1000];
+    for (int i = 0; i < 1000; i++) {
+        values[i] = i % 2 == 0 ? 2.0f : -2.0f;
+    }
+    values[999] = -2.0f;
+
+    scaled_product product;
+    float mantissa;
+    long long exponent;
+    int sign;
+
+    scaled_product_init(&product);
+    scaled_product_multiply_strided(&product, values, 1000, 1);
+    scaled_product_to_decimal(&product, &mantissa, &exponent, &sign);
+
+    assert_int_equal(exponent, 301);
+    assert_true(fabs(mantissa - 1.0715086f) < 1e-5);
+    assert_int_equal(sign, 1);
+
+    scaled_product_init(&product);
+    scaled_product_multiply_strided(&product, values, 999, 1);
+    scaled_product_to_decimal(&product, &mantissa, &exponent, &sign);
+    assert_int_equal(sign, -1);
+
+    scaled_product_multiply(&product, -0.5);
+    scaled_product_to_decimal(&product, &mantissa, &exponent, &sign);
+    assert_int_equal(sign, 1);
+    assert_int_equal(exponent, 300);
+    assert_true(fabs(mantissa - 2.6787715f) < 1e-5);
+
+    values[500] = 0.0f;
+    scaled_product_init(&product);
+    scaled_product_multiply_strided(&product, values, 1000, 1);
+    scaled_product_to_decimal(&product, &mantissa, &exponent, &sign);
+    assert_true(mantissa == 0.0f);
+    assert_int_equal(exponent, 0);
+}
+
 static void test_gpu_determinant_4x4() {
     float test_matrix[16] = {
         4, 4, 4, 4,
@@ -152,14 +295,422 @@ static void test_gpu_determinant_6x6_zero() {
     assert_true(fabs(result - 0.0) < 0.0001);
 }
 
+static void test_gpu_solver_reuse() {
+    float small_matrix[16] = {
+        4, 4, 4, 4,
+        6, 4, 1, 9,
+        5, 6, 6, 5,
+        9, 2, 6, 8
+    };
+    float large_matrix[25] = {
+        2, 0, 0, 0, 0,
+        0, 3, 0, 0, 0,
+        0, 0, 4, 0, 0,
+        0, 0, 0, 5, 0,
+        0, 0, 0, 0, 6
+    };
+    float work_matrix[25];
+
+    float mantissa = 0.0f;
+    long long int exponent = 0;
+    int sign = 1;
+    int error_code;
+
+    gauss_solver* solver = gauss_solver_create(&error_code);
+    assert_non_null(solver);
+
+    for (int run = 0; run < 2; run++) {
+        memcpy(work_matrix, small_matrix, sizeof(small_matrix));
+        gauss_solver_calculate_determinant(solver, work_matrix, 4, &mantissa, &exponent, &sign, NULL, NULL, NULL);
+        double result = (double)sign * (double)mantissa * pow(10.0, (double)exponent);
+        assert_true(fabs(result - 36.0) < 0.0001);
+
+        memcpy(work_matrix, large_matrix, sizeof(large_matrix));
+        gauss_solver_calculate_determinant(solver, work_matrix, 5, &mantissa, &exponent, &sign, NULL, NULL, NULL);
+        result = (double)sign * (double)mantissa * pow(10.0, (double)exponent);
+        assert_true(fabs(result - 720.0) < 0.0001);
+    }
+
+    gauss_solver_release(solver);
+}
+
+static void test_gpu_program_binary_cache() {
+    float test_matrix[16] = {
+        4, 4, 4, 4,
+        6, 4, 1, 9,
+        5, 6, 6, 5,
+        9, 2, 6, 8
+    };
+
+    float mantissa = 0.0f;
+    long long int exponent = 0;
+    int sign = 1;
+    int error_code;
+
+    gauss_solver* first_solver = gauss_solver_create(&error_code);
+    assert_non_null(first_solver);
+    gauss_solver_release(first_solver);
+
+    gauss_solver* cached_solver = gauss_solver_create(&error_code);
+    assert_non_null(cached_solver);
+    assert_int_equal(cached_solver->program_from_cache, 1);
+
+    gauss_solver_calculate_determinant(cached_solver, test_matrix, 4, &mantissa, &exponent, &sign, NULL, NULL, NULL);
+    double result = (double)sign * (double)mantissa * pow(10.0, (double)exponent);
+
+    assert_true(fabs(result - 36.0) < 0.0001);
+
+    gauss_solver_release(cached_solver);
+}
+
+static void test_gpu_batched_uniform() {
+    float base_matrix[16] = {
+        4, 4, 4, 4,
+        6, 4, 1, 9,
+        5, 6, 6, 5,
+        9, 2, 6, 8
+    };
+    const int batch_count = 8;
+    float matrices[8 * 16];
+    float mantissas[8];
+    long long exponents[8];
+    int signs[8];
+    int error_code;
+
+    for (int i = 0; i < batch_count; i++) {
+        memcpy(matrices + i * 16, base_matrix, sizeof(base_matrix));
+    }
+
+    gauss_solver* solver = gauss_solver_create(&error_code);
+    assert_non_null(solver);
+
+    gauss_solver_calculate_determinants_batched(solver, matrices, batch_count, 4, NULL, NULL, mantissas, exponents, signs, NULL, &error_code);
+    assert_int_equal(error_code, 0);
+
+    for (int i = 0; i < batch_count; i++) {
+        double result = (double)signs[i] * (double)mantissas[i] * pow(10.0, (double)exponents[i]);
+        assert_true(fabs(result - 36.0) < 0.001);
+    }
+
+    gauss_solver_release(solver);
+}
+
+static void test_gpu_batched_variable_sizes() {
+    float matrices[16 + 25 + 36 + 1] = {
+        4, 4, 4, 4,
+        6, 4, 1, 9,
+        5, 6, 6, 5,
+        9, 2, 6, 8,
+
+        0, 0, 0, 0, 2,
+        0, 3, 0, 0, 0,
+        0, 0, 4, 0, 0,
+        0, 0, 0, 5, 0,
+        6, 0, 0, 0, 0,
+
+        1, 2, 3, 4, 5, 6,
+        1, 2, 3, 4, 5, 6,
+        0, 0, 1, 0, 0, 0,
+        0, 0, 0, 1, 0, 0,
+        0, 0, 0, 0, 1, 0,
+        0, 0, 0, 0, 0, 1,
+
+        -7
+    };
+    int sizes[4] = {4, 5, 6, 1};
+    long long offsets[4] = {0, 16, 41, 77};
+    double expected[4] = {36.0, -720.0, 0.0, -7.0};
+    float mantissas[4];
+    long long exponents[4];
+    int signs[4];
+    int error_code;
+
+    gauss_solver* solver = gauss_solver_create(&error_code);
+    assert_non_null(solver);
+
+    gauss_solver_calculate_determinants_batched(solver, matrices, 4, 0, sizes, offsets, mantissas, exponents, signs, NULL, &error_code);
+    assert_int_equal(error_code, 0);
+
+    for (int i = 0; i < 4; i++) {
+        double result = (double)signs[i] * (double)mantissas[i] * pow(10.0, (double)exponents[i]);
+        assert_true(fabs(result - expected[i]) < 0.001);
+    }
+
+    int oversized[1] = {BATCH_MAX_SIZE + 1};
+    gauss_solver_calculate_determinants_batched(solver, matrices, 1, 0, oversized, offsets, mantissas, exponents, signs, NULL, &error_code);
+    assert_int_not_equal(error_code, 0);
+
+    gauss_solver_release(solver);
+}
+
+static void test_gpu_matrix_readback_opt_in() {
+    float test_matrix[16] = {
+        4, 4, 4, 4,
+        6, 4, 1, 9,
+        5, 6, 6, 5,
+        9, 2, 6, 8
+    };
+    float work_matrix[16];
+
+    float mantissa = 0.0f;
+    long long int exponent = 0;
+    int sign = 1;
+    int error_code;
+
+    gauss_solver* solver = gauss_solver_create(&error_code);
+    assert_non_null(solver);
+
+    memcpy(work_matrix, test_matrix, sizeof(test_matrix));
+    gauss_solver_calculate_determinant(solver, work_matrix, 4, &mantissa, &exponent, &sign, NULL, NULL, NULL);
+    assert_memory_equal(work_matrix, test_matrix, sizeof(test_matrix));
+
+    solver->read_back_matrix = 1;
+    gauss_solver_calculate_determinant(solver, work_matrix, 4, &mantissa, &exponent, &sign, NULL, NULL, NULL);
+    double diagonal_product = 1.0;
+    for (int i = 0; i < 4; i++) {
+        diagonal_product *= work_matrix[i * 4 + i];
+    }
+    double result = (double)sign * (double)mantissa * pow(10.0, (double)exponent);
+
+    assert_true(fabs(result - 36.0) < 0.0001);
+    assert_true(fabs(fabs(diagonal_product) - 36.0) < 0.001);
+
+    gauss_solver_release(solver);
+}
+
+static void test_matrix_file_round_trip() {
+    const char* path = "test_matrix_file.bin";
+    float matrix[6 * 6];
+    double wide[6 * 6];
+    int size = 6;
+    int error_code;
+
+    generate_matrix(matrix, size);
+    write_matrix_file(path, matrix, size, &error_code);
+    assert_int_equal(error_code, 0);
+
+    matrix_file file;
+    matrix_file_open(path, &file, &error_code);
+    assert_int_equal(error_code, 0);
+    assert_int_equal(file.header.rows, size);
+    assert_int_equal(file.header.cols, size);
+    assert_int_equal(matrix_file_verify(&file), 0);
+
+    float* loaded = matrix_file_floats(&file, &error_code);
+    assert_int_equal(error_code, 0);
+    assert_memory_equal(loaded, matrix, sizeof(matrix));
+
+    loaded[0] += 1.0f;
+    assert_int_equal(matrix_file_verify(&file), MATRIX_FILE_ERROR_CHECKSUM);
+    matrix_file_close(&file);
+
+    matrix_file_open(path, &file, &error_code);
+    assert_int_equal(error_code, 0);
+    assert_int_equal(matrix_file_verify(&file), 0);
+    matrix_file_close(&file);
+
+    for (int i = 0; i < size * size; i++) {
+        wide[i] = matrix[i];
+    }
+
+    matrix_file_writer writer;
+    matrix_file_writer_open(&writer, path, size, size, MATRIX_ELEMENT_FLOAT64, MATRIX_LAYOUT_COLUMN_MAJOR, MATRIX_FILE_HAS_CHECKSUM, &error_code);
+    assert_int_equal(error_code, 0);
+    matrix_file_writer_write(&writer, wide, 10, &error_code);
+    assert_int_equal(error_code, 0);
+    matrix_file_writer_write(&writer, wide + 10, size * size - 10, &error_code);
+    assert_int_equal(error_code, 0);
+    matrix_file_writer_write(&writer, wide, 1, &error_code);
+    assert_int_equal(error_code, MATRIX_FILE_ERROR_SIZE);
+    matrix_file_writer_close(&writer, &error_code);
+    assert_int_equal(error_code, 0);
+
+    matrix_file_open(path, &file, &error_code);
+    assert_int_equal(error_code, 0);
+    assert_int_equal(file.header.layout, MATRIX_LAYOUT_COLUMN_MAJOR);
+    assert_int_equal(matrix_file_verify(&file), 0);
+    loaded = matrix_file_floats(&file, &error_code);
+    assert_non_null(loaded);
+    assert_memory_equal(loaded, matrix, sizeof(matrix));
+    matrix_file_close(&file);
+
+    uint32_t misaligned_header_size = MATRIX_FILE_HEADER_SIZE + sizeof(double);
+    FILE* misaligned = fopen(path, "r+b");
+    assert_non_null(misaligned);
+    fseek(misaligned, offsetof(matrix_file_header, header_size), SEEK_SET);
+    fwrite(&misaligned_header_size, sizeof(misaligned_header_size), 1, misaligned);
+    fclose(misaligned);
+    matrix_file_open(path, &file, &error_code);
+    assert_int_equal(error_code, MATRIX_FILE_ERROR_FORMAT);
+
+    FILE* truncated = fopen(path, "r+b");
+    assert_non_null(truncated);
+    fputc('X', truncated);
+    fclose(truncated);
+    matrix_file_open(path, &file, &error_code);
+    assert_int_equal(error_code, MATRIX_FILE_ERROR_FORMAT);
+
+    remove(path);
+}
+
+static void test_gpu_launch_modes_agree() {
+    int sizes[3] = {40, 17, 40};
+    float matrix[40 * 40];
+    float work[40 * 40];
+    int error_code;
+
+    gauss_solver* solver = gauss_solver_create(&error_code);
+    assert_non_null(solver);
+    solver->persistent_max_size = 0;
+
+    for (int i = 0; i < 3; i++) {
+        int size = sizes[i];
+        generate_matrix(matrix, size);
+        matrix[i] += 1.0f;
+
+        float mantissa[2];
+        long long exponent[2];
+        int sign[2];
+        for (int mode = 0; mode < 2; mode++) {
+            solver->use_command_buffer = mode;
+            memcpy(work, matrix, (size_t)size * size * sizeof(float));
+            gauss_solver_calculate_determinant(solver, work, size, &mantissa[mode], &exponent[mode], &sign[mode], NULL, NULL, NULL);
+            assert_int_equal(solver->used_command_buffer, mode && solver->command_buffer_supported);
+            assert_true(solver->time_host_enqueue >= 0.0f);
+        }
+
+        assert_int_equal(sign[0], sign[1]);
+        assert_int_equal(exponent[0], exponent[1]);
+        assert_true(fabs(mantissa[0] - mantissa[1]) < 1e-5);
+    }
+
+    gauss_solver_release(solver);
+}
+
+static void test_gpu_persistent_matches_per_step() {
+    int sizes[5] = {2, 7, 33, 64, 6};
+    float matrix[64 * 64];
+    float work[64 * 64];
+    int error_code;
+
+    gauss_solver* solver = gauss_solver_create(&error_code);
+    assert_non_null(solver);
+    assert_true(solver->persistent_size_limit >= 64);
+
+    for (int i = 0; i < 5; i++) {
+        int size = sizes[i];
+        generate_matrix(matrix, size);
+        if (i == 4) {
+            for (int col = 0; col < size; col++) {
+                matrix[3 * size + col] = 2.0f * matrix[col];
+            }
+        }
+
+        float mantissa[2];
+        long long exponent[2];
+        int sign[2];
+        for (int mode = 0; mode < 2; mode++) {
+            solver->persistent_max_size = mode ? PERSISTENT_MAX_SIZE : 0;
+            memcpy(work, matrix, (size_t)size * size * sizeof(float));
+            gauss_solver_calculate_determinant(solver, work, size, &mantissa[mode], &exponent[mode], &sign[mode], NULL, NULL, NULL);
+            assert_int_equal(solver->used_persistent_kernel, mode);
+        }
+
+        assert_int_equal(sign[0], sign[1]);
+        assert_int_equal(exponent[0], exponent[1]);
+        assert_true(fabs(mantissa[0] - mantissa[1]) < 1e-4);
+        if (i == 4) {
+            assert_true(mantissa[1] == 0.0f);
+        }
+    }
+
+    gauss_solver_release(solver);
+}
+
+static void test_profiler_records_commands() {
+    int size = 40;
+    float matrix[40 * 40];
+    int error_code;
+
+    gauss_solver* solver = gauss_solver_create(&error_code);
+    assert_non_null(solver);
+    solver->persistent_max_size = 0;
+    solver->profiler = create_profiler();
+    assert_non_null(solver->profiler);
+
+    generate_matrix(matrix, size);
+    float mantissa = 0.0f;
+    long long exponent = 0;
+    int sign = 1;
+    gauss_solver_calculate_determinant(solver, matrix, size, &mantissa, &exponent, &sign, NULL, NULL, NULL);
+
+    const profiler* profiler = solver->profiler;
+    int elimination_count = 0;
+    double upload_bytes = 0.0;
+    for (int i = 0; i < profiler->count; i++) {
+        const profile_record* record = &profiler->records[i];
+        assert_true(record->queued <= record->submit);
+        assert_true(record->submit <= record->start);
+        assert_true(record->start <= record->end);
+        if (strcmp(record->name, "eliminate_tiled") == 0) elimination_count++;
+        if (strcmp(record->phase, "upload") == 0) upload_bytes += record->bytes;
+    }
+    assert_int_equal(elimination_count, size - 1);
+    assert_true(fabs(upload_bytes - (double)(sizeof(matrix) + 2 * sizeof(int))) < 1.0);
+
+    profile_info info = {"opencl_gauss", solver->device_id, size, solver->elimination_tile, "fp32", 0.01, 2.0 * size * size * size / 3.0};
+    assert_int_equal(write_profile_json(profiler, &info, "test_profile.json"), 0);
+    assert_int_equal(write_profile_csv(profiler, &info, "test_profile.csv"), 0);
+    assert_int_equal(write_chrome_trace(profiler, "test_profile_trace.json"), 0);
+
+    char text[4096];
+    FILE* file = fopen("test_profile.json", "r");
+    assert_non_null(file);
+    size_t length = fread(text, 1, sizeof(text) - 1, file);
+    text[length] = '\0';
+    fclose(file);
+    assert_non_null(strstr(text, "\"matrix_size\": 40"));
+    assert_non_null(strstr(text, "\"phase\": \"elimination\""));
+
+    file = fopen("test_profile_trace.json", "r");
+    assert_non_null(file);
+    length = fread(text, 1, sizeof(text) - 1, file);
+    text[length] = '\0';
+    fclose(file);
+    assert_non_null(strstr(text, "\"traceEvents\""));
+
+    remove("test_profile.json");
+    remove("test_profile.csv");
+    remove("test_profile_trace.json");
+
+    profiler_reset(solver->profiler);
+    assert_int_equal(solver->profiler->count, 0);
+    release_profiler(solver->profiler);
+    gauss_solver_release(solver);
+}
+
 int main() {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(test_cpu_determinant_4x4),
         cmocka_unit_test(test_cpu_determinant_5x5),
         cmocka_unit_test(test_cpu_determinant_6x6_zero),
+        cmocka_unit_test(test_cpu_blocked_determinant_4x4),
+        cmocka_unit_test(test_cpu_blocked_determinant_6x6_zero),
+        cmocka_unit_test(test_cpu_blocked_matches_naive),
+        cmocka_unit_test(test_simd_kernels_match_scalar),
+        cmocka_unit_test(test_scaled_product_large_and_signed),
         cmocka_unit_test(test_gpu_determinant_4x4),
         cmocka_unit_test(test_gpu_determinant_5x5),
         cmocka_unit_test(test_gpu_determinant_6x6_zero),
+        cmocka_unit_test(test_gpu_solver_reuse),
+        cmocka_unit_test(test_gpu_program_binary_cache),
+        cmocka_unit_test(test_gpu_batched_uniform),
+        cmocka_unit_test(test_gpu_batched_variable_sizes),
+        cmocka_unit_test(test_gpu_matrix_readback_opt_in),
+        cmocka_unit_test(test_gpu_launch_modes_agree),
+        cmocka_unit_test(test_gpu_persistent_matches_per_step),
+        cmocka_unit_test(test_matrix_file_round_trip),
+        cmocka_unit_test(test_profiler_records_commands),
     };
 
     printf("Matrix Determinant Tests\n");
@@ -1,6 +0,0 @@
-#ifndef FILE_H
-#define FILE_H
-
-void write_benchmark_to_file(const char* file_name, int matrix_size, double exec_time);
-
-#endif
@@ -1,16 +1,156 @@
 #ifndef MATRIX_H
 #define MATRIX_H
 
+#include "cpu_solver.h"
 #include "kernel_loader.h"
+#include "profiler.h"
 
 #include <CL/cl.h>
 
-void generate_matrix(float* matrix, int size);
+#ifndef KERNEL_SOURCE_PATH
+#define KERNEL_SOURCE_PATH "kernel/sample.cl"
+#endif
+
+#define BLOCK_SIZE_TUNING_FILE KERNEL_CACHE_DIR "/block_size.txt"
+#define UPLOAD_CHUNK_COUNT 8
+#define LU_KERNEL_COUNT 10
+#define MATRIX_ALIGNMENT 4096
+#define LEADING_DIMENSION_ALIGN 32
+#define LEADING_DIMENSION_CONFLICT_STRIDE 512
+
+typedef enum {
+    PRECISION_FP32,
+    PRECISION_MIXED,
+    PRECISION_FP64
+} precision_mode;
+
+typedef enum {
+    DEVICE_LAYOUT_ROW_MAJOR,
+    DEVICE_LAYOUT_COLUMN_MAJOR,
+    DEVICE_LAYOUT_TILED
+} device_layout;
+
+typedef struct {
+    float* host;
+    void* storage;
+    cl_mem buffer;
+    size_t bytes;
+    int size;
+    int leading_dimension;
+} matrix_allocation;
+
+typedef struct {
+    cl_device_id device_id;
+    char device_name[256];
+    size_t max_work_group_size;
+    cl_ulong local_mem_size;
+    int supports_fp64;
+    int host_unified_memory;
+    cl_context context;
+    cl_command_queue queue;
+    cl_command_queue transfer_queue;
+    int pipelined_upload;
+    cl_program program;
+    int program_from_cache;
+    float time_build;
+    char* kernel_source;
+    precision_mode precision;
+    int refinement_probes;
+    int program_fp64;
+    device_layout layout;
+    int program_layout;
+    int block_size;
+    int panel_group_size;
+    int trsm_group_size;
+    int trail_group_size;
+    cl_kernel kernel_fact;
+    cl_kernel kernel_swap;
+    cl_kernel kernel_upper;
+    cl_kernel kernel_trail;
+    cl_kernel kernel_determinant;
+    cl_kernel kernel_pivot_sequence;
+    cl_kernel kernel_residual;
+    cl_kernel kernel_to_layout;
+    cl_kernel kernel_from_layout;
+    cl_kernel kernel_fill_padding;
+    cl_mem gpu_matrix;
+    size_t gpu_matrix_capacity;
+    cl_mem gpu_upload;
+    size_t gpu_upload_capacity;
+    int padded_size;
+    int leading_dimension;
+    cl_mem gpu_sign;
+    cl_mem gpu_result_mantissa;
+    cl_mem gpu_result_exponent;
+    int read_back_matrix;
+    cl_mem gpu_pivots;
+    size_t gpu_pivots_capacity;
+    cl_mem gpu_original;
+    size_t gpu_original_capacity;
+    cl_mem gpu_residual;
+    size_t gpu_residual_capacity;
+    void* host_staging;
+    size_t host_staging_capacity;
+    matrix_allocation* allocations;
+    int allocation_count;
+    const char* transfer_mode;
+    float time_host_enqueue;
+    float time_panel;
+    float time_swap;
+    float time_upper;
+    float time_trailing;
+    float time_reduction;
+    float time_refinement;
+    double refinement_trace;
+    double refinement_standard_error;
+    float time_layout;
+    float time_overlapped_total;
+    float time_serialized_total;
+    double log10_determinant;
+    double trailing_flops;
+    profiler* profiler;
+} lu_solver;
+
+double calculate_log10_determinant_double(const float* matrix, int size, int* out_sign);
+
+void calculate_determinant_lu_opencl(float* matrix, int size, float* out_mantissa, long long* out_exponent, int* out_sign, float* out_time_write, float* out_time_calc, float* out_time_read);
+
+lu_solver* lu_solver_create(int* error_code);
+
+lu_solver* lu_solver_create_for_device(cl_device_id device_id, int* error_code);
+
+float* matrix_alloc(lu_solver* solver, int size, int* error_code);
+
+void matrix_free(lu_solver* solver, float* matrix);
+
+int matrix_leading_dimension(const lu_solver* solver, const float* matrix, int size);
+
+void matrix_copy(const lu_solver* solver, float* matrix, const float* source, int size);
+
+void lu_solver_calculate_determinant(lu_solver* solver, float* matrix, int size, float* out_mantissa, long long* out_exponent, int* out_sign, float* out_time_write, float* out_time_calc, float* out_time_read, int* error_code);
+
+int is_block_size_supported(const lu_solver* solver, int block_size);
+
+void lu_solver_set_block_size(lu_solver* solver, int block_size, int* error_code);
+
+void lu_solver_set_precision(lu_solver* solver, precision_mode precision, int* error_code);
+
+void lu_solver_set_refinement_probes(lu_solver* solver, int probe_count, int* error_code);
+
+const char* precision_mode_name(precision_mode precision);
+
+void lu_solver_set_layout(lu_solver* solver, device_layout layout, int* error_code);
+
+const char* device_layout_name(device_layout layout);
+
+int device_padded_size(const lu_solver* solver, int size);
+
+int device_leading_dimension(const lu_solver* solver, int size);
 
-void print_matrix(float* matrix, int size);
+float sum_event_times(cl_event* events, int count);
 
-void calculate_determinant_gauss(float* matrix, int size, float* out_mantissa, long long* out_exponent, int* out_sign);
+int lu_solver_autotune(lu_solver* solver, int size, int* error_code);
 
-void calculate_determinant_gauss_opencl(float* matrix, int size, float* out_mantissa, long long* out_exponent, int* out_sign, float* out_time_write, float* out_time_calc, float* out_time_read);
+void lu_solver_release(lu_solver* solver);
 
 #endif
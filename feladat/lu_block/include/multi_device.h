@@ -0,0 +1,34 @@
+#ifndef MULTI_DEVICE_H
+#define MULTI_DEVICE_H
+
+#include "matrix.h"
+
+#define MULTI_DEVICE_MAX_DEVICES 16
+#define MULTI_DEVICE_CALIBRATION_SIZE 256
+#define MULTI_DEVICE_CALIBRATION_RUNS 3
+
+typedef struct {
+    int device_count;
+    lu_solver* solvers[MULTI_DEVICE_MAX_DEVICES];
+    cl_device_id sub_devices[MULTI_DEVICE_MAX_DEVICES];
+    int sub_device_count;
+    double throughput[MULTI_DEVICE_MAX_DEVICES];
+    int block_columns[MULTI_DEVICE_MAX_DEVICES];
+    float time_busy[MULTI_DEVICE_MAX_DEVICES];
+    double flops[MULTI_DEVICE_MAX_DEVICES];
+    int block_width;
+    float time_transfer;
+    float time_total;
+} multi_device_solver;
+
+multi_device_solver* create_multi_device_solver(int cpu_partitions, int* error_code);
+
+void calibrate_multi_device_solver(multi_device_solver* solver, int* error_code);
+
+void assign_block_columns(const double* throughput, int device_count, int block_count, int* owners, int* local_indices, int* block_columns);
+
+void calculate_determinant_multi_device(multi_device_solver* solver, float* matrix, int size, float* out_mantissa, long long* out_exponent, int* out_sign, int* error_code);
+
+void release_multi_device_solver(multi_device_solver* solver);
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef OUT_OF_CORE_H
+#define OUT_OF_CORE_H
+
+#include "matrix.h"
+
+#define OUT_OF_CORE_SLAB_BUFFERS 4
+
+typedef struct {
+    int slab_width;
+    long long slab_count;
+    size_t working_set_bytes;
+    double bytes_uploaded;
+    double bytes_downloaded;
+    float time_transfer;
+    float time_compute;
+    float time_total;
+} out_of_core_stats;
+
+void enqueue_solve_block(lu_solver* solver, cl_kernel kernel, cl_mem target, long long target_row, int target_col, int columns, cl_mem lower, long long lower_row, int lower_col, int pitch, int lower_pitch, int depth, cl_uint wait_count, const cl_event* wait_events, cl_event* event);
+
+void enqueue_update_block(lu_solver* solver, cl_kernel kernel, cl_mem target, long long target_row, int target_col, long long rows, int columns, cl_mem lower, long long lower_row, int lower_col, long long upper_row, int pitch, int lower_pitch, int depth, cl_event* event);
+
+int out_of_core_slab_width(const lu_solver* solver, long long size, size_t device_budget);
+
+void calculate_determinant_out_of_core(lu_solver* solver, float* matrix, long long size, size_t device_budget, float* out_mantissa, long long* out_exponent, int* out_sign, out_of_core_stats* stats, int* error_code);
+
+#endif
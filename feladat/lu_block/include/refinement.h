@@ -0,0 +1,12 @@
+#ifndef REFINEMENT_H
+#define REFINEMENT_H
+
+#define REFINEMENT_COLUMN_TILE 64
+#define REFINEMENT_PROBE_COUNT 32
+#define REFINEMENT_PROBE_TILE 32
+#define REFINEMENT_PROBE_SEED 42u
+#define REFINEMENT_SIGNIFICANCE 2.0
+
+double lu_correction_trace(const float* factors, int factor_pitch, const float* residual, int residual_pitch, int size, int probe_count, int thread_count, double* out_standard_error);
+
+#endif
@@ -1,85 +1,592 @@
-#define BLOCK_SIZE 128
+#ifdef USE_FP64
+#pragma OPENCL EXTENSION cl_khr_fp64 : enable
+typedef double real;
+typedef double4 real4;
+#else
+typedef float real;
+typedef float4 real4;
+#endif
+
+#ifndef BLOCK_SIZE
+#define BLOCK_SIZE 16
+#endif
+
+#ifndef PANEL_GROUP_SIZE
+#define PANEL_GROUP_SIZE 256
+#endif
+
+#ifndef TRAIL_GROUP_SIZE
+#define TRAIL_GROUP_SIZE 16
+#endif
+
+#ifndef TRSM_GROUP_SIZE
+#define TRSM_GROUP_SIZE 16
+#endif
+
+#define LAYOUT_ROW_MAJOR 0
+#define LAYOUT_COLUMN_MAJOR 1
+#define LAYOUT_TILED 2
+
+#ifndef MATRIX_LAYOUT
+#define MATRIX_LAYOUT LAYOUT_ROW_MAJOR
+#endif
+
+#define TRAIL_REG 4
+#define TRAIL_TILE (TRAIL_GROUP_SIZE * 4)
+#define TRAIL_TILE_K 16
+#define FULL_K_TILES (BLOCK_SIZE % TRAIL_TILE_K == 0)
+
+long element_index(int row, int col, int leading_dimension) {
+#if MATRIX_LAYOUT == LAYOUT_COLUMN_MAJOR
+    return (long)col * leading_dimension + row;
+#elif MATRIX_LAYOUT == LAYOUT_TILED
+    long tile = (long)(row / BLOCK_SIZE) * (leading_dimension / BLOCK_SIZE) + col / BLOCK_SIZE;
+    return tile * (BLOCK_SIZE * BLOCK_SIZE) + (row % BLOCK_SIZE) * BLOCK_SIZE + col % BLOCK_SIZE;
+#else
+    return (long)row * leading_dimension + col;
+#endif
+}
+
+#if MATRIX_LAYOUT == LAYOUT_COLUMN_MAJOR || (MATRIX_LAYOUT == LAYOUT_TILED && BLOCK_SIZE % 4 != 0)
+#define ROW_VECTORS_CONTIGUOUS 0
+#else
+#define ROW_VECTORS_CONTIGUOUS 1
+#endif
+
+real4 load_row4(__global const real* matrix, int row, int col, int leading_dimension) {
+#if ROW_VECTORS_CONTIGUOUS
+    return vload4(0, matrix + element_index(row, col, leading_dimension));
+#else
+    return (real4)(matrix[element_index(row, col, leading_dimension)],
+                   matrix[element_index(row, col + 1, leading_dimension)],
+                   matrix[element_index(row, col + 2, leading_dimension)],
+                   matrix[element_index(row, col + 3, leading_dimension)]);
+#endif
+}
+
+void store_row4(real4 value, __global real* matrix, int row, int col, int leading_dimension) {
+#if ROW_VECTORS_CONTIGUOUS
+    vstore4(value, 0, matrix + element_index(row, col, leading_dimension));
+#else
+    matrix[element_index(row, col, leading_dimension)] = value.x;
+    matrix[element_index(row, col + 1, leading_dimension)] = value.y;
+    matrix[element_index(row, col + 2, leading_dimension)] = value.z;
+    matrix[element_index(row, col + 3, leading_dimension)] = value.w;
+#endif
+}
+
+void reduce_pivot_candidates(__local real* values, __local int* rows, int local_id) {
+    for (int stride = PANEL_GROUP_SIZE / 2; stride > 0; stride /= 2) {
+        if (local_id < stride) {
+            real other_value = values[local_id + stride];
+            int other_row = rows[local_id + stride];
+            if (other_value > values[local_id] || (other_value == values[local_id] && other_row < rows[local_id])) {
+                values[local_id] = other_value;
+                rows[local_id] = other_row;
+            }
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+}
+
+__kernel void lu_convert_to_layout(__global const real* source, __global real* matrix, int matrix_size, int leading_dimension, int source_pitch) {
+    __local real tile[TRSM_GROUP_SIZE][TRSM_GROUP_SIZE + 1];
 
-__kernel void lu_factorize_block(__global float* matrix, int block_offset, int matrix_size) {
-    __local float local_block[BLOCK_SIZE][BLOCK_SIZE];
-    
     int local_col = get_local_id(0);
     int local_row = get_local_id(1);
-    
-    int global_row = block_offset + local_row;
-    int global_col = block_offset + local_col;
+    int row = get_group_id(1) * TRSM_GROUP_SIZE + local_row;
+    int col = get_group_id(0) * TRSM_GROUP_SIZE + local_col;
+
+#if MATRIX_LAYOUT == LAYOUT_COLUMN_MAJOR
+    tile[local_row][local_col] = row < matrix_size && col < matrix_size ? source[(long)row * source_pitch + col] : 0.0f;
+    barrier(CLK_LOCAL_MEM_FENCE);
 
-    if (global_row < matrix_size && global_col < matrix_size) {
-        local_block[local_row][local_col] = matrix[global_row * matrix_size + global_col];
-    } else {
-        local_block[local_row][local_col] = 0.0f;
+    int target_row = get_group_id(1) * TRSM_GROUP_SIZE + local_col;
+    int target_col = get_group_id(0) * TRSM_GROUP_SIZE + local_row;
+    if (target_row < matrix_size && target_col < matrix_size) {
+        matrix[element_index(target_row, target_col, leading_dimension)] = tile[local_col][local_row];
     }
+#else
+    if (row < matrix_size && col < matrix_size) {
+        matrix[element_index(row, col, leading_dimension)] = source[(long)row * source_pitch + col];
+    }
+#endif
+}
+
+__kernel void lu_convert_from_layout(__global const real* matrix, __global real* target, int matrix_size, int leading_dimension, int target_pitch) {
+    __local real tile[TRSM_GROUP_SIZE][TRSM_GROUP_SIZE + 1];
+
+    int local_col = get_local_id(0);
+    int local_row = get_local_id(1);
+    int row = get_group_id(1) * TRSM_GROUP_SIZE + local_row;
+    int col = get_group_id(0) * TRSM_GROUP_SIZE + local_col;
 
+#if MATRIX_LAYOUT == LAYOUT_COLUMN_MAJOR
+    int source_row = get_group_id(1) * TRSM_GROUP_SIZE + local_col;
+    int source_col = get_group_id(0) * TRSM_GROUP_SIZE + local_row;
+    tile[local_col][local_row] = source_row < matrix_size && source_col < matrix_size ? matrix[element_index(source_row, source_col, leading_dimension)] : 0.0f;
     barrier(CLK_LOCAL_MEM_FENCE);
 
+    if (row < matrix_size && col < matrix_size) {
+        target[(long)row * target_pitch + col] = tile[local_row][local_col];
+    }
+#else
+    if (row < matrix_size && col < matrix_size) {
+        target[(long)row * target_pitch + col] = matrix[element_index(row, col, leading_dimension)];
+    }
+#endif
+}
+
+__kernel void lu_fill_padding(__global real* matrix, int matrix_size, int leading_dimension) {
+    int index = get_global_id(0);
+    int band = matrix_size + get_global_id(1);
+    real value = index == band ? 1.0f : 0.0f;
+
+    matrix[element_index(band, index, leading_dimension)] = value;
+    matrix[element_index(index, band, leading_dimension)] = value;
+}
+
+__kernel void lu_factorize_panel(__global real* matrix, int block_offset, int matrix_size, int leading_dimension, __global int* pivots, __global int* sign) {
+    __local real local_values[PANEL_GROUP_SIZE];
+    __local int local_rows[PANEL_GROUP_SIZE];
+    __local real pivot_row[BLOCK_SIZE];
+
+    int local_id = get_local_id(0);
+
     for (int local_pivot_index = 0; local_pivot_index < BLOCK_SIZE; local_pivot_index++) {
-        if (local_row > local_pivot_index && local_col == local_pivot_index) {
-            float pivot = local_block[local_pivot_index][local_pivot_index];
-            if (fabs(pivot) > 1e-12f) {
-                local_block[local_row][local_col] /= pivot;
+        int pivot_col = block_offset + local_pivot_index;
+
+        real best_value = -1.0f;
+        int best_row = matrix_size;
+        for (int row = pivot_col + local_id; row < matrix_size; row += PANEL_GROUP_SIZE) {
+            real current_value = fabs(matrix[element_index(row, pivot_col, leading_dimension)]);
+            if (current_value > best_value) {
+                best_value = current_value;
+                best_row = row;
             }
         }
+
+        local_values[local_id] = best_value;
+        local_rows[local_id] = best_row;
         barrier(CLK_LOCAL_MEM_FENCE);
 
-        if (local_row > local_pivot_index && local_col > local_pivot_index) {
-            local_block[local_row][local_col] -= local_block[local_row][local_pivot_index] * local_block[local_pivot_index][local_col];
+        reduce_pivot_candidates(local_values, local_rows, local_id);
+        int pivot_row_index = local_rows[0];
+
+        if (pivot_row_index != pivot_col) {
+            if (local_id < BLOCK_SIZE) {
+                int col = block_offset + local_id;
+                real temp = matrix[element_index(pivot_col, col, leading_dimension)];
+                matrix[element_index(pivot_col, col, leading_dimension)] = matrix[element_index(pivot_row_index, col, leading_dimension)];
+                matrix[element_index(pivot_row_index, col, leading_dimension)] = temp;
+            }
+            if (local_id == 0) {
+                *sign = -(*sign);
+            }
+        }
+        if (local_id == 0) {
+            pivots[block_offset + local_pivot_index] = pivot_row_index;
+        }
+        barrier(CLK_GLOBAL_MEM_FENCE);
+
+        if (local_id < BLOCK_SIZE) {
+            pivot_row[local_id] = matrix[element_index(pivot_col, block_offset + local_id, leading_dimension)];
         }
         barrier(CLK_LOCAL_MEM_FENCE);
+
+        real pivot = pivot_row[local_pivot_index];
+        if (fabs(pivot) > 1e-12f) {
+            for (int row = pivot_col + 1 + local_id; row < matrix_size; row += PANEL_GROUP_SIZE) {
+                real factor = matrix[element_index(row, pivot_col, leading_dimension)] / pivot;
+                matrix[element_index(row, pivot_col, leading_dimension)] = factor;
+
+                for (int inner_col = local_pivot_index + 1; inner_col < BLOCK_SIZE; inner_col++) {
+                    matrix[element_index(row, block_offset + inner_col, leading_dimension)] -= factor * pivot_row[inner_col];
+                }
+            }
+        }
+        barrier(CLK_GLOBAL_MEM_FENCE);
     }
+}
 
-    if (global_row < matrix_size && global_col < matrix_size) {
-        matrix[global_row * matrix_size + global_col] = local_block[local_row][local_col];
+__kernel void lu_apply_row_swaps(__global real* matrix, int block_offset, int leading_dimension, __global const int* pivots) {
+    int panel_col = block_offset + BLOCK_SIZE + get_global_id(0);
+
+    for (int local_pivot_index = 0; local_pivot_index < BLOCK_SIZE; local_pivot_index++) {
+        int row = block_offset + local_pivot_index;
+        int pivot_row_index = pivots[row];
+        if (pivot_row_index != row) {
+            real temp = matrix[element_index(row, panel_col, leading_dimension)];
+            matrix[element_index(row, panel_col, leading_dimension)] = matrix[element_index(pivot_row_index, panel_col, leading_dimension)];
+            matrix[element_index(pivot_row_index, panel_col, leading_dimension)] = temp;
+        }
     }
 }
 
-__kernel void lu_update_panels(__global float* matrix, int block_offset, int matrix_size) {
-    int id = get_global_id(0);
-    int remaining_size = matrix_size - block_offset - BLOCK_SIZE;
+__kernel void lu_solve_upper_panel(__global real* matrix, int block_offset, int leading_dimension) {
+    __local real diagonal_block[BLOCK_SIZE][BLOCK_SIZE];
+    __local real panel_strip[BLOCK_SIZE][TRSM_GROUP_SIZE];
+
+    int local_col = get_local_id(0);
+    int local_row = get_local_id(1);
+    int local_id = local_row * TRSM_GROUP_SIZE + local_col;
+
+    int panel_col = block_offset + BLOCK_SIZE + get_global_id(0);
+
+    for (int index = local_id; index < BLOCK_SIZE * BLOCK_SIZE; index += TRSM_GROUP_SIZE * TRSM_GROUP_SIZE) {
+        int row = index / BLOCK_SIZE;
+        int col = index % BLOCK_SIZE;
+        diagonal_block[row][col] = matrix[element_index(block_offset + row, block_offset + col, leading_dimension)];
+    }
+
+    for (int row = local_row; row < BLOCK_SIZE; row += TRSM_GROUP_SIZE) {
+        panel_strip[row][local_col] = matrix[element_index(block_offset + row, panel_col, leading_dimension)];
+    }
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    for (int local_pivot_index = 0; local_pivot_index < BLOCK_SIZE - 1; local_pivot_index++) {
+        real pivot_value = panel_strip[local_pivot_index][local_col];
+        for (int row = local_pivot_index + 1 + local_row; row < BLOCK_SIZE; row += TRSM_GROUP_SIZE) {
+            panel_strip[row][local_col] -= diagonal_block[row][local_pivot_index] * pivot_value;
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    for (int row = local_row; row < BLOCK_SIZE; row += TRSM_GROUP_SIZE) {
+        matrix[element_index(block_offset + row, panel_col, leading_dimension)] = panel_strip[row][local_col];
+    }
+}
+
+__kernel void lu_update_trailing_matrix(__global real* matrix, int block_offset, int leading_dimension) {
+    __local real lower_tile[TRAIL_TILE_K][TRAIL_TILE];
+    __local real upper_tile[TRAIL_TILE_K][TRAIL_TILE];
+
+    int local_col = get_local_id(0);
+    int local_row = get_local_id(1);
+    int local_id = local_row * TRAIL_GROUP_SIZE + local_col;
+
+    int trailing_start = block_offset + BLOCK_SIZE;
+    int tile_col = trailing_start + (get_global_offset(0) / TRAIL_GROUP_SIZE + get_group_id(0)) * TRAIL_TILE;
+    int tile_row = trailing_start + get_group_id(1) * TRAIL_TILE;
+
+    real4 sum[TRAIL_REG];
+    for (int i = 0; i < TRAIL_REG; i++) {
+        sum[i] = (real4)(0.0f);
+    }
+
+    for (int k_start = 0; k_start < BLOCK_SIZE; k_start += TRAIL_TILE_K) {
+        for (int index = local_id; index < TRAIL_TILE * (TRAIL_TILE_K / 4); index += TRAIL_GROUP_SIZE * TRAIL_GROUP_SIZE) {
+            int row = index / (TRAIL_TILE_K / 4);
+            int k = (index % (TRAIL_TILE_K / 4)) * 4;
+            int global_row = tile_row + row;
+            int global_k = k_start + k;
+
+            real4 value;
+            int source_col = block_offset + global_k;
+            if (FULL_K_TILES || global_k + 3 < BLOCK_SIZE) {
+                value = load_row4(matrix, global_row, source_col, leading_dimension);
+            } else {
+                value = (real4)(global_k < BLOCK_SIZE ? matrix[element_index(global_row, source_col, leading_dimension)] : 0.0f,
+                                 global_k + 1 < BLOCK_SIZE ? matrix[element_index(global_row, source_col + 1, leading_dimension)] : 0.0f,
+                                 global_k + 2 < BLOCK_SIZE ? matrix[element_index(global_row, source_col + 2, leading_dimension)] : 0.0f,
+                                 0.0f);
+            }
+
+            lower_tile[k][row] = value.x;
+            lower_tile[k + 1][row] = value.y;
+            lower_tile[k + 2][row] = value.z;
+            lower_tile[k + 3][row] = value.w;
+        }
+
+        for (int index = local_id; index < TRAIL_TILE_K * (TRAIL_TILE / 4); index += TRAIL_GROUP_SIZE * TRAIL_GROUP_SIZE) {
+            int k = index / (TRAIL_TILE / 4);
+            int col = (index % (TRAIL_TILE / 4)) * 4;
+            int global_col = tile_col + col;
+            int global_k = k_start + k;
+
+            real4 value = (real4)(0.0f);
+            if (FULL_K_TILES || global_k < BLOCK_SIZE) {
+                value = load_row4(matrix, block_offset + global_k, global_col, leading_dimension);
+            }
+
+            vstore4(value, 0, &upper_tile[k][col]);
+        }
+
+        barrier(CLK_LOCAL_MEM_FENCE);
 
-    if (id >= remaining_size) {
+        for (int k = 0; k < TRAIL_TILE_K; k++) {
+            real4 upper = vload4(0, &upper_tile[k][local_col * 4]);
+            for (int i = 0; i < TRAIL_REG; i++) {
+                sum[i] = mad((real4)(lower_tile[k][local_row + i * TRAIL_GROUP_SIZE]), upper, sum[i]);
+            }
+        }
+
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    int global_col = tile_col + local_col * 4;
+    for (int i = 0; i < TRAIL_REG; i++) {
+        int global_row = tile_row + local_row + i * TRAIL_GROUP_SIZE;
+        store_row4(load_row4(matrix, global_row, global_col, leading_dimension) - sum[i], matrix, global_row, global_col, leading_dimension);
+    }
+}
+
+__kernel void diagonal_determinant(__global const real* matrix, int size, int leading_dimension, __global int* sign, __global real* out_mantissa, __global int* out_exponent) {
+    __local real local_mantissas[PANEL_GROUP_SIZE];
+    __local int local_exponents[PANEL_GROUP_SIZE];
+    __local int local_signs[PANEL_GROUP_SIZE];
+
+    int local_id = get_local_id(0);
+    real mantissa = 1.0f;
+    int exponent = 0;
+    int diagonal_sign = 1;
+
+    for (int i = local_id; i < size; i += get_local_size(0)) {
+        real value = matrix[element_index(i, i, leading_dimension)];
+        if (fabs(value) < 1e-12f) {
+            diagonal_sign = 0;
+        }
+        if (value < 0.0f) {
+            diagonal_sign = -diagonal_sign;
+        }
+
+        int value_exponent;
+        mantissa *= frexp(fabs(value), &value_exponent);
+        exponent += value_exponent;
+
+        int mantissa_exponent;
+        mantissa = frexp(mantissa, &mantissa_exponent);
+        exponent += mantissa_exponent;
+    }
+
+    local_mantissas[local_id] = mantissa;
+    local_exponents[local_id] = exponent;
+    local_signs[local_id] = diagonal_sign;
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    for (int stride = get_local_size(0) / 2; stride > 0; stride /= 2) {
+        if (local_id < stride) {
+            int mantissa_exponent;
+            local_mantissas[local_id] = frexp(local_mantissas[local_id] * local_mantissas[local_id + stride], &mantissa_exponent);
+            local_exponents[local_id] += local_exponents[local_id + stride] + mantissa_exponent;
+            local_signs[local_id] *= local_signs[local_id + stride];
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    if (local_id == 0) {
+        if (local_signs[0] == 0) {
+            out_mantissa[0] = 0.0f;
+            out_exponent[0] = 0;
+            sign[0] = 1;
+        } else {
+            out_mantissa[0] = local_mantissas[0];
+            out_exponent[0] = local_exponents[0];
+            sign[0] *= local_signs[0];
+        }
+    }
+}
+
+__kernel void lu_apply_pivot_sequence(__global real* matrix, int matrix_size, int leading_dimension, __global const int* pivots, int skip_factored_panel) {
+    int col = get_global_id(0);
+    if (col >= matrix_size) {
         return;
     }
 
-    int panel_row = block_offset + BLOCK_SIZE + id;
-    int panel_col = block_offset + BLOCK_SIZE + id;
+    int first_row = skip_factored_panel ? (col / BLOCK_SIZE + 1) * BLOCK_SIZE : 0;
+    for (int row = first_row; row < matrix_size; row++) {
+        int pivot_row_index = pivots[row];
+        if (pivot_row_index != row) {
+            real temp = matrix[element_index(row, col, leading_dimension)];
+            matrix[element_index(row, col, leading_dimension)] = matrix[element_index(pivot_row_index, col, leading_dimension)];
+            matrix[element_index(pivot_row_index, col, leading_dimension)] = temp;
+        }
+    }
+}
 
-    for (int local_pivot_index = 0; local_pivot_index < BLOCK_SIZE; local_pivot_index++) {
-        float pivot = matrix[(block_offset + local_pivot_index) * matrix_size + (block_offset + local_pivot_index)];
-        if (fabs(pivot) > 1e-12f) {
-            matrix[panel_row * matrix_size + (block_offset + local_pivot_index)] /= pivot;
+__kernel void lu_residual(__global const real* original, __global const real* factors, __global real* residual, int matrix_size, int leading_dimension) {
+    int col = get_global_id(0);
+    int row = get_global_id(1);
+    if (col >= matrix_size || row >= matrix_size) {
+        return;
+    }
+
+    real sum_high = 0.0f;
+    real sum_low = 0.0f;
+    int depth = min(row, col);
+
+    for (int k = 0; k <= depth; k++) {
+        real lower = k == row ? 1.0f : factors[element_index(row, k, leading_dimension)];
+        real upper = factors[element_index(k, col, leading_dimension)];
+
+        real product = lower * upper;
+        real product_error = fma(lower, upper, -product);
+
+        real total = sum_high + product;
+        real rounded_part = total - sum_high;
+        real sum_error = (sum_high - (total - rounded_part)) + (product - rounded_part);
+
+        sum_high = total;
+        sum_low += product_error + sum_error;
+    }
+
+    residual[(long)row * matrix_size + col] = (original[element_index(row, col, leading_dimension)] - sum_high) - sum_low;
+}
+
+__kernel void ooc_factor_panel(__global real* slab, long row_begin, long row_end, int col_begin, int columns, int pitch, __global long* pivots) {
+    __local real local_values[PANEL_GROUP_SIZE];
+    __local long local_rows[PANEL_GROUP_SIZE];
+
+    int local_id = get_local_id(0);
+
+    for (int pivot_col = col_begin; pivot_col < col_begin + columns; pivot_col++) {
+        long diagonal_row = row_begin + (pivot_col - col_begin);
+
+        real best_value = -1.0f;
+        long best_row = row_end;
+        for (long row = diagonal_row + local_id; row < row_end; row += PANEL_GROUP_SIZE) {
+            real current_value = fabs(slab[row * pitch + pivot_col]);
+            if (current_value > best_value) {
+                best_value = current_value;
+                best_row = row;
+            }
+        }
+
+        local_values[local_id] = best_value;
+        local_rows[local_id] = best_row;
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        for (int stride = PANEL_GROUP_SIZE / 2; stride > 0; stride /= 2) {
+            if (local_id < stride) {
+                real other_value = local_values[local_id + stride];
+                long other_row = local_rows[local_id + stride];
+                if (other_value > local_values[local_id] || (other_value == local_values[local_id] && other_row < local_rows[local_id])) {
+                    local_values[local_id] = other_value;
+                    local_rows[local_id] = other_row;
+                }
+            }
+            barrier(CLK_LOCAL_MEM_FENCE);
+        }
+        long pivot_row_index = local_rows[0];
+
+        if (pivot_row_index != diagonal_row) {
+            for (int col = local_id; col < pitch; col += PANEL_GROUP_SIZE) {
+                real temp = slab[diagonal_row * pitch + col];
+                slab[diagonal_row * pitch + col] = slab[pivot_row_index * pitch + col];
+                slab[pivot_row_index * pitch + col] = temp;
+            }
         }
-        float factor = matrix[panel_row * matrix_size + (block_offset + local_pivot_index)];
-        
-        for (int inner_col = local_pivot_index + 1; inner_col < BLOCK_SIZE; inner_col++) {
-            matrix[panel_row * matrix_size + (block_offset + inner_col)] -= factor * matrix[(block_offset + local_pivot_index) * matrix_size + (block_offset + inner_col)];
+        if (local_id == 0) {
+            pivots[pivot_col] = pivot_row_index;
         }
+        barrier(CLK_GLOBAL_MEM_FENCE | CLK_LOCAL_MEM_FENCE);
+
+        real pivot = slab[diagonal_row * pitch + pivot_col];
+        if (fabs(pivot) > 1e-12f) {
+            for (long row = diagonal_row + 1 + local_id; row < row_end; row += PANEL_GROUP_SIZE) {
+                real factor = slab[row * pitch + pivot_col] / pivot;
+                slab[row * pitch + pivot_col] = factor;
+
+                for (int col = pivot_col + 1; col < col_begin + columns; col++) {
+                    slab[row * pitch + col] -= factor * slab[diagonal_row * pitch + col];
+                }
+            }
+        }
+        barrier(CLK_GLOBAL_MEM_FENCE);
     }
+}
 
-    for (int local_pivot_index = 0; local_pivot_index < BLOCK_SIZE; local_pivot_index++) {
-        for (int inner_row = local_pivot_index + 1; inner_row < BLOCK_SIZE; inner_row++) {
-            float factor = matrix[(block_offset + inner_row) * matrix_size + (block_offset + local_pivot_index)];
-            matrix[(block_offset + inner_row) * matrix_size + panel_col] -= factor * matrix[(block_offset + local_pivot_index) * matrix_size + panel_col];
+__kernel void ooc_solve_block(__global real* target, long target_row, int target_col, int columns, __global const real* lower, long lower_row, int lower_col, int pitch, int lower_pitch, int depth) {
+    __local real diagonal_tile[TRSM_GROUP_SIZE][TRSM_GROUP_SIZE];
+    __local real lower_tile[TRSM_GROUP_SIZE][TRSM_GROUP_SIZE];
+    __local real solution_tile[TRSM_GROUP_SIZE][TRSM_GROUP_SIZE];
+
+    int local_col = get_local_id(0);
+    int local_row = get_local_id(1);
+    int col = get_group_id(0) * TRSM_GROUP_SIZE + local_col;
+    int in_range = col < columns;
+
+    __global real* x = target + target_row * pitch + target_col + col;
+    __global const real* l = lower + lower_row * lower_pitch + lower_col;
+
+    for (int k_start = 0; k_start < depth; k_start += TRSM_GROUP_SIZE) {
+        int row = k_start + local_row;
+        int diagonal_col = k_start + local_col;
+        diagonal_tile[local_row][local_col] = row < depth && diagonal_col < depth ? l[(long)row * lower_pitch + diagonal_col] : 0.0f;
+        solution_tile[local_row][local_col] = in_range && row < depth ? x[(long)row * pitch] : 0.0f;
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        for (int k = 0; k < TRSM_GROUP_SIZE - 1; k++) {
+            if (local_row > k) {
+                solution_tile[local_row][local_col] -= diagonal_tile[local_row][k] * solution_tile[k][local_col];
+            }
+            barrier(CLK_LOCAL_MEM_FENCE);
+        }
+
+        if (in_range && row < depth) {
+            x[(long)row * pitch] = solution_tile[local_row][local_col];
+        }
+
+        for (int row_start = k_start + TRSM_GROUP_SIZE; row_start < depth; row_start += TRSM_GROUP_SIZE) {
+            int update_row = row_start + local_row;
+            lower_tile[local_row][local_col] = update_row < depth && diagonal_col < depth ? l[(long)update_row * lower_pitch + diagonal_col] : 0.0f;
+            barrier(CLK_LOCAL_MEM_FENCE);
+
+            real sum = 0.0f;
+            for (int k = 0; k < TRSM_GROUP_SIZE; k++) {
+                sum = mad(lower_tile[local_row][k], solution_tile[k][local_col], sum);
+            }
+            if (in_range && update_row < depth) {
+                x[(long)update_row * pitch] -= sum;
+            }
+            barrier(CLK_LOCAL_MEM_FENCE);
         }
     }
 }
 
-__kernel void lu_update_trailing_matrix(__global float* matrix, int block_offset, int matrix_size) {
-    int global_col = get_global_id(0) + block_offset + BLOCK_SIZE;
-    int global_row = get_global_id(1) + block_offset + BLOCK_SIZE;
+__kernel void ooc_update_block(__global real* target, long target_row, int target_col, long rows, int columns, __global const real* lower, long lower_row, int lower_col, long upper_row, int pitch, int lower_pitch, int depth) {
+    __local real lower_tile[TRSM_GROUP_SIZE][TRSM_GROUP_SIZE];
+    __local real upper_tile[TRSM_GROUP_SIZE][TRSM_GROUP_SIZE];
+
+    int local_col = get_local_id(0);
+    int local_row = get_local_id(1);
+    long row = (long)get_group_id(1) * TRSM_GROUP_SIZE + local_row;
+    int col = get_group_id(0) * TRSM_GROUP_SIZE + local_col;
+
+    real sum = 0.0f;
+    for (int k_start = 0; k_start < depth; k_start += TRSM_GROUP_SIZE) {
+        int lower_k = k_start + local_col;
+        int upper_k = k_start + local_row;
+        lower_tile[local_row][local_col] = row < rows && lower_k < depth ? lower[(lower_row + row) * lower_pitch + lower_col + lower_k] : 0.0f;
+        upper_tile[local_row][local_col] = col < columns && upper_k < depth ? target[(upper_row + upper_k) * pitch + target_col + col] : 0.0f;
+        barrier(CLK_LOCAL_MEM_FENCE);
 
-    if (global_row >= matrix_size || global_col >= matrix_size) {
+        for (int k = 0; k < TRSM_GROUP_SIZE; k++) {
+            sum = mad(lower_tile[local_row][k], upper_tile[k][local_col], sum);
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    if (row < rows && col < columns) {
+        target[(target_row + row) * pitch + target_col + col] -= sum;
+    }
+}
+
+__kernel void ooc_apply_row_swaps(__global real* target, int col_begin, int columns, long row_begin, int depth, int pitch, __global const long* pivots, long pivot_begin) {
+    int col = get_global_id(0);
+    if (col >= columns) {
         return;
     }
 
-    float sum = 0.0f;
-    for (int i = 0; i < BLOCK_SIZE; i++) {
-        sum += matrix[global_row * matrix_size + (block_offset + i)] * matrix[(block_offset + i) * matrix_size + global_col];
+    __global real* column = target + col_begin + col;
+    for (int i = 0; i < depth; i++) {
+        long row = row_begin + i;
+        long pivot_row_index = pivots[pivot_begin + i];
+        if (pivot_row_index != row) {
+            real temp = column[row * pitch];
+            column[row * pitch] = column[pivot_row_index * pitch];
+            column[pivot_row_index * pitch] = temp;
+        }
     }
-    
-    matrix[global_row * matrix_size + global_col] -= sum;
 }
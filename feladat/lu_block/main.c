@@ -1,12 +1,18 @@
 #define CL_TARGET_OPENCL_VERSION 220
 
 #include "matrix.h"
+#include "out_of_core.h"
+#include "multi_device.h"
+#include "matrix_file.h"
 #include "file.h"
+#include "cpu_solver.h"
+#include "simd_kernels.h"
+#include "refinement.h"
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
 #include <math.h>
+#include <string.h>
 
 #ifdef _WIN32
     #include <direct.h>
@@ -19,16 +25,664 @@
 int MATRIX_SIZE = 1000;
 
 #define MAX_MATRIX_SIZE_CPU 2000
+#define MAX_MATRIX_SIZE_INT_INDEX 46340
+
+static int host_transfer_measured(const lu_solver* solver) {
+    return strcmp(solver->transfer_mode, "pageable") == 0 || strcmp(solver->transfer_mode, "pinned") == 0;
+}
+
+static void run_solver_benchmark(int size, int warm_runs) {
+    float* source = malloc(size * size * sizeof(float));
+    if (source == NULL) {
+        return;
+    }
+
+    generate_matrix(source, size);
+
+    float mantissa;
+    long long exponent;
+    int sign;
+    int error_code;
+
+    double start_cold = wall_clock_seconds();
+
+    lu_solver* solver = lu_solver_create(&error_code);
+    if (solver == NULL) {
+        printf("Failed to initialize OpenCL solver (error %d)\n", error_code);
+        free(source);
+        return;
+    }
+
+    float* work = matrix_alloc(solver, size, &error_code);
+    if (work == NULL) {
+        printf("Failed to allocate the host matrix buffer (error %d)\n", error_code);
+        lu_solver_release(solver);
+        free(source);
+        return;
+    }
+    matrix_copy(solver, work, source, size);
+
+    lu_solver_calculate_determinant(solver, work, size, &mantissa, &exponent, &sign, NULL, NULL, NULL, &error_code);
+    if (error_code != 0) {
+        printf("Failed to allocate device buffers (error %d)\n", error_code);
+        matrix_free(solver, work);
+        lu_solver_release(solver);
+        free(source);
+        return;
+    }
+
+    double end_cold = wall_clock_seconds();
+    float cold_time = (float)(end_cold - start_cold);
+
+    float warm_total = 0.0f;
+    float warm_best = 0.0f;
+    float write_total = 0.0f;
+
+    for (int run = 0; run < warm_runs; run++) {
+        matrix_copy(solver, work, source, size);
+
+        float time_write;
+        double start_warm = wall_clock_seconds();
+        lu_solver_calculate_determinant(solver, work, size, &mantissa, &exponent, &sign, &time_write, NULL, NULL, &error_code);
+        double end_warm = wall_clock_seconds();
+        write_total += time_write;
+
+        float warm_time = (float)(end_warm - start_warm);
+        warm_total += warm_time;
+        if (run == 0 || warm_time < warm_best) {
+            warm_best = warm_time;
+        }
+    }
+
+    float warm_average = warm_total / warm_runs;
+
+    printf("\n===================================\n");
+    printf("Solver benchmark (%d warm runs)\n", warm_runs);
+    printf("-----------------------------------\n");
+    printf("Cold call (setup + solve): %.6f s\n", cold_time);
+    printf("Warm call (average): %.6f s\n", warm_average);
+    printf("Warm call (best): %.6f s\n", warm_best);
+    if (warm_average > 0.0f) {
+        printf("Cold / warm ratio: %.2fx\n", cold_time / warm_average);
+    }
+    printf("Host buffer: %s", solver->transfer_mode);
+    if (write_total > 0.0f && host_transfer_measured(solver)) {
+        printf(", CPU -> GPU %.2f GB/s", (double)size * size * sizeof(float) * warm_runs / write_total / 1.0e9);
+    }
+    printf("\n");
+    printf("===================================\n");
+
+    write_benchmark_to_file("outputs/benchmark_gpu_cold.txt", size, cold_time);
+    write_benchmark_to_file("outputs/benchmark_gpu_warm.txt", size, warm_average);
+
+    matrix_free(solver, work);
+    lu_solver_release(solver);
+    free(source);
+}
+
+static int parse_precision_mode(const char* name, precision_mode* out_precision) {
+    static const precision_mode modes[] = {PRECISION_FP32, PRECISION_MIXED, PRECISION_FP64};
+    for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+        if (strcmp(name, precision_mode_name(modes[i])) == 0) {
+            *out_precision = modes[i];
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void run_precision_benchmark(int size) {
+    static const precision_mode modes[] = {PRECISION_FP32, PRECISION_MIXED, PRECISION_MIXED, PRECISION_FP64};
+    static const int probes[] = {0, REFINEMENT_PROBE_COUNT, 0, 0};
+
+    float* source = malloc(size * size * sizeof(float));
+    float* work = malloc(size * size * sizeof(float));
+    if (source == NULL || work == NULL) {
+        free(source);
+        free(work);
+        return;
+    }
+
+    generate_matrix(source, size);
+    memcpy(work, source, size * size * sizeof(float));
+
+    int reference_sign = 1;
+    double reference_log10 = calculate_log10_determinant_double(work, size, &reference_sign);
+
+    int error_code;
+    lu_solver* solver = lu_solver_create(&error_code);
+    if (solver == NULL) {
+        printf("Failed to initialize OpenCL solver (error %d)\n", error_code);
+        free(source);
+        free(work);
+        return;
+    }
+
+    printf("\n===================================\n");
+    printf("Precision benchmark (%dx%d)\n", size, size);
+    printf("-----------------------------------\n");
+    printf("%-6s | %-6s | %-10s | %-10s | %-10s | %-10s | %-10s\n", "Mode", "Probes", "Block", "Compute", "Refine", "Refine/fp32", "Rel error");
+
+    float fp32_time = 0.0f;
+    for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+        lu_solver_set_precision(solver, modes[i], &error_code);
+        if (error_code != 0) {
+            printf("%-6s | not supported on this device (error %d)\n", precision_mode_name(modes[i]), error_code);
+            continue;
+        }
+        lu_solver_set_refinement_probes(solver, probes[i], &error_code);
+
+        float mantissa, time_write, time_calc, time_read;
+        long long exponent;
+        int sign;
+
+        memcpy(work, source, size * size * sizeof(float));
+        lu_solver_calculate_determinant(solver, work, size, &mantissa, &exponent, &sign, &time_write, &time_calc, &time_read, &error_code);
+        if (error_code != 0) {
+            printf("%-6s | failed to allocate device buffers (error %d)\n", precision_mode_name(modes[i]), error_code);
+            continue;
+        }
+        if (modes[i] == PRECISION_FP32) {
+            fp32_time = time_calc;
+        }
+
+        double error = isinf(reference_log10) || isinf(solver->log10_determinant)
+            ? (isinf(reference_log10) && isinf(solver->log10_determinant) ? 0.0 : INFINITY)
+            : fabs(pow(10.0, solver->log10_determinant - reference_log10) - 1.0);
+
+        char probe_label[16] = "-";
+        if (modes[i] == PRECISION_MIXED) {
+            snprintf(probe_label, sizeof(probe_label), probes[i] > 0 && probes[i] < size ? "%d" : "exact", probes[i]);
+        }
+
+        printf("%-6s | %-6s | %-10d | %-8.4f s | %-8.4f s | %-11.3f | %.2e%s\n",
+               precision_mode_name(modes[i]), probe_label, solver->block_size, time_calc, solver->time_refinement,
+               fp32_time > 0.0f ? solver->time_refinement / fp32_time : 0.0f, error,
+               sign == reference_sign ? "" : " (sign mismatch)");
+    }
+    printf("===================================\n");
+
+    lu_solver_release(solver);
+    free(source);
+    free(work);
+}
+
+static int parse_device_layout(const char* name, device_layout* out_layout) {
+    static const device_layout layouts[] = {DEVICE_LAYOUT_ROW_MAJOR, DEVICE_LAYOUT_COLUMN_MAJOR, DEVICE_LAYOUT_TILED};
+    for (size_t i = 0; i < sizeof(layouts) / sizeof(layouts[0]); i++) {
+        if (strcmp(name, device_layout_name(layouts[i])) == 0) {
+            *out_layout = layouts[i];
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static float best_compute_time(lu_solver* solver, const float* source, float* work, int size, float* out_time_layout) {
+    float mantissa, time_calc;
+    long long exponent;
+    int sign;
+    int error_code;
+    float best_calc = 0.0f;
+
+    memcpy(work, source, (size_t)size * size * sizeof(float));
+    lu_solver_calculate_determinant(solver, work, size, &mantissa, &exponent, &sign, NULL, &time_calc, NULL, &error_code);
+    if (error_code != 0) {
+        printf("Failed to allocate device buffers for %dx%d (error %d)\n", size, size, error_code);
+        return 0.0f;
+    }
+    for (int run = 0; run < 3; run++) {
+        memcpy(work, source, (size_t)size * size * sizeof(float));
+        lu_solver_calculate_determinant(solver, work, size, &mantissa, &exponent, &sign, NULL, &time_calc, NULL, &error_code);
+        if (run == 0 || time_calc < best_calc) {
+            best_calc = time_calc;
+            if (out_time_layout != NULL) *out_time_layout = solver->time_layout;
+        }
+    }
+    return best_calc;
+}
+
+static void run_layout_benchmark(int max_size) {
+    static const device_layout layouts[] = {DEVICE_LAYOUT_ROW_MAJOR, DEVICE_LAYOUT_COLUMN_MAJOR, DEVICE_LAYOUT_TILED};
+
+    float* source = malloc((size_t)max_size * max_size * sizeof(float));
+    float* work = malloc((size_t)max_size * max_size * sizeof(float));
+    if (source == NULL || work == NULL) {
+        free(source);
+        free(work);
+        return;
+    }
+
+    int error_code;
+    lu_solver* solver = lu_solver_create(&error_code);
+    if (solver == NULL) {
+        printf("Failed to initialize OpenCL solver (error %d)\n", error_code);
+        free(source);
+        free(work);
+        return;
+    }
+
+    printf("\n===================================\n");
+    printf("Layout benchmark (block size %d, best of 3)\n", solver->block_size);
+    printf("-----------------------------------\n");
+    printf("%-6s | %-12s | %-6s | %-10s | %-10s | %-10s\n", "Size", "Layout", "LD", "Convert", "Compute", "GFLOP/s");
+
+    int size = 256 < max_size ? 256 : max_size;
+    while (size <= max_size) {
+        generate_matrix(source, size);
+
+        for (size_t i = 0; i < sizeof(layouts) / sizeof(layouts[0]); i++) {
+            lu_solver_set_layout(solver, layouts[i], &error_code);
+            if (error_code != 0) {
+                printf("%-6d | %-12s | build failed (error %d)\n", size, device_layout_name(layouts[i]), error_code);
+                continue;
+            }
+
+            float best_layout = 0.0f;
+            float best_calc = best_compute_time(solver, source, work, size, &best_layout);
+
+            printf("%-6d | %-12s | %-6d | %-8.4f s | %-8.4f s | %.2f\n", size, device_layout_name(layouts[i]), solver->leading_dimension, best_layout, best_calc,
+                   best_calc > 0.0f ? 2.0 * size * size * size / 3.0 / best_calc / 1.0e9 : 0.0);
+
+            char path[128];
+            snprintf(path, sizeof(path), "outputs/benchmark_gpu_layout_%s.txt", device_layout_name(layouts[i]));
+            write_benchmark_to_file(path, size, best_calc + best_layout);
+        }
+
+        if (size == max_size) break;
+        size = size * 2 < max_size ? size * 2 : max_size;
+    }
+    printf("===================================\n");
+
+    lu_solver_release(solver);
+    free(source);
+    free(work);
+}
+
+static void run_padding_benchmark(int max_size, device_layout layout) {
+    float* source = malloc((size_t)(max_size + 1) * (max_size + 1) * sizeof(float));
+    float* work = malloc((size_t)(max_size + 1) * (max_size + 1) * sizeof(float));
+    if (source == NULL || work == NULL) {
+        free(source);
+        free(work);
+        return;
+    }
+
+    int error_code;
+    lu_solver* solver = lu_solver_create(&error_code);
+    if (solver == NULL) {
+        printf("Failed to initialize OpenCL solver (error %d)\n", error_code);
+        free(source);
+        free(work);
+        return;
+    }
+
+    lu_solver_set_layout(solver, layout, &error_code);
+    if (error_code != 0) {
+        printf("Failed to build the %s layout kernels (error %d)\n", device_layout_name(layout), error_code);
+        lu_solver_release(solver);
+        free(source);
+        free(work);
+        return;
+    }
+
+    printf("\n===================================\n");
+    printf("Padding benchmark (%s, block size %d, best of 3)\n", device_layout_name(layout), solver->block_size);
+    printf("-----------------------------------\n");
+    printf("%-6s | %-6s | %-6s | %-10s | %-10s\n", "Size", "Padded", "LD", "Compute", "GFLOP/s");
+
+    int power = 256 < max_size ? 256 : max_size;
+    while (power <= max_size) {
+        for (int size = power - 1; size <= power + 1; size++) {
+            generate_matrix(source, size);
+            float best_calc = best_compute_time(solver, source, work, size, NULL);
+
+            printf("%-6d | %-6d | %-6d | %-8.4f s | %.2f\n", size, solver->padded_size, solver->leading_dimension, best_calc,
+                   best_calc > 0.0f ? 2.0 * size * size * size / 3.0 / best_calc / 1.0e9 : 0.0);
+            write_benchmark_to_file("outputs/benchmark_gpu_padding.txt", size, best_calc);
+        }
+
+        if (power == max_size) break;
+        power = power * 2 < max_size ? power * 2 : max_size;
+    }
+    printf("===================================\n");
+
+    lu_solver_release(solver);
+    free(source);
+    free(work);
+}
+
+static float* load_matrix_input(const char* path, int verify, matrix_file* file, int* size) {
+    int error_code;
+    double start = wall_clock_seconds();
+
+    matrix_file_open(path, file, &error_code);
+    if (error_code != 0) {
+        printf("Failed to open matrix file %s (error %d)\n", path, error_code);
+        return NULL;
+    }
+
+    if (file->header.rows != file->header.cols || file->header.rows > MAX_MATRIX_SIZE_INT_INDEX) {
+        printf("Matrix file %s is %llux%llu, expected a square matrix up to %d\n", path,
+               (unsigned long long)file->header.rows, (unsigned long long)file->header.cols, MAX_MATRIX_SIZE_INT_INDEX);
+        matrix_file_close(file);
+        return NULL;
+    }
+
+    if (verify && matrix_file_verify(file) != 0) {
+        printf("Checksum mismatch in matrix file %s\n", path);
+        matrix_file_close(file);
+        return NULL;
+    }
+
+    float* matrix = matrix_file_floats(file, &error_code);
+    if (matrix == NULL) {
+        printf("Failed to convert matrix file %s (error %d)\n", path, error_code);
+        matrix_file_close(file);
+        return NULL;
+    }
+
+    double elapsed = wall_clock_seconds() - start;
+    double bytes = (double)file->header.rows * file->header.cols * matrix_element_size((matrix_element_type)file->header.element_type);
+    *size = (int)file->header.rows;
+
+    printf("Loaded %s: %dx%d %s, %s, %.1f MB in %.4f s", path, *size, *size,
+           file->header.element_type == MATRIX_ELEMENT_FLOAT64 ? "float64" : "float32",
+           file->header.layout == MATRIX_LAYOUT_COLUMN_MAJOR ? "column-major" : "row-major", bytes / 1048576.0, elapsed);
+    if (elapsed > 0.0) {
+        printf(" (%.2f GB/s%s)", bytes / elapsed / 1.0e9, verify && (file->header.flags & MATRIX_FILE_HAS_CHECKSUM) ? ", checksum verified" : ", mapped only");
+    }
+    printf("\n");
+
+    return matrix;
+}
+
+static void release_matrix_source(float* matrix_source, matrix_file* input_file) {
+    if (input_file != NULL) {
+        matrix_file_close(input_file);
+    } else {
+        free(matrix_source);
+    }
+}
+
+static void run_out_of_core_benchmark(float* input, int size, int budget_mb, int cpu_threads) {
+    size_t matrix_bytes = (size_t)size * size * sizeof(float);
+    size_t device_budget = (size_t)budget_mb << 20;
+
+    float* matrix = input;
+    if (matrix == NULL) {
+        matrix = malloc(matrix_bytes);
+        if (matrix == NULL) {
+            printf("Failed to allocate the %.1f MB host matrix\n", matrix_bytes / 1048576.0);
+            return;
+        }
+        generate_matrix(matrix, size);
+    }
+
+    float cpu_mantissa = 0.0f;
+    long long cpu_exponent = 0;
+    int cpu_sign = 1;
+    int cpu_computed = size <= MAX_MATRIX_SIZE_INT_INDEX;
+    if (cpu_computed) {
+        float* reference = malloc(matrix_bytes);
+        cpu_computed = reference != NULL;
+        if (cpu_computed) {
+            memcpy(reference, matrix, matrix_bytes);
+            calculate_determinant_blocked(reference, size, cpu_threads > 0 ? cpu_threads : cpu_thread_count(), &cpu_mantissa, &cpu_exponent, &cpu_sign);
+            free(reference);
+        }
+    }
+
+    int error_code;
+    lu_solver* solver = lu_solver_create(&error_code);
+    if (solver == NULL) {
+        printf("Failed to initialize OpenCL solver (error %d)\n", error_code);
+        if (input == NULL) {
+            free(matrix);
+        }
+        return;
+    }
+
+    float mantissa;
+    long long exponent;
+    int sign;
+    out_of_core_stats stats;
+    calculate_determinant_out_of_core(solver, matrix, size, device_budget, &mantissa, &exponent, &sign, &stats, &error_code);
+
+    printf("\n===================================\n");
+    printf("Out-of-core LU (%dx%d)\n", size, size);
+    printf("-----------------------------------\n");
+    printf("Matrix: %.1f MB, device budget: %.1f MB%s\n", matrix_bytes / 1048576.0, device_budget / 1048576.0,
+           matrix_bytes > device_budget ? " (matrix exceeds budget)" : "");
+
+    if (error_code != 0) {
+        printf("Out-of-core solve failed (error %d)\n", error_code);
+    } else {
+        double transferred = stats.bytes_uploaded + stats.bytes_downloaded;
+        printf("Slab width: %d (%lld slabs), device working set: %.1f MB\n", stats.slab_width, stats.slab_count, stats.working_set_bytes / 1048576.0);
+        printf("Transfers: %.2f GB in %.4f s", transferred / 1.0e9, stats.time_transfer);
+        if (stats.time_transfer > 0.0f) {
+            printf(" (%.2f GB/s)", transferred / stats.time_transfer / 1.0e9);
+        }
+        printf("\n");
+        printf("Device compute: %.4f s\n", stats.time_compute);
+        printf("Total: %.4f s\n", stats.time_total);
+
+        if (mantissa == 0.0f) {
+            printf("Determinant (out-of-core): 0\n");
+        } else {
+            printf("Determinant (out-of-core): %s%.4f * 10^%lld\n", sign < 0 ? "-" : "", mantissa, exponent);
+        }
+
+        if (cpu_computed && cpu_mantissa != 0.0f) {
+            double ratio = ((double)sign * mantissa) / ((double)cpu_sign * cpu_mantissa) * pow(10.0, (double)(exponent - cpu_exponent));
+            printf("Relative error vs CPU: %.6f %%\n", fabs(ratio - 1.0) * 100.0);
+        }
+    }
+    printf("===================================\n");
+
+    lu_solver_release(solver);
+    if (input == NULL) {
+        free(matrix);
+    }
+}
+
+static void run_multi_device_benchmark(float* input, int size, int cpu_partitions, int cpu_threads) {
+    size_t matrix_bytes = (size_t)size * size * sizeof(float);
+    float* matrix = malloc(matrix_bytes);
+    float* reference = malloc(matrix_bytes);
+    if (matrix == NULL || reference == NULL) {
+        printf("Failed to allocate the %.1f MB host matrix\n", matrix_bytes / 1048576.0);
+        free(matrix);
+        free(reference);
+        return;
+    }
+    if (input != NULL) {
+        memcpy(reference, input, matrix_bytes);
+    } else {
+        generate_matrix(reference, size);
+    }
+    memcpy(matrix, reference, matrix_bytes);
+
+    float cpu_mantissa = 0.0f;
+    long long cpu_exponent = 0;
+    int cpu_sign = 1;
+    calculate_determinant_blocked(reference, size, cpu_threads > 0 ? cpu_threads : cpu_thread_count(), &cpu_mantissa, &cpu_exponent, &cpu_sign);
+
+    int error_code;
+    multi_device_solver* solver = create_multi_device_solver(cpu_partitions, &error_code);
+    if (solver == NULL) {
+        printf("Failed to initialize the OpenCL devices (error %d)\n", error_code);
+        free(matrix);
+        free(reference);
+        return;
+    }
+
+    float mantissa;
+    long long exponent;
+    int sign;
+    calculate_determinant_multi_device(solver, matrix, size, &mantissa, &exponent, &sign, &error_code);
+
+    printf("\n===================================\n");
+    printf("Multi-device LU (%dx%d, %d devices, block width %d)\n", size, size, solver->device_count, solver->block_width);
+    printf("-----------------------------------\n");
+
+    if (error_code != 0) {
+        printf("Multi-device solve failed (error %d)\n", error_code);
+    } else {
+        printf("%-3s | %-28s | %-6s | %-10s | %-10s\n", "Dev", "Name", "Blocks", "Busy (s)", "GFLOP/s");
+        for (int d = 0; d < solver->device_count; d++) {
+            printf("%-3d | %-28.28s | %-6d | %-10.4f | %-10.2f\n", d, solver->solvers[d]->device_name, solver->block_columns[d], solver->time_busy[d], solver->throughput[d] / 1.0e9);
+        }
+        printf("Transfers (upload + panel broadcast): %.4f s\n", solver->time_transfer);
+        printf("Total: %.4f s\n", solver->time_total);
+
+        if (mantissa == 0.0f) {
+            printf("Determinant (multi-device): 0\n");
+        } else {
+            printf("Determinant (multi-device): %s%.4f * 10^%lld\n", sign < 0 ? "-" : "", mantissa, exponent);
+        }
+
+        if (cpu_mantissa != 0.0f) {
+            double ratio = ((double)sign * mantissa) / ((double)cpu_sign * cpu_mantissa) * pow(10.0, (double)(exponent - cpu_exponent));
+            printf("Relative error vs CPU: %.6f %%\n", fabs(ratio - 1.0) * 100.0);
+        }
+    }
+    printf("===================================\n");
+
+    release_multi_device_solver(solver);
+    free(matrix);
+    free(reference);
+}
+
+static void write_profile_outputs(const lu_solver* solver, int size, double wall_time, const char* profile_base, const char* trace_path) {
+    profile_info info;
+    info.engine = "opencl_blocked_lu";
+    info.device_id = solver->device_id;
+    info.matrix_size = size;
+    info.block_size = solver->block_size;
+    info.precision = precision_mode_name(solver->precision);
+    info.wall_time = wall_time;
+    info.flops = 2.0 * size * size * size / 3.0;
+
+    if (profile_base != NULL) {
+        char json_path[1024], csv_path[1024];
+        snprintf(json_path, sizeof(json_path), "%s.json", profile_base);
+        snprintf(csv_path, sizeof(csv_path), "%s.csv", profile_base);
+        if (write_profile_json(solver->profiler, &info, json_path) == 0 && write_profile_csv(solver->profiler, &info, csv_path) == 0) {
+            printf("Profile written to %s and %s\n", json_path, csv_path);
+        }
+    }
+
+    if (trace_path != NULL && write_chrome_trace(solver->profiler, trace_path) == 0) {
+        printf("Chrome trace written to %s\n", trace_path);
+    }
+}
 
 int main(int argc, char* argv[]) {
-    if (argc > 1) {
-        MATRIX_SIZE = atoi(argv[1]);
+    int warm_runs = 0;
+    int cpu_blocked = 1;
+    int cpu_threads = 0;
+    int compare_diagonal = 0;
+    int autotune = 0;
+    int precision_benchmark = 0;
+    int pipelined_upload = 1;
+    int out_of_core_budget_mb = 0;
+    int multi_device = 0;
+    int cpu_partitions = 0;
+    const char* input_path = NULL;
+    const char* save_path = NULL;
+    int verify_input = 1;
+    const char* profile_base = NULL;
+    const char* trace_path = NULL;
+    precision_mode precision = PRECISION_FP32;
+    int refinement_probes = REFINEMENT_PROBE_COUNT;
+    device_layout layout = DEVICE_LAYOUT_ROW_MAJOR;
+    int layout_benchmark = 0;
+    int padding_benchmark = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--warm") == 0 && i + 1 < argc) {
+            warm_runs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--cpu") == 0 && i + 1 < argc) {
+            cpu_blocked = strcmp(argv[++i], "naive") != 0;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            cpu_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--compare-diagonal") == 0) {
+            compare_diagonal = 1;
+        } else if (strcmp(argv[i], "--autotune") == 0) {
+            autotune = 1;
+        } else if (strcmp(argv[i], "--precision") == 0 && i + 1 < argc) {
+            if (!parse_precision_mode(argv[++i], &precision)) {
+                printf("Unknown precision mode: %s (expected fp32, mixed or fp64)\n", argv[i]);
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--refinement-probes") == 0 && i + 1 < argc) {
+            refinement_probes = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--layout") == 0 && i + 1 < argc) {
+            if (!parse_device_layout(argv[++i], &layout)) {
+                printf("Unknown device layout: %s (expected row-major, column-major or tiled)\n", argv[i]);
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--layout-benchmark") == 0) {
+            layout_benchmark = 1;
+        } else if (strcmp(argv[i], "--padding-benchmark") == 0) {
+            padding_benchmark = 1;
+        } else if (strcmp(argv[i], "--precision-benchmark") == 0) {
+            precision_benchmark = 1;
+        } else if (strcmp(argv[i], "--serial-upload") == 0) {
+            pipelined_upload = 0;
+        } else if (strcmp(argv[i], "--out-of-core") == 0 && i + 1 < argc) {
+            out_of_core_budget_mb = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--multi-device") == 0) {
+            multi_device = 1;
+        } else if (strcmp(argv[i], "--partition-cpu") == 0 && i + 1 < argc) {
+            cpu_partitions = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+            input_path = argv[++i];
+        } else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc) {
+            save_path = argv[++i];
+        } else if (strcmp(argv[i], "--no-verify") == 0) {
+            verify_input = 0;
+        } else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            profile_base = argv[++i];
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else {
+            MATRIX_SIZE = atoi(argv[i]);
+        }
+    }
+
+    int error_code;
+    matrix_file input_file;
+    float* matrix_input = NULL;
+    if (input_path != NULL) {
+        matrix_input = load_matrix_input(input_path, verify_input, &input_file, &MATRIX_SIZE);
+        if (matrix_input == NULL) {
+            return -1;
+        }
+    }
+
+    if (multi_device) {
+        run_multi_device_benchmark(matrix_input, MATRIX_SIZE, cpu_partitions, cpu_threads);
+        if (matrix_input != NULL) {
+            matrix_file_close(&input_file);
+        }
+        return 0;
+    }
+
+    if (out_of_core_budget_mb > 0) {
+        run_out_of_core_benchmark(matrix_input, MATRIX_SIZE, out_of_core_budget_mb, cpu_threads);
+        if (matrix_input != NULL) {
+            matrix_file_close(&input_file);
+        }
+        return 0;
     }
 
-    float* matrix_gpu = malloc(MATRIX_SIZE * MATRIX_SIZE * sizeof(float));
-    float* matrix_cpu = malloc(MATRIX_SIZE * MATRIX_SIZE * sizeof(float));
+    float* matrix_source = matrix_input != NULL ? matrix_input : malloc((size_t)MATRIX_SIZE * MATRIX_SIZE * sizeof(float));
+    float* matrix_cpu = malloc((size_t)MATRIX_SIZE * MATRIX_SIZE * sizeof(float));
 
-    if (matrix_gpu == NULL || matrix_cpu == NULL) {
+    if (matrix_source == NULL || matrix_cpu == NULL) {
         return -1;
     }
 
@@ -38,16 +692,27 @@ int main(int argc, char* argv[]) {
         mkdir("outputs", 0777);
     #endif
 
-    generate_matrix(matrix_gpu, MATRIX_SIZE);
-    for (int i = 0; i < MATRIX_SIZE * MATRIX_SIZE; i++) {
-        matrix_cpu[i] = matrix_gpu[i];
+    if (matrix_input == NULL) {
+        generate_matrix(matrix_source, MATRIX_SIZE);
+    }
+    memcpy(matrix_cpu, matrix_source, (size_t)MATRIX_SIZE * MATRIX_SIZE * sizeof(float));
+
+    if (save_path != NULL) {
+        double start_save = wall_clock_seconds();
+        write_matrix_file(save_path, matrix_source, MATRIX_SIZE, &error_code);
+        double save_time = wall_clock_seconds() - start_save;
+        if (error_code != 0) {
+            printf("Failed to write matrix file %s (error %d)\n", save_path, error_code);
+        } else {
+            printf("Saved %s: %.1f MB in %.4f s\n", save_path, (double)MATRIX_SIZE * MATRIX_SIZE * sizeof(float) / 1048576.0, save_time);
+        }
     }
 
     if (MATRIX_SIZE <= 10) {
         printf("\nGenerated Matrix (%dx%d):\n", MATRIX_SIZE, MATRIX_SIZE);
         for (int i = 0; i < MATRIX_SIZE; i++) {
             for (int j = 0; j < MATRIX_SIZE; j++) {
-                printf("%2.0f ", matrix_gpu[i*MATRIX_SIZE+j]);
+                printf("%2.0f ", matrix_source[i*MATRIX_SIZE+j]);
             }
             printf("\n");
         }
@@ -61,13 +726,24 @@ int main(int argc, char* argv[]) {
     printf("CPU\n");
     printf("-----------------------------------\n");
 
-    if (MATRIX_SIZE <= MAX_MATRIX_SIZE_CPU) {
-        clock_t start_cpu = clock();
+    int cpu_computed = cpu_blocked || MATRIX_SIZE <= MAX_MATRIX_SIZE_CPU;
+
+    if (cpu_computed) {
+        double start_cpu = wall_clock_seconds();
         
-        calculate_determinant_gauss(matrix_cpu, MATRIX_SIZE, &cpu_mantissa, &cpu_exponent, &cpu_sign);
+        if (cpu_blocked) {
+            if (cpu_threads <= 0) {
+                cpu_threads = cpu_thread_count();
+            }
+            printf("Engine: blocked LU, %d threads, %s\n", cpu_threads, select_simd_kernels()->name);
+            calculate_determinant_blocked(matrix_cpu, MATRIX_SIZE, cpu_threads, &cpu_mantissa, &cpu_exponent, &cpu_sign);
+        } else {
+            printf("Engine: naive Gauss, %s\n", select_simd_kernels()->name);
+            calculate_determinant_gauss(matrix_cpu, MATRIX_SIZE, &cpu_mantissa, &cpu_exponent, &cpu_sign);
+        }
         
-        clock_t end_cpu = clock();
-        float cpu_time = (float)(end_cpu - start_cpu) / CLOCKS_PER_SEC;
+        double end_cpu = wall_clock_seconds();
+        float cpu_time = (float)(end_cpu - start_cpu);
 
         printf("Execution time (CPU): %.4f s\n", cpu_time);
         
@@ -79,7 +755,7 @@ int main(int argc, char* argv[]) {
         
         write_benchmark_to_file("outputs/benchmark_cpu.txt", MATRIX_SIZE, cpu_time);
     } else {
-        printf("Skipped (Matrix size > %d)\n", MAX_MATRIX_SIZE_CPU);
+        printf("Skipped (Matrix size > %d, use --cpu blocked)\n", MAX_MATRIX_SIZE_CPU);
     }
 
     printf("===================================\n");
@@ -91,12 +767,103 @@ int main(int argc, char* argv[]) {
     int gpu_sign;
     float gpu_time_write, gpu_time_calc, gpu_time_read;
 
-    clock_t start_gpu = clock();
+    if (autotune) {
+        lu_solver* tuning_solver = lu_solver_create(&error_code);
+        if (tuning_solver == NULL) {
+            printf("Failed to initialize OpenCL solver (error %d)\n", error_code);
+            release_matrix_source(matrix_source, matrix_input != NULL ? &input_file : NULL);
+            free(matrix_cpu);
+            return -1;
+        }
+
+        printf("Autotuning block size on %s (%dx%d):\n", tuning_solver->device_name, MATRIX_SIZE, MATRIX_SIZE);
+        int tuned_block_size = lu_solver_autotune(tuning_solver, MATRIX_SIZE, &error_code);
+        if (error_code != 0) {
+            printf("Autotuning failed (error %d)\n", error_code);
+        } else {
+            printf("Selected block size: %d (saved to %s)\n", tuned_block_size, BLOCK_SIZE_TUNING_FILE);
+        }
+        printf("-----------------------------------\n");
+
+        lu_solver_release(tuning_solver);
+    }
+
+    double start_gpu = wall_clock_seconds();
+
+    lu_solver* solver = lu_solver_create(&error_code);
+    if (solver == NULL) {
+        printf("Failed to initialize OpenCL solver (error %d)\n", error_code);
+        release_matrix_source(matrix_source, matrix_input != NULL ? &input_file : NULL);
+        free(matrix_cpu);
+        return -1;
+    }
+
+    solver->read_back_matrix = compare_diagonal;
+    solver->pipelined_upload = pipelined_upload;
+    if (profile_base != NULL || trace_path != NULL) {
+        solver->profiler = create_profiler();
+    }
+
+    lu_solver_set_precision(solver, precision, &error_code);
+    if (error_code != 0) {
+        printf("Precision mode %s is not supported on %s (error %d)\n", precision_mode_name(precision), solver->device_name, error_code);
+        lu_solver_release(solver);
+        release_matrix_source(matrix_source, matrix_input != NULL ? &input_file : NULL);
+        free(matrix_cpu);
+        return -1;
+    }
+
+    lu_solver_set_refinement_probes(solver, refinement_probes, &error_code);
+    if (error_code != 0) {
+        printf("Invalid refinement probe count: %d\n", refinement_probes);
+        lu_solver_release(solver);
+        release_matrix_source(matrix_source, matrix_input != NULL ? &input_file : NULL);
+        free(matrix_cpu);
+        return -1;
+    }
+
+    lu_solver_set_layout(solver, layout, &error_code);
+    if (error_code != 0) {
+        printf("Failed to build the %s layout kernels (error %d)\n", device_layout_name(layout), error_code);
+        lu_solver_release(solver);
+        release_matrix_source(matrix_source, matrix_input != NULL ? &input_file : NULL);
+        free(matrix_cpu);
+        return -1;
+    }
+
+    float* matrix_gpu = matrix_input;
+    if (matrix_gpu == NULL) {
+        matrix_gpu = matrix_alloc(solver, MATRIX_SIZE, &error_code);
+        if (matrix_gpu == NULL) {
+            printf("Failed to allocate the host matrix buffer (error %d)\n", error_code);
+            lu_solver_release(solver);
+            free(matrix_source);
+            free(matrix_cpu);
+            return -1;
+        }
+        matrix_copy(solver, matrix_gpu, matrix_source, MATRIX_SIZE);
+        free(matrix_source);
+    }
+
+    double end_setup = wall_clock_seconds();
+    float gpu_time_setup = (float)(end_setup - start_gpu);
     
-    calculate_determinant_gauss_opencl(matrix_gpu, MATRIX_SIZE, &gpu_mantissa, &gpu_exponent, &gpu_sign, &gpu_time_write, &gpu_time_calc, &gpu_time_read);
+    lu_solver_calculate_determinant(solver, matrix_gpu, MATRIX_SIZE, &gpu_mantissa, &gpu_exponent, &gpu_sign, &gpu_time_write, &gpu_time_calc, &gpu_time_read, &error_code);
+    if (error_code != 0) {
+        printf("Failed to allocate device buffers (error %d)\n", error_code);
+        if (matrix_input != NULL) {
+            matrix_file_close(&input_file);
+        } else {
+            matrix_free(solver, matrix_gpu);
+        }
+        release_profiler(solver->profiler);
+        lu_solver_release(solver);
+        free(matrix_cpu);
+        return -1;
+    }
     
-    clock_t end_gpu = clock();
-    float gpu_time = (float)(end_gpu - start_gpu) / CLOCKS_PER_SEC;
+    double end_gpu = wall_clock_seconds();
+    float gpu_time = (float)(end_gpu - start_gpu);
 
     if (gpu_mantissa == 0.0) {
         printf("Determinant (GPU): 0\n");
@@ -104,24 +871,63 @@ int main(int argc, char* argv[]) {
         printf("Determinant (GPU): %s%.4f * 10^%lld\n", gpu_sign < 0 ? "-" : "", gpu_mantissa, gpu_exponent);
     }
     
-    printf("CPU -> GPU: %.4f s\n", gpu_time_write);
-    printf("GPU Computing: %.4f s\n", gpu_time_calc);
-    printf("GPU -> CPU: %.4f s\n", gpu_time_read);
+    printf("OpenCL setup: %.4f s (program %s in %.4f s)\n", gpu_time_setup, solver->program_from_cache ? "loaded from binary cache" : "built from source", solver->time_build);
+    printf("Block size: %d\n", solver->block_size);
+    printf("Precision: %s\n", precision_mode_name(solver->precision));
+    printf("Device layout: %s (padded to %d, leading dimension %d)\n", device_layout_name(solver->layout), solver->padded_size, solver->leading_dimension);
+    double matrix_gigabytes = (double)MATRIX_SIZE * MATRIX_SIZE * sizeof(float) / 1.0e9;
+    printf("Host buffer: %s\n", solver->transfer_mode);
+    printf("CPU -> GPU: %.4f s", gpu_time_write);
+    if (gpu_time_write > 0.0f && host_transfer_measured(solver)) {
+        printf(" (%.2f GB/s)", matrix_gigabytes / gpu_time_write);
+    }
+    printf("\n");
+    printf("Host enqueue: %.4f s\n", solver->time_host_enqueue);
+    printf("GPU Computing: %.4f s", gpu_time_calc);
+    if (gpu_time_calc > 0.0f) {
+        printf(" (%.2f GFLOP/s)", 2.0 * MATRIX_SIZE * MATRIX_SIZE * MATRIX_SIZE / 3.0 / gpu_time_calc / 1.0e9);
+    }
+    printf("\n");
+    printf("  Panel factorization: %.4f s\n", solver->time_panel);
+    printf("  Row swaps: %.4f s\n", solver->time_swap);
+    printf("  Upper panel solve: %.4f s\n", solver->time_upper);
+    printf("  Trailing update: %.4f s", solver->time_trailing);
+    if (solver->time_trailing > 0.0f) {
+        printf(" (%.2f GFLOP/s)", solver->trailing_flops / solver->time_trailing / 1.0e9);
+    }
+    printf("\n");
+    printf("  Determinant reduction: %.4f s\n", solver->time_reduction);
+    if (solver->precision == PRECISION_MIXED) {
+        printf("  Refinement: %.4f s\n", solver->time_refinement);
+    }
+    printf("Layout conversion and padding: %.4f s\n", solver->time_layout);
+    printf("GPU -> CPU: %.4f s", gpu_time_read);
+    if (compare_diagonal && gpu_time_read > 0.0f && host_transfer_measured(solver)) {
+        printf(" (%.2f GB/s)", matrix_gigabytes / gpu_time_read);
+    }
+    printf("\n");
+    printf("Upload + compute (%s): %.4f s overlapped, %.4f s serialized sum\n", solver->pipelined_upload ? "pipelined" : "single write", solver->time_overlapped_total, solver->time_serialized_total);
     printf("Total execution time (GPU): %.4f s\n", gpu_time);
+    if (solver->profiler != NULL) {
+        write_profile_outputs(solver, MATRIX_SIZE, end_gpu - end_setup, profile_base, trace_path);
+    }
     printf("===================================\n");
     
-    if (MATRIX_SIZE <= MAX_MATRIX_SIZE_CPU) {
-        printf("\nDiagonal comparison:\n");
-        printf("%-5s | %-15s | %-15s | %-10s\n", "Index", "CPU Diagonal", "GPU Diagonal", "Diff");
-        printf("------------------------------------------------------------\n");
+    if (cpu_computed) {
+        if (compare_diagonal) {
+            printf("\nDiagonal comparison:\n");
+            printf("%-5s | %-15s | %-15s | %-10s\n", "Index", "CPU Diagonal", "GPU Diagonal", "Diff");
+            printf("------------------------------------------------------------\n");
 
-        int limit = (MATRIX_SIZE < 10) ? MATRIX_SIZE : 10;
-        for (int i = 0; i < limit; i++) {
-            float c_val = matrix_cpu[i * MATRIX_SIZE + i];
-            float g_val = matrix_gpu[i * MATRIX_SIZE + i];
-            printf("%-5d | %-15.6f | %-15.6f | %-10.6e\n", i, c_val, g_val, fabs(c_val - g_val));
+            int limit = (MATRIX_SIZE < 10) ? MATRIX_SIZE : 10;
+            int gpu_leading_dimension = matrix_leading_dimension(solver, matrix_gpu, MATRIX_SIZE);
+            for (int i = 0; i < limit; i++) {
+                float c_val = matrix_cpu[i * MATRIX_SIZE + i];
+                float g_val = matrix_gpu[(size_t)i * gpu_leading_dimension + i];
+                printf("%-5d | %-15.6f | %-15.6f | %-10.6e\n", i, c_val, g_val, fabs(c_val - g_val));
+            }
+            printf("===================================\n");
         }
-        printf("===================================\n");
 
         if (cpu_mantissa != 0.0) {
             double gpu_part = (double)(gpu_sign * gpu_mantissa);
@@ -135,9 +941,32 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    if (matrix_input != NULL) {
+        matrix_file_close(&input_file);
+    } else {
+        matrix_free(solver, matrix_gpu);
+    }
+    release_profiler(solver->profiler);
+    lu_solver_release(solver);
+
     write_benchmark_to_file("outputs/benchmark_gpu.txt", MATRIX_SIZE, gpu_time);
 
-    free(matrix_gpu);
+    if (warm_runs > 0) {
+        run_solver_benchmark(MATRIX_SIZE, warm_runs);
+    }
+
+    if (precision_benchmark) {
+        run_precision_benchmark(MATRIX_SIZE);
+    }
+
+    if (layout_benchmark) {
+        run_layout_benchmark(MATRIX_SIZE);
+    }
+
+    if (padding_benchmark) {
+        run_padding_benchmark(MATRIX_SIZE, layout);
+    }
+
     free(matrix_cpu);
 
     return 0;
@@ -3,96 +3,270 @@
 #include "matrix.h"
 #include "file.h"
 #include "kernel_loader.h"
+#include "simd_kernels.h"
+#include "scaled_product.h"
+#include "cpu_solver.h"
+#include "refinement.h"
 
 #include <CL/cl.h>
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
-#include <time.h>
+#include <string.h>
 
 #define BLOCK_SIZE 16
+#define PANEL_GROUP_SIZE 256
+#define TRAIL_GROUP_SIZE 16
+#define TRSM_GROUP_SIZE 16
+#define TRAIL_TILE_K 16
+#define AUTOTUNE_RUNS 3
 
-void generate_matrix(float* matrix, int size) {
-    srand(42);
-
-    for (int i = 0; i < size * size; i++) {
-        matrix[i] = (float)(rand() % 10); 
-        
-        if (i % size == i / size) {
-            matrix[i] += size * 10.0f; 
-        }
+double calculate_log10_determinant_double(const float* matrix, int size, int* out_sign) {
+    double* work = malloc((size_t)size * size * sizeof(double));
+    if (work == NULL) {
+        *out_sign = 1;
+        return NAN;
     }
-}
 
-void print_matrix(float* matrix, int size) {
-    for (int i = 0; i < size; i++) {
-        for (int j = 0; j < size; j++) {
-            printf("%.2f ", matrix[i * size + j]);
-        }
-        printf("\n");
+    for (size_t i = 0; i < (size_t)size * size; i++) {
+        work[i] = matrix[i];
     }
-}
 
-void calculate_determinant_gauss(float* matrix, int size, float* out_mantissa, long long* out_exponent, int* out_sign) {
     int sign = 1;
+    double log10_sum = 0.0;
 
-    for (int k = 0; k < size - 1; k++) {
-        float pivot = matrix[k * size + k];
+    for (int k = 0; k < size; k++) {
+        int max_row = k;
+        for (int i = k + 1; i < size; i++) {
+            if (fabs(work[(size_t)i * size + k]) > fabs(work[(size_t)max_row * size + k])) {
+                max_row = i;
+            }
+        }
 
+        double pivot = work[(size_t)max_row * size + k];
         if (fabs(pivot) < 1e-12) {
-            *out_mantissa = 0.0;
-            *out_exponent = 0;
+            free(work);
             *out_sign = 1;
-            return;
+            return -INFINITY;
         }
-    
+
+        if (max_row != k) {
+            for (int j = 0; j < size; j++) {
+                double temp = work[(size_t)k * size + j];
+                work[(size_t)k * size + j] = work[(size_t)max_row * size + j];
+                work[(size_t)max_row * size + j] = temp;
+            }
+            sign = -sign;
+        }
+
+        if (pivot < 0) {
+            sign = -sign;
+        }
+        log10_sum += log10(fabs(pivot));
+
         for (int i = k + 1; i < size; i++) {
-            float factor = matrix[i * size + k] / pivot;
-            
+            double factor = work[(size_t)i * size + k] / pivot;
             for (int j = k + 1; j < size; j++) {
-                matrix[i * size + j] -= factor * matrix[k * size + j];
+                work[(size_t)i * size + j] -= factor * work[(size_t)k * size + j];
             }
-            
-            matrix[i * size + k] = 0.0f;
         }
     }
 
-    float mantissa = 1.0;
-    long long exponent = 0;
+    free(work);
+    *out_sign = sign;
+    return log10_sum;
+}
 
-    for (int i = 0; i < size; i++) {
-        float val = matrix[i * size + i];
+static size_t device_element_size(const lu_solver* solver) {
+    return solver->precision == PRECISION_FP64 ? sizeof(cl_double) : sizeof(cl_float);
+}
 
-        if (fabs(val) < 1e-12) {
-            mantissa = 0.0;
-            exponent = 0; 
-            break;
-        }
+static size_t local_memory_required(const lu_solver* solver, int block_size) {
+    size_t element_size = device_element_size(solver);
+    size_t panel_memory = (size_t)solver->panel_group_size * (element_size + 2 * sizeof(int)) + (size_t)block_size * element_size;
+    size_t trsm_memory = ((size_t)block_size * block_size + (size_t)block_size * solver->trsm_group_size) * element_size;
+    size_t trailing_memory = 2 * (size_t)TRAIL_TILE_K * solver->trail_group_size * 4 * element_size;
 
-        if (val < 0) {
-            sign = -sign;
-            val = -val;
-        }
+    size_t required = panel_memory;
+    if (trsm_memory > required) required = trsm_memory;
+    if (trailing_memory > required) required = trailing_memory;
+    return required;
+}
 
-        mantissa *= val;
+int is_block_size_supported(const lu_solver* solver, int block_size) {
+    if (block_size <= 0 || block_size > solver->panel_group_size) return 0;
+    if ((size_t)solver->panel_group_size > solver->max_work_group_size) return 0;
+    return local_memory_required(solver, block_size) <= solver->local_mem_size;
+}
 
-        while (mantissa >= 10.0) {
-            mantissa /= 10.0;
-            exponent++;
-        }
-        while (mantissa < 1.0 && mantissa > 0.0) {
-            mantissa *= 10.0;
-            exponent--;
+void lu_solver_set_block_size(lu_solver* solver, int block_size, int* error_code) {
+    if (!is_block_size_supported(solver, block_size)) {
+        *error_code = CL_INVALID_WORK_GROUP_SIZE;
+        return;
+    }
+    int use_fp64 = solver->precision == PRECISION_FP64;
+    if (solver->program != NULL && solver->block_size == block_size && solver->program_fp64 == use_fp64 && solver->program_layout == (int)solver->layout) {
+        *error_code = 0;
+        return;
+    }
+
+    char build_options[192];
+    snprintf(build_options, sizeof(build_options), "-D BLOCK_SIZE=%d -D PANEL_GROUP_SIZE=%d -D TRSM_GROUP_SIZE=%d -D TRAIL_GROUP_SIZE=%d -D MATRIX_LAYOUT=%d%s", block_size, solver->panel_group_size, solver->trsm_group_size, solver->trail_group_size, (int)solver->layout, use_fp64 ? " -D USE_FP64" : "");
+
+    int build_error;
+    int from_cache = 0;
+    double start_build = wall_clock_seconds();
+    cl_program program = build_program_cached(solver->context, solver->device_id, solver->kernel_source, build_options, KERNEL_CACHE_DIR, &from_cache, &build_error);
+    float time_build = (float)(wall_clock_seconds() - start_build);
+    if (program == NULL) {
+        *error_code = build_error;
+        return;
+    }
+
+    static const char* kernel_names[LU_KERNEL_COUNT] = {
+        "lu_factorize_panel", "lu_apply_row_swaps", "lu_solve_upper_panel", "lu_update_trailing_matrix", "diagonal_determinant",
+        "lu_apply_pivot_sequence", "lu_residual", "lu_convert_to_layout", "lu_convert_from_layout", "lu_fill_padding"
+    };
+    cl_kernel kernels[LU_KERNEL_COUNT];
+    for (int i = 0; i < LU_KERNEL_COUNT; i++) {
+        cl_int err;
+        kernels[i] = clCreateKernel(program, kernel_names[i], &err);
+        if (err != CL_SUCCESS) {
+            for (int j = 0; j < i; j++) clReleaseKernel(kernels[j]);
+            clReleaseProgram(program);
+            *error_code = err;
+            return;
         }
     }
 
-    *out_mantissa = mantissa;
-    *out_exponent = exponent;
-    *out_sign = sign;
+    if (solver->kernel_fact != NULL) clReleaseKernel(solver->kernel_fact);
+    if (solver->kernel_swap != NULL) clReleaseKernel(solver->kernel_swap);
+    if (solver->kernel_upper != NULL) clReleaseKernel(solver->kernel_upper);
+    if (solver->kernel_trail != NULL) clReleaseKernel(solver->kernel_trail);
+    if (solver->kernel_determinant != NULL) clReleaseKernel(solver->kernel_determinant);
+    if (solver->kernel_pivot_sequence != NULL) clReleaseKernel(solver->kernel_pivot_sequence);
+    if (solver->kernel_residual != NULL) clReleaseKernel(solver->kernel_residual);
+    if (solver->kernel_to_layout != NULL) clReleaseKernel(solver->kernel_to_layout);
+    if (solver->kernel_from_layout != NULL) clReleaseKernel(solver->kernel_from_layout);
+    if (solver->kernel_fill_padding != NULL) clReleaseKernel(solver->kernel_fill_padding);
+    if (solver->program != NULL) clReleaseProgram(solver->program);
+
+    solver->program = program;
+    solver->program_fp64 = use_fp64;
+    solver->program_layout = (int)solver->layout;
+    solver->program_from_cache = from_cache;
+    solver->time_build = time_build;
+    solver->block_size = block_size;
+
+    solver->kernel_fact = kernels[0];
+    solver->kernel_swap = kernels[1];
+    solver->kernel_upper = kernels[2];
+    solver->kernel_trail = kernels[3];
+    solver->kernel_determinant = kernels[4];
+    solver->kernel_pivot_sequence = kernels[5];
+    solver->kernel_residual = kernels[6];
+    solver->kernel_to_layout = kernels[7];
+    solver->kernel_from_layout = kernels[8];
+    solver->kernel_fill_padding = kernels[9];
+
+    *error_code = 0;
+}
+
+const char* precision_mode_name(precision_mode precision) {
+    switch (precision) {
+        case PRECISION_MIXED: return "mixed";
+        case PRECISION_FP64: return "fp64";
+        default: return "fp32";
+    }
+}
+
+void lu_solver_set_precision(lu_solver* solver, precision_mode precision, int* error_code) {
+    if (precision == PRECISION_FP64 && !solver->supports_fp64) {
+        *error_code = CL_INVALID_DEVICE;
+        return;
+    }
+
+    precision_mode previous_precision = solver->precision;
+    solver->precision = precision;
+
+    int block_size = solver->block_size;
+    while (block_size > 1 && !is_block_size_supported(solver, block_size)) {
+        block_size /= 2;
+    }
+
+    lu_solver_set_block_size(solver, block_size, error_code);
+    if (*error_code != 0) {
+        solver->precision = previous_precision;
+    }
 }
 
-void calculate_determinant_gauss_opencl(float* matrix, int size, float* out_mantissa, long long* out_exponent, int* out_sign, float* out_time_write, float* out_time_calc, float* out_time_read) {
+void lu_solver_set_refinement_probes(lu_solver* solver, int probe_count, int* error_code) {
+    if (probe_count < 0) {
+        *error_code = CL_INVALID_VALUE;
+        return;
+    }
+
+    solver->refinement_probes = probe_count;
+    *error_code = 0;
+}
+
+const char* device_layout_name(device_layout layout) {
+    switch (layout) {
+        case DEVICE_LAYOUT_COLUMN_MAJOR: return "column-major";
+        case DEVICE_LAYOUT_TILED: return "tiled";
+        default: return "row-major";
+    }
+}
+
+void lu_solver_set_layout(lu_solver* solver, device_layout layout, int* error_code) {
+    device_layout previous_layout = solver->layout;
+    solver->layout = layout;
+
+    lu_solver_set_block_size(solver, solver->block_size, error_code);
+    if (*error_code != 0) {
+        solver->layout = previous_layout;
+    }
+}
+
+static int round_up(int value, int multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+int device_padded_size(const lu_solver* solver, int size) {
+    return round_up(size, solver->block_size);
+}
+
+static int device_storage_size(const lu_solver* solver, int size) {
+    int trail_tile = solver->trail_group_size * 4;
+    int overhang = trail_tile > solver->trsm_group_size ? trail_tile : solver->trsm_group_size;
+    return round_up(device_padded_size(solver, size) + overhang, solver->block_size);
+}
+
+static int row_major_leading_dimension(const lu_solver* solver, int size) {
+    int leading_dimension = round_up(device_storage_size(solver, size), LEADING_DIMENSION_ALIGN);
+    if (leading_dimension % LEADING_DIMENSION_CONFLICT_STRIDE == 0) {
+        leading_dimension += LEADING_DIMENSION_ALIGN;
+    }
+    return leading_dimension;
+}
+
+int device_leading_dimension(const lu_solver* solver, int size) {
+    if (solver->layout == DEVICE_LAYOUT_TILED) {
+        return device_storage_size(solver, size);
+    }
+    return row_major_leading_dimension(solver, size);
+}
+
+static size_t device_matrix_elements(const lu_solver* solver, int size) {
+    size_t leading_dimension = device_leading_dimension(solver, size);
+    if (solver->layout == DEVICE_LAYOUT_TILED) {
+        return leading_dimension * leading_dimension;
+    }
+    return leading_dimension * device_storage_size(solver, size);
+}
+
+lu_solver* lu_solver_create(int* error_code) {
     cl_int err;
     cl_platform_id platform_id;
     cl_device_id device_id;
@@ -101,122 +275,832 @@ void calculate_determinant_gauss_opencl(float* matrix, int size, float* out_mant
     clGetPlatformIDs(1, &platform_id, &n_platforms);
     err = clGetDeviceIDs(platform_id, CL_DEVICE_TYPE_GPU, 1, &device_id, &n_devices);
     if (err != CL_SUCCESS) err = clGetDeviceIDs(platform_id, CL_DEVICE_TYPE_CPU, 1, &device_id, &n_devices);
+    if (err != CL_SUCCESS) {
+        *error_code = err;
+        return NULL;
+    }
+
+    return lu_solver_create_for_device(device_id, error_code);
+}
+
+lu_solver* lu_solver_create_for_device(cl_device_id device_id, int* error_code) {
+    cl_int err;
 
-    cl_context context = clCreateContext(NULL, 1, &device_id, NULL, NULL, &err);
+    lu_solver* solver = (lu_solver*)calloc(1, sizeof(lu_solver));
+    if (solver == NULL) {
+        *error_code = -1;
+        return NULL;
+    }
+    solver->device_id = device_id;
+
+    solver->context = clCreateContext(NULL, 1, &solver->device_id, NULL, NULL, &err);
     
     cl_queue_properties props[] = {CL_QUEUE_PROPERTIES, CL_QUEUE_PROFILING_ENABLE, 0};
-    cl_command_queue queue = clCreateCommandQueueWithProperties(context, device_id, props, &err);
+    solver->queue = clCreateCommandQueueWithProperties(solver->context, solver->device_id, props, &err);
+    solver->transfer_queue = clCreateCommandQueueWithProperties(solver->context, solver->device_id, props, &err);
+    solver->pipelined_upload = 1;
+    solver->refinement_probes = REFINEMENT_PROBE_COUNT;
 
-    int error_code;
-    char* kernel_code = load_kernel_source("kernel/sample.cl", &error_code);
-    if (error_code != 0) kernel_code = load_kernel_source("sample.cl", &error_code);
+    int load_error;
+    solver->kernel_source = load_kernel_source(KERNEL_SOURCE_PATH, &load_error);
+    if (load_error != 0) solver->kernel_source = load_kernel_source("sample.cl", &load_error);
+    if (load_error != 0) {
+        lu_solver_release(solver);
+        *error_code = load_error;
+        return NULL;
+    }
 
-    cl_program program = clCreateProgramWithSource(context, 1, (const char**)&kernel_code, NULL, &err);
-    free(kernel_code);
-    clBuildProgram(program, 1, &device_id, NULL, NULL, NULL);
+    clGetDeviceInfo(solver->device_id, CL_DEVICE_NAME, sizeof(solver->device_name), solver->device_name, NULL);
+    clGetDeviceInfo(solver->device_id, CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(solver->max_work_group_size), &solver->max_work_group_size, NULL);
+    clGetDeviceInfo(solver->device_id, CL_DEVICE_LOCAL_MEM_SIZE, sizeof(solver->local_mem_size), &solver->local_mem_size, NULL);
 
-    cl_kernel kernel_fact = clCreateKernel(program, "lu_factorize_block", &err);
-    cl_kernel kernel_panel = clCreateKernel(program, "lu_update_panels", &err);
-    cl_kernel kernel_trail = clCreateKernel(program, "lu_update_trailing_matrix", &err);
+    char extensions[4096] = "";
+    clGetDeviceInfo(solver->device_id, CL_DEVICE_EXTENSIONS, sizeof(extensions), extensions, NULL);
+    solver->supports_fp64 = strstr(extensions, "cl_khr_fp64") != NULL;
 
-    cl_event write_event, read_event;
-    
-    cl_mem gpu_matrix = clCreateBuffer(context, CL_MEM_READ_WRITE, size * size * sizeof(float), NULL, &err);
-    clEnqueueWriteBuffer(queue, gpu_matrix, CL_FALSE, 0, size * size * sizeof(float), matrix, 0, NULL, &write_event);
+    cl_bool host_unified_memory = CL_FALSE;
+    cl_device_type device_type = 0;
+    clGetDeviceInfo(solver->device_id, CL_DEVICE_HOST_UNIFIED_MEMORY, sizeof(host_unified_memory), &host_unified_memory, NULL);
+    clGetDeviceInfo(solver->device_id, CL_DEVICE_TYPE, sizeof(device_type), &device_type, NULL);
+    solver->host_unified_memory = host_unified_memory == CL_TRUE || (device_type & CL_DEVICE_TYPE_CPU) != 0;
+    solver->transfer_mode = "pageable";
+
+    solver->panel_group_size = PANEL_GROUP_SIZE;
+    while (solver->panel_group_size > 1 && (size_t)solver->panel_group_size > solver->max_work_group_size) {
+        solver->panel_group_size /= 2;
+    }
+
+    solver->trail_group_size = TRAIL_GROUP_SIZE;
+    while (solver->trail_group_size > 1 && (size_t)(solver->trail_group_size * solver->trail_group_size) > solver->max_work_group_size) {
+        solver->trail_group_size /= 2;
+    }
+
+    solver->trsm_group_size = TRSM_GROUP_SIZE;
+    while (solver->trsm_group_size > 1 && (size_t)(solver->trsm_group_size * solver->trsm_group_size) > solver->max_work_group_size) {
+        solver->trsm_group_size /= 2;
+    }
+
+    int initial_sign = 1;
+    solver->gpu_sign = clCreateBuffer(solver->context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, sizeof(int), &initial_sign, &err);
+    solver->gpu_result_mantissa = clCreateBuffer(solver->context, CL_MEM_READ_WRITE, sizeof(cl_double), NULL, &err);
+    solver->gpu_result_exponent = clCreateBuffer(solver->context, CL_MEM_READ_WRITE, sizeof(int), NULL, &err);
+
+    int block_size = read_tuned_block_size(BLOCK_SIZE_TUNING_FILE, solver->device_name);
+    if (!is_block_size_supported(solver, block_size)) {
+        block_size = BLOCK_SIZE;
+        while (block_size > 1 && !is_block_size_supported(solver, block_size)) {
+            block_size /= 2;
+        }
+    }
+
+    int build_error;
+    lu_solver_set_block_size(solver, block_size, &build_error);
+    if (build_error != 0) {
+        lu_solver_release(solver);
+        *error_code = build_error;
+        return NULL;
+    }
+
+    *error_code = 0;
+    return solver;
+}
+
+static cl_int reserve_buffer(cl_context context, cl_mem* buffer, size_t* capacity, size_t required) {
+    if (required <= *capacity && *buffer != NULL) return CL_SUCCESS;
+
+    if (*buffer != NULL) {
+        clReleaseMemObject(*buffer);
+        *buffer = NULL;
+        *capacity = 0;
+    }
+
+    cl_int err;
+    *buffer = clCreateBuffer(context, CL_MEM_READ_WRITE, required, NULL, &err);
+    if (err == CL_SUCCESS) *capacity = required;
+    return err;
+}
+
+static cl_int reserve_solver_buffers(lu_solver* solver, int size) {
+    size_t element_size = device_element_size(solver);
+    size_t matrix_bytes = (size_t)size * size * element_size;
+    int padded_size = device_padded_size(solver, size);
+    size_t padded_bytes = (size_t)padded_size * padded_size * element_size;
+    size_t storage_bytes = device_matrix_elements(solver, size) * element_size;
+
+    cl_int err = reserve_buffer(solver->context, &solver->gpu_matrix, &solver->gpu_matrix_capacity, storage_bytes);
+    if (err != CL_SUCCESS) return err;
+
+    if (solver->layout != DEVICE_LAYOUT_ROW_MAJOR) {
+        err = reserve_buffer(solver->context, &solver->gpu_upload, &solver->gpu_upload_capacity, matrix_bytes);
+        if (err != CL_SUCCESS) return err;
+    }
+
+    err = reserve_buffer(solver->context, &solver->gpu_pivots, &solver->gpu_pivots_capacity, (size_t)padded_size * sizeof(int));
+    if (err != CL_SUCCESS) return err;
+
+    if (solver->precision == PRECISION_MIXED) {
+        err = reserve_buffer(solver->context, &solver->gpu_original, &solver->gpu_original_capacity, storage_bytes);
+        if (err != CL_SUCCESS) return err;
+
+        err = reserve_buffer(solver->context, &solver->gpu_residual, &solver->gpu_residual_capacity, padded_bytes);
+        if (err != CL_SUCCESS) return err;
+    }
+
+    if (solver->precision == PRECISION_FP64 || solver->precision == PRECISION_MIXED) {
+        size_t staging_bytes = solver->precision == PRECISION_FP64 ? matrix_bytes : 2 * matrix_bytes;
+        if (staging_bytes > solver->host_staging_capacity) {
+            void* staging = realloc(solver->host_staging, staging_bytes);
+            if (staging == NULL) return CL_OUT_OF_HOST_MEMORY;
+            solver->host_staging = staging;
+            solver->host_staging_capacity = staging_bytes;
+        }
+    }
+
+    return CL_SUCCESS;
+}
+
+float sum_event_times(cl_event* events, int count) {
+    return record_event_times(NULL, events, count, NULL, NULL, 0.0);
+}
+
+static void* aligned_host_alloc(size_t bytes) {
+#ifdef _WIN32
+    return _aligned_malloc(bytes, MATRIX_ALIGNMENT);
+#else
+    return aligned_alloc(MATRIX_ALIGNMENT, bytes);
+#endif
+}
+
+static void aligned_host_free(void* pointer) {
+#ifdef _WIN32
+    _aligned_free(pointer);
+#else
+    free(pointer);
+#endif
+}
+
+float* matrix_alloc(lu_solver* solver, int size, int* error_code) {
+    if (solver == NULL) {
+        size_t bytes = (size_t)size * size * sizeof(float);
+        float* matrix = (float*)aligned_host_alloc((bytes + MATRIX_ALIGNMENT - 1) / MATRIX_ALIGNMENT * MATRIX_ALIGNMENT);
+        *error_code = matrix == NULL ? -1 : 0;
+        return matrix;
+    }
+
+    int leading_dimension = row_major_leading_dimension(solver, size);
+    size_t bytes = (size_t)leading_dimension * device_storage_size(solver, size) * sizeof(float);
+    bytes = (bytes + MATRIX_ALIGNMENT - 1) / MATRIX_ALIGNMENT * MATRIX_ALIGNMENT;
+
+    matrix_allocation* allocations = (matrix_allocation*)realloc(solver->allocations, (solver->allocation_count + 1) * sizeof(matrix_allocation));
+    if (allocations == NULL) {
+        *error_code = -1;
+        return NULL;
+    }
+    solver->allocations = allocations;
+
+    cl_int err;
+    matrix_allocation allocation = {NULL, NULL, NULL, bytes, size, leading_dimension};
+
+    if (solver->host_unified_memory) {
+        allocation.storage = aligned_host_alloc(bytes);
+        if (allocation.storage == NULL) {
+            *error_code = -1;
+            return NULL;
+        }
+        allocation.buffer = clCreateBuffer(solver->context, CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR, bytes, allocation.storage, &err);
+    } else {
+        allocation.buffer = clCreateBuffer(solver->context, CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR, bytes, NULL, &err);
+    }
+
+    if (err == CL_SUCCESS) {
+        allocation.host = (float*)clEnqueueMapBuffer(solver->queue, allocation.buffer, CL_TRUE, CL_MAP_READ | CL_MAP_WRITE, 0, bytes, 0, NULL, NULL, &err);
+    }
+
+    if (err != CL_SUCCESS) {
+        if (allocation.buffer != NULL) clReleaseMemObject(allocation.buffer);
+        aligned_host_free(allocation.storage);
+        *error_code = err;
+        return NULL;
+    }
+
+    solver->allocations[solver->allocation_count++] = allocation;
+    *error_code = 0;
+    return allocation.host;
+}
+
+static void release_matrix_allocation(lu_solver* solver, matrix_allocation* allocation) {
+    clEnqueueUnmapMemObject(solver->queue, allocation->buffer, allocation->host, 0, NULL, NULL);
+    clFinish(solver->queue);
+    clReleaseMemObject(allocation->buffer);
+    aligned_host_free(allocation->storage);
+}
+
+void matrix_free(lu_solver* solver, float* matrix) {
+    if (matrix == NULL) return;
+
+    if (solver != NULL) {
+        for (int i = 0; i < solver->allocation_count; i++) {
+            if (solver->allocations[i].host == matrix) {
+                release_matrix_allocation(solver, &solver->allocations[i]);
+                solver->allocations[i] = solver->allocations[--solver->allocation_count];
+                return;
+            }
+        }
+    }
+
+    aligned_host_free(matrix);
+}
+
+static matrix_allocation* find_matrix_allocation(const lu_solver* solver, const float* matrix, int size) {
+    for (int i = 0; i < solver->allocation_count; i++) {
+        if (solver->allocations[i].host == matrix && solver->allocations[i].size >= size) {
+            return &solver->allocations[i];
+        }
+    }
+    return NULL;
+}
+
+int matrix_leading_dimension(const lu_solver* solver, const float* matrix, int size) {
+    matrix_allocation* allocation = solver != NULL ? find_matrix_allocation(solver, matrix, size) : NULL;
+    return allocation != NULL ? allocation->leading_dimension : size;
+}
+
+void matrix_copy(const lu_solver* solver, float* matrix, const float* source, int size) {
+    int leading_dimension = matrix_leading_dimension(solver, matrix, size);
+    for (int row = 0; row < size; row++) {
+        memcpy(matrix + (size_t)row * leading_dimension, source + (size_t)row * size, (size_t)size * sizeof(float));
+    }
+}
+
+static int greatest_common_divisor(int a, int b) {
+    while (b != 0) {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+static int plan_upload_chunks(const lu_solver* solver, int size, int* columns) {
+    int count = 0;
+    columns[count++] = 0;
+
+    if (!solver->pipelined_upload || size <= solver->block_size) {
+        columns[count] = size;
+        return count;
+    }
+
+    columns[count++] = solver->block_size;
+
+    int trail_tile = solver->trail_group_size * 4;
+    int align = trail_tile / greatest_common_divisor(trail_tile, solver->trsm_group_size) * solver->trsm_group_size;
+    int remaining = size - solver->block_size;
+    int width = (remaining + UPLOAD_CHUNK_COUNT - 1) / UPLOAD_CHUNK_COUNT;
+    width = (width + align - 1) / align * align;
+
+    for (int col = solver->block_size + width; col < size; col += width) {
+        columns[count++] = col;
+    }
+    columns[count] = size;
+    return count;
+}
+
+static void bind_factorization_args(lu_solver* solver, cl_mem gpu_matrix, int size, int leading_dimension) {
+    clSetKernelArg(solver->kernel_fact, 0, sizeof(cl_mem), &gpu_matrix);
+    clSetKernelArg(solver->kernel_fact, 2, sizeof(int), &size);
+    clSetKernelArg(solver->kernel_fact, 3, sizeof(int), &leading_dimension);
+    clSetKernelArg(solver->kernel_fact, 4, sizeof(cl_mem), &solver->gpu_pivots);
+    clSetKernelArg(solver->kernel_fact, 5, sizeof(cl_mem), &solver->gpu_sign);
+
+    clSetKernelArg(solver->kernel_swap, 0, sizeof(cl_mem), &gpu_matrix);
+    clSetKernelArg(solver->kernel_swap, 2, sizeof(int), &leading_dimension);
+    clSetKernelArg(solver->kernel_swap, 3, sizeof(cl_mem), &solver->gpu_pivots);
+
+    clSetKernelArg(solver->kernel_upper, 0, sizeof(cl_mem), &gpu_matrix);
+    clSetKernelArg(solver->kernel_upper, 2, sizeof(int), &leading_dimension);
+
+    clSetKernelArg(solver->kernel_trail, 0, sizeof(cl_mem), &gpu_matrix);
+    clSetKernelArg(solver->kernel_trail, 2, sizeof(int), &leading_dimension);
+}
+
+static void enqueue_layout_conversion(lu_solver* solver, cl_kernel kernel, cl_mem source, cl_mem target, int size, int leading_dimension, int host_pitch, cl_event* event) {
+    size_t groups = (size + solver->trsm_group_size - 1) / solver->trsm_group_size;
+    size_t local_size[2] = {solver->trsm_group_size, solver->trsm_group_size};
+    size_t global_size[2] = {groups * solver->trsm_group_size, groups * solver->trsm_group_size};
+
+    clSetKernelArg(kernel, 0, sizeof(cl_mem), &source);
+    clSetKernelArg(kernel, 1, sizeof(cl_mem), &target);
+    clSetKernelArg(kernel, 2, sizeof(int), &size);
+    clSetKernelArg(kernel, 3, sizeof(int), &leading_dimension);
+    clSetKernelArg(kernel, 4, sizeof(int), &host_pitch);
+    clEnqueueNDRangeKernel(solver->queue, kernel, 2, NULL, global_size, local_size, 0, NULL, event);
+}
+
+static void enqueue_padding_fill(lu_solver* solver, cl_mem matrix, int size, int leading_dimension, cl_event* event) {
+    size_t global_size[2] = {device_storage_size(solver, size), device_storage_size(solver, size) - size};
+
+    clSetKernelArg(solver->kernel_fill_padding, 0, sizeof(cl_mem), &matrix);
+    clSetKernelArg(solver->kernel_fill_padding, 1, sizeof(int), &size);
+    clSetKernelArg(solver->kernel_fill_padding, 2, sizeof(int), &leading_dimension);
+    clEnqueueNDRangeKernel(solver->queue, solver->kernel_fill_padding, 2, NULL, global_size, NULL, 0, NULL, event);
+}
+
+static void bind_block_offset(lu_solver* solver, int block_offset) {
+    clSetKernelArg(solver->kernel_fact, 1, sizeof(int), &block_offset);
+    clSetKernelArg(solver->kernel_swap, 1, sizeof(int), &block_offset);
+    clSetKernelArg(solver->kernel_upper, 1, sizeof(int), &block_offset);
+    clSetKernelArg(solver->kernel_trail, 1, sizeof(int), &block_offset);
+}
+
+static void enqueue_trailing_step(lu_solver* solver, int block_offset, int size, int column_begin, int column_end, cl_uint wait_count, const cl_event* wait_events, cl_event* swap_event, cl_event* upper_event, cl_event* trail_event) {
+    cl_command_queue queue = solver->queue;
+    int remaining = size - block_offset - solver->block_size;
+    int width = column_end - column_begin;
+    int trail_tile = solver->trail_group_size * 4;
+
+    size_t offset_swap = column_begin;
+    size_t global_swap = width;
+    clEnqueueNDRangeKernel(queue, solver->kernel_swap, 1, &offset_swap, &global_swap, NULL, wait_count, wait_events, swap_event);
+
+    size_t upper_groups = (width + solver->trsm_group_size - 1) / solver->trsm_group_size;
+    size_t offset_upper[2] = {column_begin, 0};
+    size_t local_upper[2] = {solver->trsm_group_size, solver->trsm_group_size};
+    size_t global_upper[2] = {upper_groups * solver->trsm_group_size, solver->trsm_group_size};
+    clEnqueueNDRangeKernel(queue, solver->kernel_upper, 2, offset_upper, global_upper, local_upper, 0, NULL, upper_event);
+
+    size_t trail_groups_x = (width + trail_tile - 1) / trail_tile;
+    size_t trail_groups_y = (remaining + trail_tile - 1) / trail_tile;
+    size_t offset_trail[2] = {(size_t)(column_begin / trail_tile) * solver->trail_group_size, 0};
+    size_t local_trail[2] = {solver->trail_group_size, solver->trail_group_size};
+    size_t global_trail[2] = {trail_groups_x * solver->trail_group_size, trail_groups_y * solver->trail_group_size};
+    clEnqueueNDRangeKernel(queue, solver->kernel_trail, 2, offset_trail, global_trail, local_trail, 0, NULL, trail_event);
+}
+
+void lu_solver_calculate_determinant(lu_solver* solver, float* matrix, int size, float* out_mantissa, long long* out_exponent, int* out_sign, float* out_time_write, float* out_time_calc, float* out_time_read, int* error_code) {
+    cl_command_queue queue = solver->queue;
+    cl_kernel kernel_fact = solver->kernel_fact;
+
+    cl_int reserve_error = reserve_solver_buffers(solver, size);
+    if (reserve_error != CL_SUCCESS) {
+        *out_mantissa = 0.0;
+        *out_exponent = 0;
+        *out_sign = 1;
+        *error_code = reserve_error;
+        return;
+    }
+    cl_mem gpu_matrix = solver->gpu_matrix;
+    cl_mem gpu_sign = solver->gpu_sign;
+    cl_mem gpu_pivots = solver->gpu_pivots;
+
+    size_t element_size = device_element_size(solver);
+    size_t matrix_bytes = (size_t)size * size * element_size;
+    int padded_size = device_padded_size(solver, size);
+    int leading_dimension = device_leading_dimension(solver, size);
+    size_t storage_bytes = device_matrix_elements(solver, size) * element_size;
+    size_t packed_pitch = (size_t)size * element_size;
+    size_t device_pitch = (size_t)leading_dimension * element_size;
+    int use_fp64 = solver->precision == PRECISION_FP64;
+    int use_refinement = solver->precision == PRECISION_MIXED;
+    int converted = solver->layout != DEVICE_LAYOUT_ROW_MAJOR;
+    solver->padded_size = padded_size;
+    solver->leading_dimension = leading_dimension;
+
+    matrix_allocation* host_allocation = find_matrix_allocation(solver, matrix, size);
+    int host_leading_dimension = host_allocation != NULL ? host_allocation->leading_dimension : size;
+    size_t host_pitch = use_fp64 ? packed_pitch : (size_t)host_leading_dimension * element_size;
+
+    matrix_allocation* allocation = use_fp64 ? NULL : host_allocation;
+    int zero_copy = allocation != NULL && solver->host_unified_memory;
+    int in_place = zero_copy && !converted && allocation->leading_dimension == leading_dimension && allocation->bytes >= storage_bytes;
+    int mapped = zero_copy && (converted || in_place);
+    if (allocation == NULL) {
+        solver->transfer_mode = "pageable";
+    } else if (!zero_copy) {
+        solver->transfer_mode = "pinned";
+    } else {
+        solver->transfer_mode = mapped ? "zero-copy" : "device-copy";
+    }
+
+    cl_event unmap_event;
+    if (zero_copy) {
+        clEnqueueUnmapMemObject(queue, allocation->buffer, allocation->host, 0, NULL, &unmap_event);
+    }
+    if (in_place) {
+        gpu_matrix = allocation->buffer;
+    }
+
+    const void* upload_source = matrix;
+    if (use_fp64) {
+        double* staging = (double*)solver->host_staging;
+        for (int row = 0; row < size; row++) {
+            for (int col = 0; col < size; col++) {
+                staging[(size_t)row * size + col] = matrix[(size_t)row * host_leading_dimension + col];
+            }
+        }
+        upload_source = staging;
+    }
+
+    cl_event write_events[UPLOAD_CHUNK_COUNT + 1];
+    cl_event copy_events[UPLOAD_CHUNK_COUNT + 1];
+    cl_event layout_events[2];
+    cl_event padding_events[2];
+    int padding_count = 0;
+    cl_event* ready_events = use_refinement ? copy_events : (converted ? layout_events : write_events);
+    cl_mem layout_buffer = zero_copy ? allocation->buffer : solver->gpu_upload;
+    int layout_pitch = zero_copy ? host_leading_dimension : size;
+    int upload_columns[UPLOAD_CHUNK_COUNT + 2];
+    int upload_count = zero_copy || converted ? 1 : plan_upload_chunks(solver, padded_size, upload_columns);
+    size_t origin[3] = {0, 0, 0};
+    size_t region[3] = {packed_pitch, size, 1};
+
+    if (mapped) {
+        clEnqueueMarkerWithWaitList(queue, 0, NULL, &write_events[0]);
+    } else if (converted) {
+        clEnqueueWriteBufferRect(queue, solver->gpu_upload, CL_FALSE, origin, origin, region, packed_pitch, 0, host_pitch, 0, upload_source, 0, NULL, &write_events[0]);
+    } else if (zero_copy) {
+        clEnqueueCopyBufferRect(queue, allocation->buffer, gpu_matrix, origin, origin, region, host_pitch, 0, device_pitch, 0, 0, NULL, &write_events[0]);
+    } else if (upload_count == 1) {
+        clEnqueueWriteBufferRect(queue, gpu_matrix, CL_FALSE, origin, origin, region, device_pitch, 0, host_pitch, 0, upload_source, 0, NULL, &write_events[0]);
+    } else {
+        for (int chunk = 0; chunk < upload_count; chunk++) {
+            int column_end = upload_columns[chunk + 1] < size ? upload_columns[chunk + 1] : size;
+            if (upload_columns[chunk] >= column_end) {
+                clEnqueueMarkerWithWaitList(solver->transfer_queue, 0, NULL, &write_events[chunk]);
+                if (use_refinement) {
+                    clEnqueueMarkerWithWaitList(solver->transfer_queue, 0, NULL, &copy_events[chunk]);
+                }
+                continue;
+            }
+
+            size_t chunk_origin[3] = {(size_t)upload_columns[chunk] * element_size, 0, 0};
+            size_t chunk_region[3] = {(size_t)(column_end - upload_columns[chunk]) * element_size, size, 1};
+            clEnqueueWriteBufferRect(solver->transfer_queue, gpu_matrix, CL_FALSE, chunk_origin, chunk_origin, chunk_region, device_pitch, 0, host_pitch, 0, upload_source, 0, NULL, &write_events[chunk]);
+            if (use_refinement) {
+                clEnqueueCopyBufferRect(solver->transfer_queue, gpu_matrix, solver->gpu_original, chunk_origin, chunk_origin, chunk_region, device_pitch, 0, device_pitch, 0, 0, NULL, &copy_events[chunk]);
+            }
+        }
+        clFlush(solver->transfer_queue);
+    }
+
+    if (converted) {
+        enqueue_layout_conversion(solver, solver->kernel_to_layout, layout_buffer, gpu_matrix, size, leading_dimension, layout_pitch, &layout_events[0]);
+    }
+    enqueue_padding_fill(solver, gpu_matrix, size, leading_dimension, &padding_events[padding_count++]);
+    if (use_refinement && upload_count == 1) {
+        clEnqueueCopyBuffer(queue, gpu_matrix, solver->gpu_original, 0, 0, storage_bytes, 0, NULL, &copy_events[0]);
+    } else if (use_refinement) {
+        enqueue_padding_fill(solver, solver->gpu_original, size, leading_dimension, &padding_events[padding_count++]);
+    }
+
+    int initial_sign = 1;
+    cl_event sign_event;
+    clEnqueueWriteBuffer(queue, gpu_sign, CL_FALSE, 0, sizeof(int), &initial_sign, 0, NULL, &sign_event);
     
     cl_event calc_start_event, calc_end_event;
-    clEnqueueMarkerWithWaitList(queue, 0, NULL, &calc_start_event);
-
-    for (int k = 0; k < size; k += BLOCK_SIZE) {
-        
-        clSetKernelArg(kernel_fact, 0, sizeof(cl_mem), &gpu_matrix);
-        clSetKernelArg(kernel_fact, 1, sizeof(int), &k);
-        clSetKernelArg(kernel_fact, 2, sizeof(int), &size);
-        
-        size_t local_fact[2] = {BLOCK_SIZE, BLOCK_SIZE};
-        size_t global_fact[2] = {BLOCK_SIZE, BLOCK_SIZE};
-        clEnqueueNDRangeKernel(queue, kernel_fact, 2, NULL, global_fact, local_fact, 0, NULL, NULL);
-
-        int remaining = size - k - BLOCK_SIZE;
-        if (remaining > 0) {
-            clSetKernelArg(kernel_panel, 0, sizeof(cl_mem), &gpu_matrix);
-            clSetKernelArg(kernel_panel, 1, sizeof(int), &k);
-            clSetKernelArg(kernel_panel, 2, sizeof(int), &size);
-            
-            size_t global_panel = remaining;
-            clEnqueueNDRangeKernel(queue, kernel_panel, 1, NULL, &global_panel, NULL, 0, NULL, NULL);
-
-            clSetKernelArg(kernel_trail, 0, sizeof(cl_mem), &gpu_matrix);
-            clSetKernelArg(kernel_trail, 1, sizeof(int), &k);
-            clSetKernelArg(kernel_trail, 2, sizeof(int), &size);
-            
-            size_t global_trail[2] = {remaining, remaining};
-            clEnqueueNDRangeKernel(queue, kernel_trail, 2, NULL, global_trail, NULL, 0, NULL, NULL);
+    clEnqueueMarkerWithWaitList(queue, 1, &ready_events[0], &calc_start_event);
+
+    cl_event refinement_events[5];
+    int refinement_count = 0;
+
+    int block_size = solver->block_size;
+    int step_count = padded_size / block_size;
+    int trail_count = 0;
+    double trailing_flops = 0.0;
+    cl_event* fact_events = (cl_event*)malloc(step_count * sizeof(cl_event));
+    cl_event* swap_events = (cl_event*)malloc((step_count + upload_count) * sizeof(cl_event));
+    cl_event* upper_events = (cl_event*)malloc((step_count + upload_count) * sizeof(cl_event));
+    cl_event* trail_events = (cl_event*)malloc((step_count + upload_count) * sizeof(cl_event));
+
+    double start_enqueue = wall_clock_seconds();
+    bind_factorization_args(solver, gpu_matrix, padded_size, leading_dimension);
+    for (int k = 0; k < padded_size; k += block_size) {
+        bind_block_offset(solver, k);
+
+        size_t local_fact = solver->panel_group_size;
+        size_t global_fact = solver->panel_group_size;
+        clEnqueueNDRangeKernel(queue, kernel_fact, 1, NULL, &global_fact, &local_fact, 0, NULL, &fact_events[k / block_size]);
+
+        int remaining = padded_size - k - block_size;
+        if (remaining > 0 && k == 0 && upload_count > 1) {
+            for (int chunk = 1; chunk < upload_count; chunk++) {
+                enqueue_trailing_step(solver, k, padded_size, upload_columns[chunk] - block_size, upload_columns[chunk + 1] - block_size, 1, &ready_events[chunk], &swap_events[trail_count], &upper_events[trail_count], &trail_events[trail_count]);
+                trail_count++;
+            }
+            trailing_flops += 2.0 * remaining * remaining * block_size;
+        } else if (remaining > 0) {
+            enqueue_trailing_step(solver, k, padded_size, 0, remaining, 0, NULL, &swap_events[trail_count], &upper_events[trail_count], &trail_events[trail_count]);
+            trail_count++;
+            trailing_flops += 2.0 * remaining * remaining * block_size;
         }
     }
+    solver->time_host_enqueue = (float)(wall_clock_seconds() - start_enqueue);
+    
+    if (use_refinement) {
+        size_t global_columns = padded_size;
+        size_t global_elements[2] = {padded_size, padded_size};
+        int skip_factored_panel = 1;
+
+        clSetKernelArg(solver->kernel_pivot_sequence, 0, sizeof(cl_mem), &gpu_matrix);
+        clSetKernelArg(solver->kernel_pivot_sequence, 1, sizeof(int), &padded_size);
+        clSetKernelArg(solver->kernel_pivot_sequence, 2, sizeof(int), &leading_dimension);
+        clSetKernelArg(solver->kernel_pivot_sequence, 3, sizeof(cl_mem), &gpu_pivots);
+        clSetKernelArg(solver->kernel_pivot_sequence, 4, sizeof(int), &skip_factored_panel);
+        clEnqueueNDRangeKernel(queue, solver->kernel_pivot_sequence, 1, NULL, &global_columns, NULL, 0, NULL, &refinement_events[refinement_count++]);
+
+        skip_factored_panel = 0;
+        clSetKernelArg(solver->kernel_pivot_sequence, 0, sizeof(cl_mem), &solver->gpu_original);
+        clSetKernelArg(solver->kernel_pivot_sequence, 4, sizeof(int), &skip_factored_panel);
+        clEnqueueNDRangeKernel(queue, solver->kernel_pivot_sequence, 1, NULL, &global_columns, NULL, 0, NULL, &refinement_events[refinement_count++]);
+
+        clSetKernelArg(solver->kernel_residual, 0, sizeof(cl_mem), &solver->gpu_original);
+        clSetKernelArg(solver->kernel_residual, 1, sizeof(cl_mem), &gpu_matrix);
+        clSetKernelArg(solver->kernel_residual, 2, sizeof(cl_mem), &solver->gpu_residual);
+        clSetKernelArg(solver->kernel_residual, 3, sizeof(int), &padded_size);
+        clSetKernelArg(solver->kernel_residual, 4, sizeof(int), &leading_dimension);
+        clEnqueueNDRangeKernel(queue, solver->kernel_residual, 2, NULL, global_elements, NULL, 0, NULL, &refinement_events[refinement_count++]);
+    }
+
+    cl_kernel kernel_determinant = solver->kernel_determinant;
+    cl_event reduction_event;
+    size_t reduction_size = solver->panel_group_size;
+    clSetKernelArg(kernel_determinant, 0, sizeof(cl_mem), &gpu_matrix);
+    clSetKernelArg(kernel_determinant, 1, sizeof(int), &padded_size);
+    clSetKernelArg(kernel_determinant, 2, sizeof(int), &leading_dimension);
+    clSetKernelArg(kernel_determinant, 3, sizeof(cl_mem), &gpu_sign);
+    clSetKernelArg(kernel_determinant, 4, sizeof(cl_mem), &solver->gpu_result_mantissa);
+    clSetKernelArg(kernel_determinant, 5, sizeof(cl_mem), &solver->gpu_result_exponent);
+    clEnqueueNDRangeKernel(queue, kernel_determinant, 1, NULL, &reduction_size, &reduction_size, 0, NULL, &reduction_event);
     
     clEnqueueMarkerWithWaitList(queue, 0, NULL, &calc_end_event);
-    clFinish(queue);
 
-    clEnqueueReadBuffer(queue, gpu_matrix, CL_TRUE, 0, size * size * sizeof(float), matrix, 0, NULL, &read_event);
+    cl_event matrix_read_event;
+    cl_mem factor_buffer = solver->read_back_matrix ? layout_buffer : solver->gpu_upload;
+    size_t factor_pitch = (size_t)(solver->read_back_matrix ? layout_pitch : size) * element_size;
+    int convert_back = converted && (solver->read_back_matrix || use_refinement);
+    if (convert_back) {
+        enqueue_layout_conversion(solver, solver->kernel_from_layout, gpu_matrix, factor_buffer, size, leading_dimension, (int)(factor_pitch / element_size), &layout_events[1]);
+    }
+    if (solver->read_back_matrix && mapped) {
+        clEnqueueMarkerWithWaitList(queue, 0, NULL, &matrix_read_event);
+    } else if (solver->read_back_matrix && converted) {
+        clEnqueueReadBufferRect(queue, solver->gpu_upload, CL_FALSE, origin, origin, region, packed_pitch, 0, host_pitch, 0, use_fp64 ? solver->host_staging : (void*)matrix, 0, NULL, &matrix_read_event);
+    } else if (solver->read_back_matrix && zero_copy) {
+        clEnqueueCopyBufferRect(queue, gpu_matrix, allocation->buffer, origin, origin, region, device_pitch, 0, host_pitch, 0, 0, NULL, &matrix_read_event);
+    } else if (solver->read_back_matrix) {
+        clEnqueueReadBufferRect(queue, gpu_matrix, CL_FALSE, origin, origin, region, device_pitch, 0, host_pitch, 0, use_fp64 ? solver->host_staging : (void*)matrix, 0, NULL, &matrix_read_event);
+    }
+    float* host_factors = (float*)solver->host_staging;
+    float* host_residual = host_factors + (size_t)size * size;
+    if (use_refinement) {
+        if (converted) {
+            clEnqueueReadBufferRect(queue, factor_buffer, CL_FALSE, origin, origin, region, factor_pitch, 0, packed_pitch, 0, host_factors, 0, NULL, &refinement_events[refinement_count++]);
+        } else {
+            clEnqueueReadBufferRect(queue, gpu_matrix, CL_FALSE, origin, origin, region, device_pitch, 0, packed_pitch, 0, host_factors, 0, NULL, &refinement_events[refinement_count++]);
+        }
+        clEnqueueReadBufferRect(queue, solver->gpu_residual, CL_FALSE, origin, origin, region, (size_t)padded_size * element_size, 0, packed_pitch, 0, host_residual, 0, NULL, &refinement_events[refinement_count++]);
+    }
+
+    float mantissa_fp32 = 0.0f;
+    double mantissa_fp64 = 0.0;
+    int device_exponent = 0;
+    int final_gpu_sign = 1;
+    cl_event result_events[3];
+    clEnqueueReadBuffer(queue, solver->gpu_result_mantissa, CL_FALSE, 0, element_size, use_fp64 ? (void*)&mantissa_fp64 : (void*)&mantissa_fp32, 0, NULL, &result_events[0]);
+    clEnqueueReadBuffer(queue, solver->gpu_result_exponent, CL_FALSE, 0, sizeof(int), &device_exponent, 0, NULL, &result_events[1]);
+    clEnqueueReadBuffer(queue, gpu_sign, CL_TRUE, 0, sizeof(int), &final_gpu_sign, 0, NULL, &result_events[2]);
+
+    cl_event map_event;
+    if (zero_copy) {
+        cl_int map_error;
+        clEnqueueMapBuffer(queue, allocation->buffer, CL_TRUE, CL_MAP_READ | CL_MAP_WRITE, 0, allocation->bytes, 0, NULL, &map_event, &map_error);
+    }
+
+    if (solver->read_back_matrix && use_fp64) {
+        const double* staging = (const double*)solver->host_staging;
+        for (int row = 0; row < size; row++) {
+            for (int col = 0; col < size; col++) {
+                matrix[(size_t)row * host_leading_dimension + col] = (float)staging[(size_t)row * size + col];
+            }
+        }
+    }
 
     cl_ulong time_start, time_end;
     
-    clGetEventProfilingInfo(write_event, CL_PROFILING_COMMAND_START, sizeof(time_start), &time_start, NULL);
-    clGetEventProfilingInfo(write_event, CL_PROFILING_COMMAND_END, sizeof(time_end), &time_end, NULL);
-    float time_write_sec = (float)(time_end - time_start) / 1.0e9;
+    cl_ulong upload_start = 0;
+    for (int chunk = 0; chunk < upload_count; chunk++) {
+        clGetEventProfilingInfo(write_events[chunk], CL_PROFILING_COMMAND_START, sizeof(time_start), &time_start, NULL);
+        if (chunk == 0 || time_start < upload_start) {
+            upload_start = time_start;
+        }
+    }
+    profiler* profiler = solver->profiler;
+    float time_write_sec = record_event_times(profiler, write_events, upload_count, mapped ? "map_matrix" : (zero_copy ? "copy_matrix" : "write_matrix"), "upload", mapped ? 0.0 : (double)matrix_bytes);
 
-    clGetEventProfilingInfo(read_event, CL_PROFILING_COMMAND_START, sizeof(time_start), &time_start, NULL);
-    clGetEventProfilingInfo(read_event, CL_PROFILING_COMMAND_END, sizeof(time_end), &time_end, NULL);
-    float time_read_sec = (float)(time_end - time_start) / 1.0e9;
+    time_write_sec += record_event_times(profiler, &sign_event, 1, "write_sign", "upload", (double)sizeof(int));
+    if (zero_copy) {
+        time_write_sec += record_event_times(profiler, &unmap_event, 1, "unmap_host_matrix", "upload", 0.0);
+    }
+
+    float time_read_sec = record_event_times(profiler, result_events, 3, "read_determinant", "download", (double)(element_size + 2 * sizeof(int)));
+    if (zero_copy) {
+        time_read_sec += record_event_times(profiler, &map_event, 1, "map_host_matrix", "download", 0.0);
+    }
+
+    if (solver->read_back_matrix) {
+        time_read_sec += record_event_times(profiler, &matrix_read_event, 1, "read_matrix", "download", mapped ? 0.0 : (double)matrix_bytes);
+    }
+
+    solver->time_layout = record_event_times(profiler, padding_events, padding_count, "lu_fill_padding", "layout", 0.0);
+    if (converted) {
+        solver->time_layout += record_event_times(profiler, &layout_events[0], 1, "lu_convert_to_layout", "layout", 0.0);
+        if (convert_back) {
+            solver->time_layout += record_event_times(profiler, &layout_events[1], 1, "lu_convert_from_layout", "layout", 0.0);
+        }
+    }
 
     clGetEventProfilingInfo(calc_start_event, CL_PROFILING_COMMAND_END, sizeof(time_start), &time_start, NULL);
     clGetEventProfilingInfo(calc_end_event, CL_PROFILING_COMMAND_START, sizeof(time_end), &time_end, NULL);
     float gpu_calc = (float)(time_end - time_start) / 1.0e9;
+    solver->time_overlapped_total = (float)(time_end - upload_start) / 1.0e9;
+
+    solver->time_reduction = record_event_times(profiler, &reduction_event, 1, "diagonal_determinant", "reduction", 0.0);
+    solver->time_refinement = 0.0f;
+    if (use_refinement) {
+        solver->time_refinement += record_event_times(profiler, &refinement_events[0], 2, "lu_apply_pivot_sequence", "refinement", 0.0);
+        solver->time_refinement += record_event_times(profiler, &refinement_events[2], 1, "lu_residual", "refinement", 0.0);
+        solver->time_refinement += record_event_times(profiler, &refinement_events[3], 1, "read_factors", "refinement", (double)matrix_bytes);
+        solver->time_refinement += record_event_times(profiler, &refinement_events[4], 1, "read_residual", "refinement", (double)matrix_bytes);
+        solver->time_refinement += record_event_times(profiler, copy_events, upload_count, "copy_original", "refinement", (double)storage_bytes);
+    }
+    solver->time_panel = record_event_times(profiler, fact_events, step_count, "lu_factorize_panel", "panel", 0.0);
+    solver->time_swap = record_event_times(profiler, swap_events, trail_count, "lu_apply_row_swaps", "swap", 0.0);
+    solver->time_upper = record_event_times(profiler, upper_events, trail_count, "lu_solve_upper_panel", "upper", 0.0);
+    float time_trailing = record_event_times(profiler, trail_events, trail_count, "lu_update_trailing_matrix", "trailing", 0.0);
+    free(fact_events);
+    free(swap_events);
+    free(upper_events);
+    free(trail_events);
+
+    solver->time_trailing = time_trailing;
+    solver->trailing_flops = trailing_flops;
+    solver->time_serialized_total = time_write_sec + solver->time_panel + solver->time_swap + solver->time_upper + time_trailing + solver->time_reduction + solver->time_refinement + solver->time_layout;
+
+    clReleaseEvent(calc_start_event);
+    clReleaseEvent(calc_end_event);
 
     if (out_time_write != NULL) *out_time_write = time_write_sec;
     if (out_time_calc != NULL) *out_time_calc = gpu_calc;
     if (out_time_read != NULL) *out_time_read = time_read_sec;
 
-    float mantissa = 1.0;
-    long long exponent = 0;
-    int sign = 1;
+    double binary_mantissa = use_fp64 ? mantissa_fp64 : mantissa_fp32;
+    long long binary_exponent = device_exponent;
 
-    for (int i = 0; i < size; i++) {
-        float val = matrix[i * size + i];
+    if (use_refinement && binary_mantissa != 0.0) {
+        double start_correction = wall_clock_seconds();
+        double standard_error;
+        double trace = lu_correction_trace(host_factors, size, host_residual, size, size, solver->refinement_probes, 0, &standard_error);
+        solver->refinement_trace = trace;
+        solver->refinement_standard_error = standard_error;
 
-        if (fabs(val) < 1e-12) {
-            mantissa = 0.0;
-            exponent = 0; 
-            break;
+        scaled_product product;
+        scaled_product_init(&product);
+        scaled_product_multiply_diagonal(&product, host_factors, size);
+        if (fabs(trace) > REFINEMENT_SIGNIFICANCE * standard_error) {
+            scaled_product_multiply(&product, exp(trace));
         }
+        solver->time_refinement += (float)(wall_clock_seconds() - start_correction);
 
-        if (val < 0) {
-            sign = -sign;
-            val = -val;
+        binary_mantissa = product.is_zero ? 0.0 : product.mantissa;
+        binary_exponent = product.exponent;
+    }
+
+    solver->log10_determinant = binary_mantissa != 0.0 ? log10(binary_mantissa) + (double)binary_exponent * log10(2.0) : -INFINITY;
+
+    binary_to_decimal(binary_mantissa, binary_exponent, out_mantissa, out_exponent);
+    *out_sign = binary_mantissa != 0.0 ? final_gpu_sign : 1;
+    *error_code = 0;
+}
+
+int lu_solver_autotune(lu_solver* solver, int size, int* error_code) {
+    static const int candidates[] = {8, 16, 32, 64, 128};
+    int candidate_count = (int)(sizeof(candidates) / sizeof(candidates[0]));
+
+    float* source = malloc((size_t)size * size * sizeof(float));
+    float* work = malloc((size_t)size * size * sizeof(float));
+    if (source == NULL || work == NULL) {
+        free(source);
+        free(work);
+        *error_code = -1;
+        return solver->block_size;
+    }
+
+    generate_matrix(source, size);
+
+    int original_block_size = solver->block_size;
+    int best_block_size = 0;
+    float best_time = 0.0f;
+
+    for (int i = 0; i < candidate_count; i++) {
+        int build_error;
+        lu_solver_set_block_size(solver, candidates[i], &build_error);
+        if (build_error != 0) {
+            printf("Block size %3d: not supported by device\n", candidates[i]);
+            continue;
         }
 
-        mantissa *= val;
+        float mantissa;
+        long long exponent;
+        int sign;
+        float time_calc = 0.0f;
+        float candidate_time = 0.0f;
+        int run_error = 0;
 
-        while (mantissa >= 10.0) {
-            mantissa /= 10.0;
-            exponent++;
+        for (int run = 0; run < AUTOTUNE_RUNS && run_error == 0; run++) {
+            memcpy(work, source, (size_t)size * size * sizeof(float));
+            lu_solver_calculate_determinant(solver, work, size, &mantissa, &exponent, &sign, NULL, &time_calc, NULL, &run_error);
+            if (run == 0 || time_calc < candidate_time) {
+                candidate_time = time_calc;
+            }
         }
-        while (mantissa < 1.0 && mantissa > 0.0) {
-            mantissa *= 10.0;
-            exponent--;
+        if (run_error != 0) {
+            printf("Block size %3d: failed (error %d)\n", candidates[i], run_error);
+            continue;
+        }
+
+        printf("Block size %3d: %.6f s\n", candidates[i], candidate_time);
+
+        if (best_block_size == 0 || candidate_time < best_time) {
+            best_block_size = candidates[i];
+            best_time = candidate_time;
         }
     }
 
-    *out_mantissa = mantissa;
-    *out_exponent = exponent;
-    *out_sign = sign;
+    free(source);
+    free(work);
+
+    if (best_block_size == 0) {
+        lu_solver_set_block_size(solver, original_block_size, error_code);
+        if (*error_code == 0) *error_code = CL_INVALID_WORK_GROUP_SIZE;
+        return solver->block_size;
+    }
+
+    lu_solver_set_block_size(solver, best_block_size, error_code);
+    if (*error_code == 0) {
+        write_tuned_block_size(BLOCK_SIZE_TUNING_FILE, solver->device_name, size, best_block_size, best_time);
+    }
+    return solver->block_size;
+}
+
+void lu_solver_release(lu_solver* solver) {
+    if (solver == NULL) return;
+
+    for (int i = 0; i < solver->allocation_count; i++) {
+        release_matrix_allocation(solver, &solver->allocations[i]);
+    }
+    free(solver->allocations);
+
+    if (solver->gpu_matrix != NULL) clReleaseMemObject(solver->gpu_matrix);
+    if (solver->gpu_upload != NULL) clReleaseMemObject(solver->gpu_upload);
+    if (solver->gpu_sign != NULL) clReleaseMemObject(solver->gpu_sign);
+    if (solver->gpu_result_mantissa != NULL) clReleaseMemObject(solver->gpu_result_mantissa);
+    if (solver->gpu_result_exponent != NULL) clReleaseMemObject(solver->gpu_result_exponent);
+    if (solver->gpu_pivots != NULL) clReleaseMemObject(solver->gpu_pivots);
+    if (solver->gpu_original != NULL) clReleaseMemObject(solver->gpu_original);
+    if (solver->gpu_residual != NULL) clReleaseMemObject(solver->gpu_residual);
+    if (solver->kernel_fact != NULL) clReleaseKernel(solver->kernel_fact);
+    if (solver->kernel_swap != NULL) clReleaseKernel(solver->kernel_swap);
+    if (solver->kernel_upper != NULL) clReleaseKernel(solver->kernel_upper);
+    if (solver->kernel_trail != NULL) clReleaseKernel(solver->kernel_trail);
+    if (solver->kernel_determinant != NULL) clReleaseKernel(solver->kernel_determinant);
+    if (solver->kernel_pivot_sequence != NULL) clReleaseKernel(solver->kernel_pivot_sequence);
+    if (solver->kernel_residual != NULL) clReleaseKernel(solver->kernel_residual);
+    if (solver->kernel_to_layout != NULL) clReleaseKernel(solver->kernel_to_layout);
+    if (solver->kernel_from_layout != NULL) clReleaseKernel(solver->kernel_from_layout);
+    if (solver->kernel_fill_padding != NULL) clReleaseKernel(solver->kernel_fill_padding);
+    if (solver->program != NULL) clReleaseProgram(solver->program);
+    if (solver->queue != NULL) clReleaseCommandQueue(solver->queue);
+    if (solver->transfer_queue != NULL) clReleaseCommandQueue(solver->transfer_queue);
+    if (solver->context != NULL) clReleaseContext(solver->context);
+    free(solver->kernel_source);
+    free(solver->host_staging);
+    free(solver);
+}
+
+void calculate_determinant_lu_opencl(float* matrix, int size, float* out_mantissa, long long* out_exponent, int* out_sign, float* out_time_write, float* out_time_calc, float* out_time_read) {
+    int error_code;
+    lu_solver* solver = lu_solver_create(&error_code);
+    if (solver == NULL) {
+        printf("Failed to initialize OpenCL solver (error %d)\n", error_code);
+        *out_mantissa = 0.0;
+        *out_exponent = 0;
+        *out_sign = 1;
+        return;
+    }
+
+    lu_solver_calculate_determinant(solver, matrix, size, out_mantissa, out_exponent, out_sign, out_time_write, out_time_calc, out_time_read, &error_code);
+    if (error_code != 0) {
+        printf("Failed to allocate device buffers (error %d)\n", error_code);
+    }
 
-    clReleaseMemObject(gpu_matrix);
-    clReleaseKernel(kernel_fact);
-    clReleaseKernel(kernel_panel);
-    clReleaseKernel(kernel_trail);
-    clReleaseProgram(program);
-    clReleaseCommandQueue(queue);
-    clReleaseContext(context);
+    lu_solver_release(solver);
 }
@@ -0,0 +1,431 @@
+#define CL_TARGET_OPENCL_VERSION 220
+
+#include "multi_device.h"
+#include "out_of_core.h"
+#include "cpu_solver.h"
+#include "scaled_product.h"
+
+#include <CL/cl.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MULTI_DEVICE_MAX_PLATFORMS 8
+
+typedef struct {
+    cl_mem local;
+    cl_mem panel;
+    cl_mem pivots;
+    cl_mem panel_pivots;
+    cl_kernel kernel_factor;
+    cl_kernel kernel_solve;
+    cl_kernel kernel_update;
+    cl_kernel kernel_swap;
+    int pitch;
+    int used_columns;
+    int seen_blocks;
+    cl_event* transfer_events;
+    int transfer_count;
+    cl_event* compute_events;
+    int compute_count;
+} device_slice;
+
+static void add_device(multi_device_solver* solver, cl_device_id device_id, int* last_error) {
+    if (solver->device_count >= MULTI_DEVICE_MAX_DEVICES) {
+        return;
+    }
+
+    int error_code = 0;
+    lu_solver* device_solver = lu_solver_create_for_device(device_id, &error_code);
+    if (device_solver == NULL) {
+        char device_name[256] = "unknown device";
+        clGetDeviceInfo(device_id, CL_DEVICE_NAME, sizeof(device_name), device_name, NULL);
+        printf("Skipping %s: solver initialization failed (error %d)\n", device_name, error_code);
+        *last_error = error_code;
+        return;
+    }
+
+    solver->solvers[solver->device_count] = device_solver;
+    solver->throughput[solver->device_count] = 1.0;
+    solver->device_count++;
+}
+
+static void enqueue_trailing_update(multi_device_solver* solver, device_slice* slice, int d, long long size, cl_long diagonal_row, int columns, int column_begin, int trailing_columns, cl_mem lower, int lower_col, int lower_pitch) {
+    lu_solver* device_solver = solver->solvers[d];
+
+    enqueue_solve_block(device_solver, slice->kernel_solve, slice->local, diagonal_row, column_begin, trailing_columns, lower, diagonal_row, lower_col, slice->pitch, lower_pitch, columns, 0, NULL, &slice->compute_events[slice->compute_count++]);
+
+    long long rows = size - diagonal_row - columns;
+    if (rows > 0) {
+        enqueue_update_block(device_solver, slice->kernel_update, slice->local, diagonal_row + columns, column_begin, rows, trailing_columns, lower, diagonal_row + columns, lower_col, diagonal_row, slice->pitch, lower_pitch, columns, &slice->compute_events[slice->compute_count++]);
+        solver->flops[d] += 2.0 * rows * trailing_columns * columns;
+    }
+    clFlush(device_solver->queue);
+}
+
+multi_device_solver* create_multi_device_solver(int cpu_partitions, int* error_code) {
+    multi_device_solver* solver = (multi_device_solver*)calloc(1, sizeof(multi_device_solver));
+    if (solver == NULL) {
+        *error_code = -1;
+        return NULL;
+    }
+
+    cl_platform_id platforms[MULTI_DEVICE_MAX_PLATFORMS];
+    cl_uint platform_count = 0;
+    clGetPlatformIDs(MULTI_DEVICE_MAX_PLATFORMS, platforms, &platform_count);
+    if (platform_count > MULTI_DEVICE_MAX_PLATFORMS) {
+        platform_count = MULTI_DEVICE_MAX_PLATFORMS;
+    }
+
+    int last_error = CL_DEVICE_NOT_FOUND;
+    for (cl_uint platform = 0; platform < platform_count; platform++) {
+        cl_device_id devices[MULTI_DEVICE_MAX_DEVICES];
+        cl_uint device_count = 0;
+        if (clGetDeviceIDs(platforms[platform], CL_DEVICE_TYPE_ALL, MULTI_DEVICE_MAX_DEVICES, devices, &device_count) != CL_SUCCESS) {
+            continue;
+        }
+        if (device_count > MULTI_DEVICE_MAX_DEVICES) {
+            device_count = MULTI_DEVICE_MAX_DEVICES;
+        }
+
+        for (cl_uint i = 0; i < device_count; i++) {
+            cl_device_type device_type = 0;
+            cl_uint compute_units = 0;
+            clGetDeviceInfo(devices[i], CL_DEVICE_TYPE, sizeof(device_type), &device_type, NULL);
+            clGetDeviceInfo(devices[i], CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(compute_units), &compute_units, NULL);
+
+            cl_uint sub_device_count = 0;
+            if (cpu_partitions > 1 && (device_type & CL_DEVICE_TYPE_CPU) && compute_units >= (cl_uint)cpu_partitions) {
+                cl_device_partition_property properties[] = {CL_DEVICE_PARTITION_EQUALLY, (cl_device_partition_property)(compute_units / cpu_partitions), 0};
+                cl_uint available = MULTI_DEVICE_MAX_DEVICES - solver->sub_device_count;
+                if (clCreateSubDevices(devices[i], properties, available, &solver->sub_devices[solver->sub_device_count], &sub_device_count) != CL_SUCCESS) {
+                    sub_device_count = 0;
+                }
+            }
+
+            if (sub_device_count == 0) {
+                add_device(solver, devices[i], &last_error);
+                continue;
+            }
+
+            int first = solver->sub_device_count;
+            solver->sub_device_count += sub_device_count;
+            for (cl_uint sub = 0; sub < sub_device_count; sub++) {
+                add_device(solver, solver->sub_devices[first + sub], &last_error);
+            }
+        }
+    }
+
+    if (solver->device_count == 0) {
+        *error_code = last_error;
+        release_multi_device_solver(solver);
+        return NULL;
+    }
+    *error_code = 0;
+
+    solver->block_width = solver->solvers[0]->block_size;
+
+    calibrate_multi_device_solver(solver, error_code);
+    if (*error_code != 0) {
+        release_multi_device_solver(solver);
+        return NULL;
+    }
+
+    return solver;
+}
+
+void calibrate_multi_device_solver(multi_device_solver* solver, int* error_code) {
+    int size = MULTI_DEVICE_CALIBRATION_SIZE;
+    int depth = solver->block_width;
+    float* matrix = (float*)malloc((size_t)size * size * sizeof(float));
+    if (matrix == NULL) {
+        *error_code = CL_OUT_OF_HOST_MEMORY;
+        return;
+    }
+    generate_matrix(matrix, size);
+
+    *error_code = 0;
+    for (int d = 0; d < solver->device_count && *error_code == 0; d++) {
+        lu_solver* device_solver = solver->solvers[d];
+        cl_int err;
+        cl_mem buffer = clCreateBuffer(device_solver->context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, (size_t)size * size * sizeof(float), matrix, &err);
+        cl_kernel kernel_update = clCreateKernel(device_solver->program, "ooc_update_block", &err);
+
+        if (buffer == NULL || kernel_update == NULL) {
+            *error_code = err;
+        } else {
+            float best_time = 0.0f;
+            for (int run = 0; run < MULTI_DEVICE_CALIBRATION_RUNS; run++) {
+                cl_event event;
+                enqueue_update_block(device_solver, kernel_update, buffer, depth, depth, size - depth, size - depth, buffer, depth, 0, 0, size, size, depth, &event);
+                clWaitForEvents(1, &event);
+                float time = sum_event_times(&event, 1);
+                if (run == 0 || time < best_time) {
+                    best_time = time;
+                }
+            }
+
+            double flops = 2.0 * (size - depth) * (size - depth) * depth;
+            solver->throughput[d] = best_time > 0.0f ? flops / best_time : 1.0;
+        }
+
+        if (kernel_update != NULL) clReleaseKernel(kernel_update);
+        if (buffer != NULL) clReleaseMemObject(buffer);
+    }
+
+    free(matrix);
+}
+
+void assign_block_columns(const double* throughput, int device_count, int block_count, int* owners, int* local_indices, int* block_columns) {
+    for (int d = 0; d < device_count; d++) {
+        block_columns[d] = 0;
+    }
+
+    for (int block = 0; block < block_count; block++) {
+        int best = 0;
+        double best_load = 0.0;
+        for (int d = 0; d < device_count; d++) {
+            double weight = throughput[d] > 0.0 ? throughput[d] : 1.0;
+            double load = (block_columns[d] + 1) / weight;
+            if (d == 0 || load < best_load) {
+                best = d;
+                best_load = load;
+            }
+        }
+
+        owners[block] = best;
+        local_indices[block] = block_columns[best]++;
+    }
+}
+
+static void release_device_slice(device_slice* slice) {
+    if (slice->kernel_factor != NULL) clReleaseKernel(slice->kernel_factor);
+    if (slice->kernel_solve != NULL) clReleaseKernel(slice->kernel_solve);
+    if (slice->kernel_update != NULL) clReleaseKernel(slice->kernel_update);
+    if (slice->kernel_swap != NULL) clReleaseKernel(slice->kernel_swap);
+    if (slice->local != NULL) clReleaseMemObject(slice->local);
+    if (slice->panel != NULL) clReleaseMemObject(slice->panel);
+    if (slice->pivots != NULL) clReleaseMemObject(slice->pivots);
+    if (slice->panel_pivots != NULL) clReleaseMemObject(slice->panel_pivots);
+    free(slice->transfer_events);
+    free(slice->compute_events);
+}
+
+static cl_int create_device_slice(lu_solver* device_solver, device_slice* slice, int size, int block_width, int block_count, int owned_blocks) {
+    cl_int err = CL_SUCCESS;
+    slice->pitch = owned_blocks * block_width;
+    slice->transfer_events = (cl_event*)malloc((size_t)(owned_blocks + 2 * block_count) * sizeof(cl_event));
+    slice->compute_events = (cl_event*)malloc((size_t)(4 * block_count) * sizeof(cl_event));
+    if (slice->transfer_events == NULL || slice->compute_events == NULL) {
+        return CL_OUT_OF_HOST_MEMORY;
+    }
+
+    if (owned_blocks == 0) {
+        return CL_SUCCESS;
+    }
+
+    slice->local = clCreateBuffer(device_solver->context, CL_MEM_READ_WRITE, (size_t)size * slice->pitch * sizeof(float), NULL, &err);
+    if (err != CL_SUCCESS) return err;
+    slice->panel = clCreateBuffer(device_solver->context, CL_MEM_READ_ONLY, (size_t)size * block_width * sizeof(float), NULL, &err);
+    if (err != CL_SUCCESS) return err;
+    slice->pivots = clCreateBuffer(device_solver->context, CL_MEM_READ_WRITE, (size_t)slice->pitch * sizeof(cl_long), NULL, &err);
+    if (err != CL_SUCCESS) return err;
+    slice->panel_pivots = clCreateBuffer(device_solver->context, CL_MEM_READ_ONLY, (size_t)block_width * sizeof(cl_long), NULL, &err);
+    if (err != CL_SUCCESS) return err;
+
+    slice->kernel_factor = clCreateKernel(device_solver->program, "ooc_factor_panel", &err);
+    if (err != CL_SUCCESS) return err;
+    slice->kernel_solve = clCreateKernel(device_solver->program, "ooc_solve_block", &err);
+    if (err != CL_SUCCESS) return err;
+    slice->kernel_update = clCreateKernel(device_solver->program, "ooc_update_block", &err);
+    if (err != CL_SUCCESS) return err;
+    slice->kernel_swap = clCreateKernel(device_solver->program, "ooc_apply_row_swaps", &err);
+    return err;
+}
+
+void calculate_determinant_multi_device(multi_device_solver* solver, float* matrix, int size, float* out_mantissa, long long* out_exponent, int* out_sign, int* error_code) {
+    *out_mantissa = 0.0f;
+    *out_exponent = 0;
+    *out_sign = 1;
+
+    int device_count = solver->device_count;
+    for (int d = 0; d < device_count; d++) {
+        if (solver->solvers[d]->program_fp64) {
+            *error_code = CL_INVALID_OPERATION;
+            return;
+        }
+    }
+
+    int block_width = solver->block_width;
+    int block_count = (size + block_width - 1) / block_width;
+    int* owners = (int*)malloc(block_count * sizeof(int));
+    int* local_indices = (int*)malloc(block_count * sizeof(int));
+    float* host_panels = (float*)malloc(2 * (size_t)size * block_width * sizeof(float));
+    cl_long* host_pivots = (cl_long*)malloc(2 * (size_t)block_width * sizeof(cl_long));
+    float* diagonal = (float*)malloc((size_t)size * sizeof(float));
+    device_slice slices[MULTI_DEVICE_MAX_DEVICES];
+    cl_event pending[2][MULTI_DEVICE_MAX_DEVICES];
+    int pending_count[2] = {0, 0};
+    memset(slices, 0, sizeof(slices));
+
+    *error_code = 0;
+    if (owners == NULL || local_indices == NULL || host_panels == NULL || host_pivots == NULL || diagonal == NULL) {
+        *error_code = CL_OUT_OF_HOST_MEMORY;
+    } else {
+        assign_block_columns(solver->throughput, device_count, block_count, owners, local_indices, solver->block_columns);
+        for (int d = 0; d < device_count && *error_code == 0; d++) {
+            *error_code = create_device_slice(solver->solvers[d], &slices[d], size, block_width, block_count, solver->block_columns[d]);
+            solver->flops[d] = 0.0;
+        }
+    }
+
+    double start = wall_clock_seconds();
+    int sign = 1;
+    size_t host_row_pitch = (size_t)size * sizeof(float);
+    size_t panel_row_pitch = (size_t)block_width * sizeof(float);
+
+    if (*error_code == 0) {
+        for (int block = 0; block < block_count; block++) {
+            device_slice* slice = &slices[owners[block]];
+            int columns = size - block * block_width < block_width ? size - block * block_width : block_width;
+            size_t buffer_origin[3] = {(size_t)local_indices[block] * block_width * sizeof(float), 0, 0};
+            size_t host_origin[3] = {(size_t)block * block_width * sizeof(float), 0, 0};
+            size_t region[3] = {(size_t)columns * sizeof(float), (size_t)size, 1};
+            clEnqueueWriteBufferRect(solver->solvers[owners[block]]->queue, slice->local, CL_FALSE, buffer_origin, host_origin, region, (size_t)slice->pitch * sizeof(float), 0, host_row_pitch, 0, matrix, 0, NULL, &slice->transfer_events[slice->transfer_count++]);
+            slice->used_columns += columns;
+        }
+        for (int d = 0; d < device_count; d++) {
+            clFlush(solver->solvers[d]->queue);
+        }
+    }
+
+    for (int block = 0; block < block_count && *error_code == 0; block++) {
+        int owner = owners[block];
+        lu_solver* owner_solver = solver->solvers[owner];
+        device_slice* owner_slice = &slices[owner];
+        cl_long diagonal_row = (cl_long)block * block_width;
+        cl_long row_end = size;
+        int columns = size - (int)diagonal_row < block_width ? size - (int)diagonal_row : block_width;
+        int panel_col = local_indices[block] * block_width;
+        int parity = block % 2;
+        float* host_panel = host_panels + (size_t)parity * size * block_width;
+        cl_long* step_pivots = host_pivots + (size_t)parity * block_width;
+
+        if (pending_count[parity] > 0) {
+            clWaitForEvents(pending_count[parity], pending[parity]);
+            pending_count[parity] = 0;
+        }
+
+        clSetKernelArg(owner_slice->kernel_factor, 0, sizeof(cl_mem), &owner_slice->local);
+        clSetKernelArg(owner_slice->kernel_factor, 1, sizeof(cl_long), &diagonal_row);
+        clSetKernelArg(owner_slice->kernel_factor, 2, sizeof(cl_long), &row_end);
+        clSetKernelArg(owner_slice->kernel_factor, 3, sizeof(int), &panel_col);
+        clSetKernelArg(owner_slice->kernel_factor, 4, sizeof(int), &columns);
+        clSetKernelArg(owner_slice->kernel_factor, 5, sizeof(int), &owner_slice->pitch);
+        clSetKernelArg(owner_slice->kernel_factor, 6, sizeof(cl_mem), &owner_slice->pivots);
+
+        size_t factor_size = owner_solver->panel_group_size;
+        cl_event* factor_event = &owner_slice->compute_events[owner_slice->compute_count++];
+        clEnqueueNDRangeKernel(owner_solver->queue, owner_slice->kernel_factor, 1, NULL, &factor_size, &factor_size, 0, NULL, factor_event);
+        clFlush(owner_solver->queue);
+
+        size_t local_origin[3] = {(size_t)panel_col * sizeof(float), (size_t)diagonal_row, 0};
+        size_t panel_origin[3] = {0, (size_t)diagonal_row, 0};
+        size_t panel_region[3] = {(size_t)columns * sizeof(float), (size_t)(size - diagonal_row), 1};
+        cl_event* panel_reads = &owner_slice->transfer_events[owner_slice->transfer_count];
+        clEnqueueReadBufferRect(owner_solver->transfer_queue, owner_slice->local, CL_FALSE, local_origin, panel_origin, panel_region, (size_t)owner_slice->pitch * sizeof(float), 0, panel_row_pitch, 0, host_panel, 1, factor_event, &owner_slice->transfer_events[owner_slice->transfer_count++]);
+        clEnqueueReadBuffer(owner_solver->transfer_queue, owner_slice->pivots, CL_FALSE, (size_t)panel_col * sizeof(cl_long), (size_t)columns * sizeof(cl_long), step_pivots, 1, factor_event, &owner_slice->transfer_events[owner_slice->transfer_count++]);
+        clFlush(owner_solver->transfer_queue);
+        owner_slice->seen_blocks++;
+
+        int owner_begin = owner_slice->seen_blocks * block_width;
+        if (owner_slice->used_columns > owner_begin) {
+            enqueue_trailing_update(solver, owner_slice, owner, size, diagonal_row, columns, owner_begin, owner_slice->used_columns - owner_begin, owner_slice->local, panel_col, owner_slice->pitch);
+        }
+
+        clWaitForEvents(2, panel_reads);
+        for (int i = 0; i < columns; i++) {
+            diagonal[diagonal_row + i] = host_panel[(size_t)(diagonal_row + i) * block_width + i];
+            if (step_pivots[i] != diagonal_row + i) {
+                sign = -sign;
+            }
+        }
+
+        for (int d = 0; d < device_count; d++) {
+            lu_solver* device_solver = solver->solvers[d];
+            device_slice* slice = &slices[d];
+            int column_begin = slice->seen_blocks * block_width;
+            int trailing_columns = slice->used_columns - column_begin;
+            if (d == owner || trailing_columns <= 0) {
+                continue;
+            }
+
+            clEnqueueWriteBufferRect(device_solver->queue, slice->panel, CL_FALSE, panel_origin, panel_origin, panel_region, panel_row_pitch, 0, panel_row_pitch, 0, host_panel, 0, NULL, &slice->transfer_events[slice->transfer_count++]);
+            clEnqueueWriteBuffer(device_solver->queue, slice->panel_pivots, CL_FALSE, 0, (size_t)columns * sizeof(cl_long), step_pivots, 0, NULL, &slice->transfer_events[slice->transfer_count]);
+            pending[parity][pending_count[parity]++] = slice->transfer_events[slice->transfer_count++];
+
+            cl_long pivot_begin = 0;
+            clSetKernelArg(slice->kernel_swap, 0, sizeof(cl_mem), &slice->local);
+            clSetKernelArg(slice->kernel_swap, 1, sizeof(int), &column_begin);
+            clSetKernelArg(slice->kernel_swap, 2, sizeof(int), &trailing_columns);
+            clSetKernelArg(slice->kernel_swap, 3, sizeof(cl_long), &diagonal_row);
+            clSetKernelArg(slice->kernel_swap, 4, sizeof(int), &columns);
+            clSetKernelArg(slice->kernel_swap, 5, sizeof(int), &slice->pitch);
+            clSetKernelArg(slice->kernel_swap, 6, sizeof(cl_mem), &slice->panel_pivots);
+            clSetKernelArg(slice->kernel_swap, 7, sizeof(cl_long), &pivot_begin);
+
+            size_t swap_size = (size_t)(trailing_columns + device_solver->trsm_group_size - 1) / device_solver->trsm_group_size * device_solver->trsm_group_size;
+            clEnqueueNDRangeKernel(device_solver->queue, slice->kernel_swap, 1, NULL, &swap_size, NULL, 0, NULL, &slice->compute_events[slice->compute_count++]);
+
+            enqueue_trailing_update(solver, slice, d, size, diagonal_row, columns, column_begin, trailing_columns, slice->panel, 0, block_width);
+        }
+    }
+
+    for (int d = 0; d < device_count; d++) {
+        clFinish(solver->solvers[d]->queue);
+    }
+    solver->time_total = (float)(wall_clock_seconds() - start);
+    solver->time_transfer = 0.0f;
+
+    for (int d = 0; d < device_count; d++) {
+        device_slice* slice = &slices[d];
+        float time_transfer = sum_event_times(slice->transfer_events, slice->transfer_count);
+        float time_compute = sum_event_times(slice->compute_events, slice->compute_count);
+
+        solver->time_busy[d] = time_transfer + time_compute;
+        solver->time_transfer += time_transfer;
+        if (*error_code == 0 && solver->flops[d] > 0.0 && time_compute > 0.0f) {
+            solver->throughput[d] = solver->flops[d] / time_compute;
+        }
+        release_device_slice(slice);
+    }
+
+    if (*error_code == 0) {
+        scaled_product product;
+        scaled_product_init(&product);
+        scaled_product_multiply_strided(&product, diagonal, size, 1);
+        scaled_product_to_decimal(&product, out_mantissa, out_exponent, out_sign);
+        if (*out_mantissa != 0.0f) {
+            *out_sign *= sign;
+        }
+    }
+
+    free(owners);
+    free(local_indices);
+    free(host_panels);
+    free(host_pivots);
+    free(diagonal);
+}
+
+void release_multi_device_solver(multi_device_solver* solver) {
+    if (solver == NULL) return;
+
+    for (int d = 0; d < solver->device_count; d++) {
+        lu_solver_release(solver->solvers[d]);
+    }
+    for (int i = 0; i < solver->sub_device_count; i++) {
+        clReleaseDevice(solver->sub_devices[i]);
+    }
+    free(solver);
+}
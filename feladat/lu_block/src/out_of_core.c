@@ -0,0 +1,342 @@
+#define CL_TARGET_OPENCL_VERSION 220
+
+#include "out_of_core.h"
+#include "cpu_solver.h"
+#include "scaled_product.h"
+
+#include <CL/cl.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    cl_mem slabs[2];
+    cl_mem panels[2];
+    cl_mem slab_pivots;
+    cl_mem all_pivots;
+    cl_kernel kernel_factor;
+    cl_kernel kernel_solve;
+    cl_kernel kernel_update;
+    cl_kernel kernel_swap;
+} out_of_core_buffers;
+
+int out_of_core_slab_width(const lu_solver* solver, long long size, size_t device_budget) {
+    if (size <= 0) {
+        return 0;
+    }
+
+    size_t pivot_bytes = (size_t)size * sizeof(cl_long);
+    if (device_budget <= pivot_bytes) {
+        return 0;
+    }
+
+    cl_ulong max_alloc_size = 0;
+    clGetDeviceInfo(solver->device_id, CL_DEVICE_MAX_MEM_ALLOC_SIZE, sizeof(max_alloc_size), &max_alloc_size, NULL);
+
+    size_t column_bytes = (size_t)size * sizeof(float);
+    size_t width = (device_budget - pivot_bytes) / (OUT_OF_CORE_SLAB_BUFFERS * column_bytes + sizeof(cl_long));
+    if (max_alloc_size > 0 && width * column_bytes > max_alloc_size) {
+        width = (size_t)(max_alloc_size / column_bytes);
+    }
+    if (width >= (size_t)size) {
+        return (int)size;
+    }
+
+    width -= width % solver->trsm_group_size;
+    return (int)width;
+}
+
+static cl_int create_out_of_core_buffers(lu_solver* solver, out_of_core_buffers* buffers, long long size, int width) {
+    cl_int err = CL_SUCCESS;
+    size_t slab_bytes = (size_t)size * width * sizeof(float);
+
+    for (int i = 0; i < 2; i++) {
+        buffers->slabs[i] = clCreateBuffer(solver->context, CL_MEM_READ_WRITE, slab_bytes, NULL, &err);
+        if (err != CL_SUCCESS) return err;
+        buffers->panels[i] = clCreateBuffer(solver->context, CL_MEM_READ_ONLY, slab_bytes, NULL, &err);
+        if (err != CL_SUCCESS) return err;
+    }
+    buffers->slab_pivots = clCreateBuffer(solver->context, CL_MEM_READ_WRITE, (size_t)width * sizeof(cl_long), NULL, &err);
+    if (err != CL_SUCCESS) return err;
+    buffers->all_pivots = clCreateBuffer(solver->context, CL_MEM_READ_WRITE, (size_t)size * sizeof(cl_long), NULL, &err);
+    if (err != CL_SUCCESS) return err;
+    buffers->kernel_factor = clCreateKernel(solver->program, "ooc_factor_panel", &err);
+    if (err != CL_SUCCESS) return err;
+    buffers->kernel_solve = clCreateKernel(solver->program, "ooc_solve_block", &err);
+    if (err != CL_SUCCESS) return err;
+    buffers->kernel_update = clCreateKernel(solver->program, "ooc_update_block", &err);
+    if (err != CL_SUCCESS) return err;
+    buffers->kernel_swap = clCreateKernel(solver->program, "ooc_apply_row_swaps", &err);
+    return err;
+}
+
+static void release_out_of_core_buffers(out_of_core_buffers* buffers) {
+    if (buffers->kernel_factor != NULL) clReleaseKernel(buffers->kernel_factor);
+    if (buffers->kernel_solve != NULL) clReleaseKernel(buffers->kernel_solve);
+    if (buffers->kernel_update != NULL) clReleaseKernel(buffers->kernel_update);
+    if (buffers->kernel_swap != NULL) clReleaseKernel(buffers->kernel_swap);
+    if (buffers->slab_pivots != NULL) clReleaseMemObject(buffers->slab_pivots);
+    if (buffers->all_pivots != NULL) clReleaseMemObject(buffers->all_pivots);
+    for (int i = 0; i < 2; i++) {
+        if (buffers->panels[i] != NULL) clReleaseMemObject(buffers->panels[i]);
+        if (buffers->slabs[i] != NULL) clReleaseMemObject(buffers->slabs[i]);
+    }
+}
+
+static void enqueue_row_swaps(lu_solver* solver, cl_kernel kernel, cl_mem target, int columns, long long row_begin, int depth, int pitch, cl_mem pivots, cl_event wait_event, cl_event* event) {
+    int col_begin = 0;
+    cl_long row_begin_arg = row_begin;
+
+    clSetKernelArg(kernel, 0, sizeof(cl_mem), &target);
+    clSetKernelArg(kernel, 1, sizeof(int), &col_begin);
+    clSetKernelArg(kernel, 2, sizeof(int), &columns);
+    clSetKernelArg(kernel, 3, sizeof(cl_long), &row_begin_arg);
+    clSetKernelArg(kernel, 4, sizeof(int), &depth);
+    clSetKernelArg(kernel, 5, sizeof(int), &pitch);
+    clSetKernelArg(kernel, 6, sizeof(cl_mem), &pivots);
+    clSetKernelArg(kernel, 7, sizeof(cl_long), &row_begin_arg);
+
+    size_t global = (size_t)(columns + solver->trsm_group_size - 1) / solver->trsm_group_size * solver->trsm_group_size;
+    clEnqueueNDRangeKernel(solver->queue, kernel, 1, NULL, &global, NULL, 1, &wait_event, event);
+}
+
+void enqueue_solve_block(lu_solver* solver, cl_kernel kernel, cl_mem target, long long target_row, int target_col, int columns, cl_mem lower, long long lower_row, int lower_col, int pitch, int lower_pitch, int depth, cl_uint wait_count, const cl_event* wait_events, cl_event* event) {
+    cl_long target_row_arg = target_row;
+    cl_long lower_row_arg = lower_row;
+
+    clSetKernelArg(kernel, 0, sizeof(cl_mem), &target);
+    clSetKernelArg(kernel, 1, sizeof(cl_long), &target_row_arg);
+    clSetKernelArg(kernel, 2, sizeof(int), &target_col);
+    clSetKernelArg(kernel, 3, sizeof(int), &columns);
+    clSetKernelArg(kernel, 4, sizeof(cl_mem), &lower);
+    clSetKernelArg(kernel, 5, sizeof(cl_long), &lower_row_arg);
+    clSetKernelArg(kernel, 6, sizeof(int), &lower_col);
+    clSetKernelArg(kernel, 7, sizeof(int), &pitch);
+    clSetKernelArg(kernel, 8, sizeof(int), &lower_pitch);
+    clSetKernelArg(kernel, 9, sizeof(int), &depth);
+
+    size_t tile = solver->trsm_group_size;
+    size_t local[2] = {tile, tile};
+    size_t global[2] = {(columns + tile - 1) / tile * tile, tile};
+    clEnqueueNDRangeKernel(solver->queue, kernel, 2, NULL, global, local, wait_count, wait_events, event);
+}
+
+void enqueue_update_block(lu_solver* solver, cl_kernel kernel, cl_mem target, long long target_row, int target_col, long long rows, int columns, cl_mem lower, long long lower_row, int lower_col, long long upper_row, int pitch, int lower_pitch, int depth, cl_event* event) {
+    cl_long target_row_arg = target_row;
+    cl_long rows_arg = rows;
+    cl_long lower_row_arg = lower_row;
+    cl_long upper_row_arg = upper_row;
+
+    clSetKernelArg(kernel, 0, sizeof(cl_mem), &target);
+    clSetKernelArg(kernel, 1, sizeof(cl_long), &target_row_arg);
+    clSetKernelArg(kernel, 2, sizeof(int), &target_col);
+    clSetKernelArg(kernel, 3, sizeof(cl_long), &rows_arg);
+    clSetKernelArg(kernel, 4, sizeof(int), &columns);
+    clSetKernelArg(kernel, 5, sizeof(cl_mem), &lower);
+    clSetKernelArg(kernel, 6, sizeof(cl_long), &lower_row_arg);
+    clSetKernelArg(kernel, 7, sizeof(int), &lower_col);
+    clSetKernelArg(kernel, 8, sizeof(cl_long), &upper_row_arg);
+    clSetKernelArg(kernel, 9, sizeof(int), &pitch);
+    clSetKernelArg(kernel, 10, sizeof(int), &lower_pitch);
+    clSetKernelArg(kernel, 11, sizeof(int), &depth);
+
+    size_t tile = solver->trsm_group_size;
+    size_t local[2] = {tile, tile};
+    size_t global[2] = {(columns + tile - 1) / tile * tile, (size_t)(rows + tile - 1) / tile * tile};
+    clEnqueueNDRangeKernel(solver->queue, kernel, 2, NULL, global, local, 0, NULL, event);
+}
+
+void calculate_determinant_out_of_core(lu_solver* solver, float* matrix, long long size, size_t device_budget, float* out_mantissa, long long* out_exponent, int* out_sign, out_of_core_stats* stats, int* error_code) {
+    *out_mantissa = 0.0f;
+    *out_exponent = 0;
+    *out_sign = 1;
+
+    if (solver->program_fp64) {
+        *error_code = CL_INVALID_OPERATION;
+        return;
+    }
+
+    int width = out_of_core_slab_width(solver, size, device_budget);
+    if (width <= 0) {
+        *error_code = CL_OUT_OF_RESOURCES;
+        return;
+    }
+
+    out_of_core_buffers buffers;
+    memset(&buffers, 0, sizeof(buffers));
+    *error_code = create_out_of_core_buffers(solver, &buffers, size, width);
+
+    long long slab_count = (size + width - 1) / width;
+    int panel_width = solver->block_size;
+    int panel_steps = (width + panel_width - 1) / panel_width;
+    size_t transfer_capacity = (size_t)slab_count + 3;
+    size_t compute_capacity = 3 * (size_t)slab_count + 3 * panel_steps + 1;
+    cl_long* host_pivots = (cl_long*)malloc((size_t)size * sizeof(cl_long));
+    cl_event* transfer_events[2] = {(cl_event*)malloc(2 * transfer_capacity * sizeof(cl_event)), NULL};
+    cl_event* compute_events[2] = {(cl_event*)malloc(2 * compute_capacity * sizeof(cl_event)), NULL};
+    int transfer_count[2] = {0, 0};
+    int compute_count[2] = {0, 0};
+
+    if (*error_code == 0 && (host_pivots == NULL || transfer_events[0] == NULL || compute_events[0] == NULL)) {
+        *error_code = CL_OUT_OF_HOST_MEMORY;
+    }
+    if (*error_code != 0) {
+        slab_count = 0;
+    } else {
+        transfer_events[1] = transfer_events[0] + transfer_capacity;
+        compute_events[1] = compute_events[0] + compute_capacity;
+    }
+
+    out_of_core_stats local_stats;
+    memset(&local_stats, 0, sizeof(local_stats));
+    local_stats.slab_width = width;
+    local_stats.slab_count = slab_count;
+    local_stats.working_set_bytes = OUT_OF_CORE_SLAB_BUFFERS * (size_t)size * width * sizeof(float) + ((size_t)width + size) * sizeof(cl_long);
+
+    size_t host_row_pitch = (size_t)size * sizeof(float);
+    size_t slab_row_pitch = (size_t)width * sizeof(float);
+    size_t buffer_origin[3] = {0, 0, 0};
+    cl_event slab_ready = NULL;
+    cl_event slab_read[2] = {NULL, NULL};
+    double start = wall_clock_seconds();
+
+    for (long long slab_index = 0; slab_index < slab_count; slab_index++) {
+        int current = (int)(slab_index % 2);
+        long long col_begin = slab_index * width;
+        int slab_width = (int)(size - col_begin < width ? size - col_begin : width);
+        cl_mem slab = buffers.slabs[current];
+        cl_event* transfers = transfer_events[current];
+        cl_event* computes = compute_events[current];
+        int transfers_used = 0;
+        int computes_used = 0;
+
+        size_t slab_host_origin[3] = {(size_t)col_begin * sizeof(float), 0, 0};
+        size_t slab_region[3] = {(size_t)slab_width * sizeof(float), (size_t)size, 1};
+        if (slab_index == 0) {
+            clEnqueueWriteBufferRect(solver->transfer_queue, slab, CL_FALSE, buffer_origin, slab_host_origin, slab_region, slab_row_pitch, 0, host_row_pitch, 0, matrix, 0, NULL, &transfers[transfers_used]);
+            slab_ready = transfers[transfers_used++];
+            local_stats.bytes_uploaded += (double)slab_width * size * sizeof(float);
+        }
+
+        cl_event panel_released[2] = {NULL, NULL};
+        for (long long previous = 0; previous < slab_index; previous++) {
+            int buffer = (int)(previous % 2);
+            long long row_begin = previous * width;
+
+            size_t panel_host_origin[3] = {(size_t)row_begin * sizeof(float), (size_t)row_begin, 0};
+            size_t panel_region[3] = {(size_t)width * sizeof(float), (size_t)(size - row_begin), 1};
+            clEnqueueWriteBufferRect(solver->transfer_queue, buffers.panels[buffer], CL_FALSE, buffer_origin, panel_host_origin, panel_region, slab_row_pitch, 0, host_row_pitch, 0, matrix, panel_released[buffer] != NULL ? 1 : 0, &panel_released[buffer], &transfers[transfers_used]);
+            cl_event panel_ready = transfers[transfers_used++];
+            clFlush(solver->transfer_queue);
+            local_stats.bytes_uploaded += (double)width * (size - row_begin) * sizeof(float);
+
+            enqueue_row_swaps(solver, buffers.kernel_swap, slab, slab_width, row_begin, width, width, buffers.all_pivots, slab_ready, &computes[computes_used++]);
+
+            enqueue_solve_block(solver, buffers.kernel_solve, slab, row_begin, 0, slab_width, buffers.panels[buffer], 0, 0, width, width, width, 1, &panel_ready, &computes[computes_used]);
+            panel_released[buffer] = computes[computes_used++];
+
+            long long rows = size - row_begin - width;
+            if (rows > 0) {
+                enqueue_update_block(solver, buffers.kernel_update, slab, row_begin + width, 0, rows, slab_width, buffers.panels[buffer], width, 0, row_begin, width, width, width, &computes[computes_used]);
+                panel_released[buffer] = computes[computes_used++];
+            }
+        }
+        clFlush(solver->queue);
+
+        cl_event next_ready = NULL;
+        if (slab_index + 1 < slab_count) {
+            long long next_begin = col_begin + width;
+            int next_width = (int)(size - next_begin < width ? size - next_begin : width);
+            size_t next_host_origin[3] = {(size_t)next_begin * sizeof(float), 0, 0};
+            size_t next_region[3] = {(size_t)next_width * sizeof(float), (size_t)size, 1};
+            clEnqueueWriteBufferRect(solver->transfer_queue, buffers.slabs[1 - current], CL_FALSE, buffer_origin, next_host_origin, next_region, slab_row_pitch, 0, host_row_pitch, 0, matrix, 0, NULL, &transfers[transfers_used]);
+            next_ready = transfers[transfers_used++];
+            clFlush(solver->transfer_queue);
+            local_stats.bytes_uploaded += (double)next_width * size * sizeof(float);
+        }
+
+        for (int panel_col = 0; panel_col < slab_width; panel_col += panel_width) {
+            int columns = slab_width - panel_col < panel_width ? slab_width - panel_col : panel_width;
+            cl_long diagonal_row = col_begin + panel_col;
+            cl_long row_end = size;
+
+            clSetKernelArg(buffers.kernel_factor, 0, sizeof(cl_mem), &slab);
+            clSetKernelArg(buffers.kernel_factor, 1, sizeof(cl_long), &diagonal_row);
+            clSetKernelArg(buffers.kernel_factor, 2, sizeof(cl_long), &row_end);
+            clSetKernelArg(buffers.kernel_factor, 3, sizeof(int), &panel_col);
+            clSetKernelArg(buffers.kernel_factor, 4, sizeof(int), &columns);
+            clSetKernelArg(buffers.kernel_factor, 5, sizeof(int), &width);
+            clSetKernelArg(buffers.kernel_factor, 6, sizeof(cl_mem), &buffers.slab_pivots);
+
+            size_t factor_size = solver->panel_group_size;
+            clEnqueueNDRangeKernel(solver->queue, buffers.kernel_factor, 1, NULL, &factor_size, &factor_size, panel_col == 0 ? 1 : 0, panel_col == 0 ? &slab_ready : NULL, &computes[computes_used++]);
+
+            int trailing_columns = slab_width - panel_col - columns;
+            if (trailing_columns > 0) {
+                enqueue_solve_block(solver, buffers.kernel_solve, slab, diagonal_row, panel_col + columns, trailing_columns, slab, diagonal_row, panel_col, width, width, columns, 0, NULL, &computes[computes_used++]);
+
+                long long rows = size - diagonal_row - columns;
+                if (rows > 0) {
+                    enqueue_update_block(solver, buffers.kernel_update, slab, diagonal_row + columns, panel_col + columns, rows, trailing_columns, slab, diagonal_row + columns, panel_col, diagonal_row, width, width, columns, &computes[computes_used++]);
+                }
+            }
+        }
+
+        clEnqueueCopyBuffer(solver->queue, buffers.slab_pivots, buffers.all_pivots, 0, (size_t)col_begin * sizeof(cl_long), (size_t)slab_width * sizeof(cl_long), 0, NULL, &computes[computes_used]);
+        cl_event factored = computes[computes_used++];
+        clFlush(solver->queue);
+
+        clEnqueueReadBufferRect(solver->transfer_queue, slab, CL_FALSE, buffer_origin, slab_host_origin, slab_region, slab_row_pitch, 0, host_row_pitch, 0, matrix, 1, &factored, &transfers[transfers_used]);
+        slab_read[current] = transfers[transfers_used++];
+        clFlush(solver->transfer_queue);
+        local_stats.bytes_downloaded += (double)slab_width * size * sizeof(float);
+
+        transfer_count[current] = transfers_used;
+        compute_count[current] = computes_used;
+        slab_ready = next_ready;
+
+        int previous_slab = 1 - current;
+        if (slab_read[previous_slab] != NULL) {
+            clWaitForEvents(1, &slab_read[previous_slab]);
+            local_stats.time_transfer += sum_event_times(transfer_events[previous_slab], transfer_count[previous_slab]);
+            local_stats.time_compute += sum_event_times(compute_events[previous_slab], compute_count[previous_slab]);
+            slab_read[previous_slab] = NULL;
+        }
+    }
+
+    if (slab_count > 0) {
+        int last = (int)((slab_count - 1) % 2);
+        clWaitForEvents(1, &slab_read[last]);
+        local_stats.time_transfer += sum_event_times(transfer_events[last], transfer_count[last]);
+        local_stats.time_compute += sum_event_times(compute_events[last], compute_count[last]);
+        *error_code = clEnqueueReadBuffer(solver->queue, buffers.all_pivots, CL_TRUE, 0, (size_t)size * sizeof(cl_long), host_pivots, 0, NULL, NULL);
+    }
+
+    local_stats.time_total = (float)(wall_clock_seconds() - start);
+
+    if (*error_code == 0) {
+        int sign = 1;
+        for (long long row = 0; row < size; row++) {
+            if (host_pivots[row] != row) {
+                sign = -sign;
+            }
+        }
+
+        scaled_product product;
+        scaled_product_init(&product);
+        scaled_product_multiply_strided(&product, matrix, (int)size, (int)size + 1);
+        scaled_product_to_decimal(&product, out_mantissa, out_exponent, out_sign);
+        if (*out_mantissa != 0.0f) {
+            *out_sign *= sign;
+        }
+    }
+
+    if (stats != NULL) {
+        *stats = local_stats;
+    }
+
+    free(host_pivots);
+    free(transfer_events[0]);
+    free(compute_events[0]);
+    release_out_of_core_buffers(&buffers);
+}
@@ -0,0 +1,219 @@
+#include "refinement.h"
+#include "cpu_solver.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+typedef struct {
+    const float* factors;
+    int factor_pitch;
+    const float* residual;
+    int residual_pitch;
+    int size;
+    int probe_count;
+    int exact;
+    int tile;
+    int thread_count;
+} correction_state;
+
+typedef struct {
+    correction_state* state;
+    int thread_index;
+    double trace;
+    double squares;
+    int failed;
+} correction_worker;
+
+static double rademacher_sign(int row, int probe) {
+    uint64_t value = ((uint64_t)REFINEMENT_PROBE_SEED << 32) ^ ((uint64_t)(uint32_t)probe << 32 | (uint32_t)row);
+    value += 0x9e3779b97f4a7c15ull;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    value ^= value >> 31;
+    return (value & 1) ? 1.0 : -1.0;
+}
+
+static void subtract_rows(double* target, const float* factors, const double* work, int begin, int end, int width, int length) {
+    int k = begin;
+    for (; k + 4 <= end; k += 4) {
+        double f0 = factors[k], f1 = factors[k + 1], f2 = factors[k + 2], f3 = factors[k + 3];
+        const double* s0 = work + (size_t)k * width;
+        const double* s1 = s0 + width;
+        const double* s2 = s1 + width;
+        const double* s3 = s2 + width;
+        for (int j = 0; j < length; j++) {
+            target[j] -= f0 * s0[j] + f1 * s1[j] + f2 * s2[j] + f3 * s3[j];
+        }
+    }
+    for (; k < end; k++) {
+        double factor = factors[k];
+        const double* solved = work + (size_t)k * width;
+        for (int j = 0; j < length; j++) {
+            target[j] -= factor * solved[j];
+        }
+    }
+}
+
+static void fill_probes(const correction_state* state, int probe_begin, int width, double* probes) {
+    for (int row = 0; row < state->size; row++) {
+        double* target = probes + (size_t)row * width;
+        for (int j = 0; j < width; j++) {
+            target[j] = state->exact ? (row == probe_begin + j ? 1.0 : 0.0) : rademacher_sign(row, probe_begin + j);
+        }
+    }
+}
+
+static void multiply_residual(const correction_state* state, int probe_begin, int width, const double* probes, double* work) {
+    int size = state->size;
+
+    for (int row = 0; row < size; row++) {
+        double* target = work + (size_t)row * width;
+        const float* residual = state->residual + (size_t)row * state->residual_pitch;
+
+        if (state->exact) {
+            for (int j = 0; j < width; j++) {
+                target[j] = residual[probe_begin + j];
+            }
+            continue;
+        }
+
+        for (int j = 0; j < width; j++) {
+            target[j] = 0.0;
+        }
+        subtract_rows(target, residual, probes, 0, size, width, width);
+        for (int j = 0; j < width; j++) {
+            target[j] = -target[j];
+        }
+    }
+}
+
+static void solve_lower(const correction_state* state, int width, double* work) {
+    for (int row = 1; row < state->size; row++) {
+        const float* lower = state->factors + (size_t)row * state->factor_pitch;
+        subtract_rows(work + (size_t)row * width, lower, work, 0, row, width, width);
+    }
+}
+
+static void solve_upper_projected(const correction_state* state, int probe_begin, int width, const double* probes, double* work, double* projections) {
+    int size = state->size;
+    int last_row = state->exact ? probe_begin : 0;
+
+    for (int j = 0; j < width; j++) {
+        projections[j] = 0.0;
+    }
+
+    for (int row = size - 1; row >= last_row; row--) {
+        int row_width = state->exact && row - probe_begin + 1 < width ? row - probe_begin + 1 : width;
+        double* target = work + (size_t)row * width;
+        const float* upper = state->factors + (size_t)row * state->factor_pitch;
+        const double* probe = probes + (size_t)row * width;
+
+        subtract_rows(target, upper, work, row + 1, size, width, row_width);
+
+        double diagonal = upper[row];
+        for (int j = 0; j < row_width; j++) {
+            target[j] /= diagonal;
+            projections[j] += probe[j] * target[j];
+        }
+    }
+}
+
+static void* correction_thread(void* argument) {
+    correction_worker* worker = (correction_worker*)argument;
+    correction_state* state = worker->state;
+    int size = state->size;
+
+    double* work = (double*)malloc((size_t)size * state->tile * sizeof(double));
+    double* probes = (double*)malloc((size_t)size * state->tile * sizeof(double));
+    if (work == NULL || probes == NULL) {
+        free(work);
+        free(probes);
+        worker->failed = 1;
+        return NULL;
+    }
+
+    double projections[REFINEMENT_COLUMN_TILE];
+    int tile_count = (state->probe_count + state->tile - 1) / state->tile;
+    for (int tile = worker->thread_index; tile < tile_count; tile += state->thread_count) {
+        int probe_begin = tile * state->tile;
+        int width = state->probe_count - probe_begin < state->tile ? state->probe_count - probe_begin : state->tile;
+
+        fill_probes(state, probe_begin, width, probes);
+        multiply_residual(state, probe_begin, width, probes, work);
+        solve_lower(state, width, work);
+        solve_upper_projected(state, probe_begin, width, probes, work, projections);
+        for (int j = 0; j < width; j++) {
+            worker->trace += projections[j];
+            worker->squares += projections[j] * projections[j];
+        }
+    }
+
+    free(work);
+    free(probes);
+    return NULL;
+}
+
+double lu_correction_trace(const float* factors, int factor_pitch, const float* residual, int residual_pitch, int size, int probe_count, int thread_count, double* out_standard_error) {
+    int exact = probe_count <= 0 || probe_count >= size;
+    if (exact) {
+        probe_count = size;
+    }
+
+    int tile = exact ? REFINEMENT_COLUMN_TILE : REFINEMENT_PROBE_TILE;
+    int tile_count = (probe_count + tile - 1) / tile;
+    if (thread_count <= 0) {
+        thread_count = cpu_thread_count();
+    }
+    if (thread_count > tile_count) {
+        thread_count = tile_count > 0 ? tile_count : 1;
+    }
+
+    correction_state state = {factors, factor_pitch, residual, residual_pitch, size, probe_count, exact, tile, thread_count};
+
+    pthread_t* threads = (pthread_t*)malloc(thread_count * sizeof(pthread_t));
+    correction_worker* workers = (correction_worker*)calloc(thread_count, sizeof(correction_worker));
+    *out_standard_error = 0.0;
+    if (threads == NULL || workers == NULL) {
+        free(threads);
+        free(workers);
+        return 0.0;
+    }
+
+    for (int i = 0; i < thread_count; i++) {
+        workers[i].state = &state;
+        workers[i].thread_index = i;
+        if (i > 0) {
+            pthread_create(&threads[i], NULL, correction_thread, &workers[i]);
+        }
+    }
+    correction_thread(&workers[0]);
+    for (int i = 1; i < thread_count; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    double trace = 0.0;
+    double squares = 0.0;
+    int failed = 0;
+    for (int i = 0; i < thread_count; i++) {
+        failed |= workers[i].failed;
+        trace += workers[i].trace;
+        squares += workers[i].squares;
+    }
+
+    free(threads);
+    free(workers);
+
+    if (failed) {
+        return 0.0;
+    }
+    if (exact) {
+        return trace;
+    }
+
+    double mean = trace / probe_count;
+    double variance = probe_count > 1 ? (squares - probe_count * mean * mean) / (probe_count - 1) : 0.0;
+    *out_standard_error = variance > 0.0 ? sqrt(variance / probe_count) : 0.0;
+    return mean;
+}
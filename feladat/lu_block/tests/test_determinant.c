@@ -7,9 +7,17 @@
 #include <cmocka.h>
 
 #include "matrix.h"
+#include "cpu_solver.h"
+#include "simd_kernels.h"
+#include "scaled_product.h"
+#include "out_of_core.h"
+#include "multi_device.h"
+#include "matrix_file.h"
+#include "refinement.h"
 
 #include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #ifdef _WIN32
@@ -87,6 +95,144 @@ static void test_cpu_determinant_6x6_zero() {
     assert_true(fabs(result - 0.0) < 0.0001);
 }
 
+static void test_cpu_blocked_determinant_4x4() {
+    float test_matrix[16] = {
+        4, 4, 4, 4,
+        6, 4, 1, 9,
+        5, 6, 6, 5,
+        9, 2, 6, 8
+    };
+
+    float mantissa = 0.0f;
+    long long int exponent = 0;
+    int sign = 1;
+
+    calculate_determinant_blocked(test_matrix, 4, 2, &mantissa, &exponent, &sign);
+    double result = (double)sign * (double)mantissa * pow(10.0, (double)exponent);
+
+    assert_true(fabs(result - 36.0) < 0.0001);
+}
+
+static void test_cpu_blocked_determinant_6x6_zero() {
+    float test_matrix[36] = {
+        1, 2, 3, 4, 5, 6,
+        1, 2, 3, 4, 5, 6,  
+        0, 0, 1, 0, 0, 0,
+        0, 0, 0, 1, 0, 0,
+        0, 0, 0, 0, 1, 0,
+        0, 0, 0, 0, 0, 1
+    };
+
+    float mantissa = 0.0f;
+    long long int exponent = 0;
+    int sign = 1;
+
+    calculate_determinant_blocked(test_matrix, 6, 3, &mantissa, &exponent, &sign);
+    double result = (double)sign * (double)mantissa * pow(10.0, (double)exponent);
+
+    assert_true(fabs(result - 0.0) < 0.0001);
+}
+
+static void test_cpu_blocked_matches_naive() {
+    int size = 200;
+    float* naive_matrix = malloc(size * size * sizeof(float));
+    float* blocked_matrix = malloc(size * size * sizeof(float));
+    assert_non_null(naive_matrix);
+    assert_non_null(blocked_matrix);
+
+    generate_matrix(naive_matrix, size);
+    memcpy(blocked_matrix, naive_matrix, size * size * sizeof(float));
+
+    float naive_mantissa = 0.0f, blocked_mantissa = 0.0f;
+    long long int naive_exponent = 0, blocked_exponent = 0;
+    int naive_sign = 1, blocked_sign = 1;
+
+    calculate_determinant_gauss(naive_matrix, size, &naive_mantissa, &naive_exponent, &naive_sign);
+    calculate_determinant_blocked(blocked_matrix, size, 4, &blocked_mantissa, &blocked_exponent, &blocked_sign);
+
+    assert_int_equal(blocked_sign, naive_sign);
+    double ratio = ((double)blocked_mantissa / (double)naive_mantissa) * pow(10.0, (double)(blocked_exponent - naive_exponent));
+    assert_true(fabs(ratio - 1.0) < 1e-3);
+
+    free(naive_matrix);
+    free(blocked_matrix);
+}
+
+static void test_simd_kernels_match_scalar() {
+    float source[185];
+    float reference[37];
+    float target[37];
+
+    for (int i = 0; i < 185; i++) {
+        source[i] = (float)((i * 37) % 101 - 50);
+    }
+    source[5 * 29] = 75.0f;
+    source[5 * 33] = -75.0f;
+
+    const simd_kernels* scalar = get_simd_kernels(SIMD_SCALAR);
+    assert_non_null(scalar);
+    assert_int_equal(scalar->argmax_abs(source, 5, 37), 29);
+
+    for (int isa = SIMD_SCALAR; isa < SIMD_ISA_COUNT; isa++) {
+        const simd_kernels* kernels = get_simd_kernels((simd_isa)isa);
+        if (kernels == NULL) {
+            continue;
+        }
+
+        assert_int_equal(kernels->argmax_abs(source, 5, 37), 29);
+        assert_int_equal(kernels->argmax_abs(source, 1, 185), scalar->argmax_abs(source, 1, 185));
+
+        for (int i = 0; i < 37; i++) {
+            reference[i] = (float)i;
+            target[i] = (float)i;
+        }
+        scalar->axpy(reference, source, 0.25f, 37);
+        kernels->axpy(target, source, 0.25f, 37);
+        for (int i = 0; i < 37; i++) {
+            assert_true(fabs(target[i] - reference[i]) < 1e-4);
+        }
+    }
+}
+
+static void test_scaled_product_large_and_signed() {
+    float values[1000];
+    for (int i = 0; i < 1000; i++) {
+        values[i] = i % 2 == 0 ? 2.0f : -2.0f;
+    }
+    values[999] = -2.0f;
+
+    scaled_product product;
+    float mantissa;
+    long long exponent;
+    int sign;
+
+    scaled_product_init(&product);
+    scaled_product_multiply_strided(&product, values, 1000, 1);
+    scaled_product_to_decimal(&product, &mantissa, &exponent, &sign);
+
+    assert_int_equal(exponent, 301);
+    assert_true(fabs(mantissa - 1.0715086f) < 1e-5);
+    assert_int_equal(sign, 1);
+
+    scaled_product_init(&product);
+    scaled_product_multiply_strided(&product, values, 999, 1);
+    scaled_product_to_decimal(&product, &mantissa, &exponent, &sign);
+    assert_int_equal(sign, -1);
+
+    scaled_product_multiply(&product, -0.5);
+    scaled_product_to_decimal(&product, &mantissa, &exponent, &sign);
+    assert_int_equal(sign, 1);
+    assert_int_equal(exponent, 300);
+    assert_true(fabs(mantissa - 2.6787715f) < 1e-5);
+
+    values[500] = 0.0f;
+    scaled_product_init(&product);
+    scaled_product_multiply_strided(&product, values, 1000, 1);
+    scaled_product_to_decimal(&product, &mantissa, &exponent, &sign);
+    assert_true(mantissa == 0.0f);
+    assert_int_equal(exponent, 0);
+}
+
 static void test_gpu_determinant_4x4() {
     float test_matrix[16] = {
         4, 4, 4, 4,
@@ -99,7 +245,7 @@ static void test_gpu_determinant_4x4() {
     long long int exponent = 0;
     int sign = 1;
 
-    calculate_determinant_gauss_opencl(test_matrix, 4, &mantissa, &exponent, &sign, NULL, NULL, NULL);
+    calculate_determinant_lu_opencl(test_matrix, 4, &mantissa, &exponent, &sign, NULL, NULL, NULL);
     double result = (double)sign * (double)mantissa * pow(10.0, (double)exponent);
 
     assert_true(fabs(result - 36.0) < 0.0001);
@@ -118,7 +264,7 @@ static void test_gpu_determinant_5x5() {
     long long int exponent = 0;
     int sign = 1;
 
-    calculate_determinant_gauss_opencl(test_matrix, 5, &mantissa, &exponent, &sign, NULL, NULL, NULL);
+    calculate_determinant_lu_opencl(test_matrix, 5, &mantissa, &exponent, &sign, NULL, NULL, NULL);
     double result = (double)sign * (double)mantissa * pow(10.0, (double)exponent);
 
     assert_true(fabs(result - 720.0) < 0.0001);
@@ -138,20 +284,763 @@ static void test_gpu_determinant_6x6_zero() {
     long long int exponent = 0;
     int sign = 1;
 
-    calculate_determinant_gauss_opencl(test_matrix, 6, &mantissa, &exponent, &sign, NULL, NULL, NULL);
+    calculate_determinant_lu_opencl(test_matrix, 6, &mantissa, &exponent, &sign, NULL, NULL, NULL);
     double result = (double)sign * (double)mantissa * pow(10.0, (double)exponent);
 
     assert_true(fabs(result - 0.0) < 0.0001);
 }
 
+static void test_gpu_determinant_zero_diagonal() {
+    float test_matrix[16] = {
+        0, 2, 0, 0,
+        3, 0, 0, 0,
+        0, 0, 0, 4,
+        0, 0, 5, 1
+    };
+
+    float mantissa = 0.0f;
+    long long int exponent = 0;
+    int sign = 1;
+
+    calculate_determinant_lu_opencl(test_matrix, 4, &mantissa, &exponent, &sign, NULL, NULL, NULL);
+    double result = (double)sign * (double)mantissa * pow(10.0, (double)exponent);
+
+    assert_true(fabs(result - 120.0) < 0.0001);
+}
+
+static void test_gpu_determinant_multi_block() {
+    int size = 40;
+    float cpu_matrix[40 * 40];
+    float gpu_matrix[40 * 40];
+
+    generate_matrix(cpu_matrix, size);
+    memcpy(gpu_matrix, cpu_matrix, sizeof(cpu_matrix));
+
+    float cpu_mantissa = 0.0f, gpu_mantissa = 0.0f;
+    long long int cpu_exponent = 0, gpu_exponent = 0;
+    int cpu_sign = 1, gpu_sign = 1;
+
+    calculate_determinant_gauss(cpu_matrix, size, &cpu_mantissa, &cpu_exponent, &cpu_sign);
+    calculate_determinant_lu_opencl(gpu_matrix, size, &gpu_mantissa, &gpu_exponent, &gpu_sign, NULL, NULL, NULL);
+
+    double cpu_result = (double)cpu_sign * (double)cpu_mantissa * pow(10.0, (double)cpu_exponent);
+    double gpu_result = (double)gpu_sign * (double)gpu_mantissa * pow(10.0, (double)gpu_exponent);
+
+    assert_true(fabs(cpu_result) > 0.0);
+    assert_true(fabs(gpu_result - cpu_result) / fabs(cpu_result) < 1e-3);
+}
+
+static void test_gpu_solver_reuse() {
+    float small_matrix[16] = {
+        4, 4, 4, 4,
+        6, 4, 1, 9,
+        5, 6, 6, 5,
+        9, 2, 6, 8
+    };
+    float large_matrix[25] = {
+        2, 0, 0, 0, 0,
+        0, 3, 0, 0, 0,
+        0, 0, 4, 0, 0,
+        0, 0, 0, 5, 0,
+        0, 0, 0, 0, 6
+    };
+    float work_matrix[25];
+
+    float mantissa = 0.0f;
+    long long int exponent = 0;
+    int sign = 1;
+    int error_code;
+
+    lu_solver* solver = lu_solver_create(&error_code);
+    assert_non_null(solver);
+
+    for (int run = 0; run < 2; run++) {
+        memcpy(work_matrix, small_matrix, sizeof(small_matrix));
+        lu_solver_calculate_determinant(solver, work_matrix, 4, &mantissa, &exponent, &sign, NULL, NULL, NULL, &error_code);
+        double result = (double)sign * (double)mantissa * pow(10.0, (double)exponent);
+        assert_true(fabs(result - 36.0) < 0.0001);
+
+        memcpy(work_matrix, large_matrix, sizeof(large_matrix));
+        lu_solver_calculate_determinant(solver, work_matrix, 5, &mantissa, &exponent, &sign, NULL, NULL, NULL, &error_code);
+        result = (double)sign * (double)mantissa * pow(10.0, (double)exponent);
+        assert_true(fabs(result - 720.0) < 0.0001);
+    }
+
+    lu_solver_release(solver);
+}
+
+static void test_gpu_program_binary_cache() {
+    float test_matrix[16] = {
+        4, 4, 4, 4,
+        6, 4, 1, 9,
+        5, 6, 6, 5,
+        9, 2, 6, 8
+    };
+
+    float mantissa = 0.0f;
+    long long int exponent = 0;
+    int sign = 1;
+    int error_code;
+
+    lu_solver* first_solver = lu_solver_create(&error_code);
+    assert_non_null(first_solver);
+    lu_solver_release(first_solver);
+
+    lu_solver* cached_solver = lu_solver_create(&error_code);
+    assert_non_null(cached_solver);
+    assert_int_equal(cached_solver->program_from_cache, 1);
+
+    lu_solver_calculate_determinant(cached_solver, test_matrix, 4, &mantissa, &exponent, &sign, NULL, NULL, NULL, &error_code);
+    double result = (double)sign * (double)mantissa * pow(10.0, (double)exponent);
+
+    assert_true(fabs(result - 36.0) < 0.0001);
+
+    lu_solver_release(cached_solver);
+}
+
+static void test_gpu_block_size_override() {
+    int size = 40;
+    float source[40 * 40];
+    float cpu_matrix[40 * 40];
+    float gpu_matrix[40 * 40];
+    int block_sizes[] = {8, 32};
+
+    generate_matrix(source, size);
+    memcpy(cpu_matrix, source, sizeof(source));
+
+    float cpu_mantissa = 0.0f, gpu_mantissa = 0.0f;
+    long long int cpu_exponent = 0, gpu_exponent = 0;
+    int cpu_sign = 1, gpu_sign = 1;
+    int error_code;
+
+    calculate_determinant_gauss(cpu_matrix, size, &cpu_mantissa, &cpu_exponent, &cpu_sign);
+    double cpu_result = (double)cpu_sign * (double)cpu_mantissa * pow(10.0, (double)cpu_exponent);
+
+    lu_solver* solver = lu_solver_create(&error_code);
+    assert_non_null(solver);
+
+    for (int i = 0; i < 2; i++) {
+        lu_solver_set_block_size(solver, block_sizes[i], &error_code);
+        assert_int_equal(error_code, 0);
+        assert_int_equal(solver->block_size, block_sizes[i]);
+
+        memcpy(gpu_matrix, source, sizeof(source));
+        lu_solver_calculate_determinant(solver, gpu_matrix, size, &gpu_mantissa, &gpu_exponent, &gpu_sign, NULL, NULL, NULL, &error_code);
+        double gpu_result = (double)gpu_sign * (double)gpu_mantissa * pow(10.0, (double)gpu_exponent);
+
+        assert_true(fabs(gpu_result - cpu_result) / fabs(cpu_result) < 1e-3);
+    }
+
+    lu_solver_set_block_size(solver, 1 << 20, &error_code);
+    assert_int_not_equal(error_code, 0);
+    assert_int_equal(solver->block_size, 32);
+
+    lu_solver_release(solver);
+}
+
+static void test_gpu_matrix_readback_opt_in() {
+    float test_matrix[16] = {
+        4, 4, 4, 4,
+        6, 4, 1, 9,
+        5, 6, 6, 5,
+        9, 2, 6, 8
+    };
+    float work_matrix[16];
+
+    float mantissa = 0.0f;
+    long long int exponent = 0;
+    int sign = 1;
+    int error_code;
+
+    lu_solver* solver = lu_solver_create(&error_code);
+    assert_non_null(solver);
+
+    memcpy(work_matrix, test_matrix, sizeof(test_matrix));
+    lu_solver_calculate_determinant(solver, work_matrix, 4, &mantissa, &exponent, &sign, NULL, NULL, NULL, &error_code);
+    assert_memory_equal(work_matrix, test_matrix, sizeof(test_matrix));
+
+    solver->read_back_matrix = 1;
+    lu_solver_calculate_determinant(solver, work_matrix, 4, &mantissa, &exponent, &sign, NULL, NULL, NULL, &error_code);
+    double diagonal_product = 1.0;
+    for (int i = 0; i < 4; i++) {
+        diagonal_product *= work_matrix[i * 4 + i];
+    }
+    double result = (double)sign * (double)mantissa * pow(10.0, (double)exponent);
+
+    assert_true(fabs(result - 36.0) < 0.0001);
+    assert_true(fabs(fabs(diagonal_product) - 36.0) < 0.001);
+
+    lu_solver_release(solver);
+}
+
+static void test_correction_trace_probes() {
+    int size = 96;
+    float* factors = calloc(size * size, sizeof(float));
+    float* residual = calloc(size * size, sizeof(float));
+    assert_non_null(factors);
+    assert_non_null(residual);
+
+    double expected = 0.0;
+    for (int i = 0; i < size; i++) {
+        factors[i * size + i] = 2.0f + (float)(i % 5);
+        residual[i * size + i] = 1e-3f * (float)(i % 7 - 3);
+        expected += (double)residual[i * size + i] / factors[i * size + i];
+    }
+
+    double standard_error;
+    double exact = lu_correction_trace(factors, size, residual, size, size, 0, 2, &standard_error);
+    assert_true(fabs(exact - expected) < 1e-12);
+    assert_true(standard_error == 0.0);
+
+    double estimate = lu_correction_trace(factors, size, residual, size, size, REFINEMENT_PROBE_COUNT, 2, &standard_error);
+    assert_true(fabs(estimate - expected) < 1e-12);
+    assert_true(standard_error < 1e-6 * fabs(expected));
+
+    residual[size - 1] = 1e-3f;
+    estimate = lu_correction_trace(factors, size, residual, size, size, REFINEMENT_PROBE_COUNT, 2, &standard_error);
+    assert_true(standard_error > 0.0);
+    assert_true(fabs(estimate - expected) < 4.0 * standard_error);
+
+    free(factors);
+    free(residual);
+}
+
+static void test_gpu_precision_modes() {
+    int size = 72;
+    float* source = malloc(size * size * sizeof(float));
+    float* work = malloc(size * size * sizeof(float));
+    assert_non_null(source);
+    assert_non_null(work);
+
+    generate_matrix(source, size);
+    memcpy(work, source, size * size * sizeof(float));
+
+    int reference_sign = 1;
+    double reference_log10 = calculate_log10_determinant_double(work, size, &reference_sign);
+    assert_false(isinf(reference_log10));
+
+    float mantissa = 0.0f;
+    long long int exponent = 0;
+    int sign = 1;
+    int error_code;
+
+    lu_solver* solver = lu_solver_create(&error_code);
+    assert_non_null(solver);
+
+    lu_solver_set_precision(solver, PRECISION_MIXED, &error_code);
+    assert_int_equal(error_code, 0);
+    assert_int_equal(solver->refinement_probes, REFINEMENT_PROBE_COUNT);
+
+    memcpy(work, source, size * size * sizeof(float));
+    lu_solver_calculate_determinant(solver, work, size, &mantissa, &exponent, &sign, NULL, NULL, NULL, &error_code);
+    assert_int_equal(error_code, 0);
+    assert_int_equal(sign, reference_sign);
+    assert_true(solver->refinement_standard_error > 0.0);
+    assert_true(fabs(pow(10.0, solver->log10_determinant - reference_log10) - 1.0) < 1e-4);
+
+    lu_solver_set_refinement_probes(solver, -1, &error_code);
+    assert_int_not_equal(error_code, 0);
+    lu_solver_set_refinement_probes(solver, 0, &error_code);
+    assert_int_equal(error_code, 0);
+
+    memcpy(work, source, size * size * sizeof(float));
+    lu_solver_calculate_determinant(solver, work, size, &mantissa, &exponent, &sign, NULL, NULL, NULL, &error_code);
+    assert_int_equal(sign, reference_sign);
+    assert_true(solver->refinement_standard_error == 0.0);
+    assert_true(fabs(pow(10.0, solver->log10_determinant - reference_log10) - 1.0) < 1e-9);
+
+    lu_solver_set_precision(solver, PRECISION_FP64, &error_code);
+    if (solver->supports_fp64) {
+        assert_int_equal(error_code, 0);
+
+        memcpy(work, source, size * size * sizeof(float));
+        lu_solver_calculate_determinant(solver, work, size, &mantissa, &exponent, &sign, NULL, NULL, NULL, &error_code);
+        assert_int_equal(sign, reference_sign);
+        assert_true(fabs(pow(10.0, solver->log10_determinant - reference_log10) - 1.0) < 1e-9);
+    } else {
+        assert_int_not_equal(error_code, 0);
+        assert_int_equal(solver->precision, PRECISION_MIXED);
+    }
+
+    lu_solver_release(solver);
+    free(source);
+    free(work);
+}
+
+static void test_gpu_pipelined_upload_matches_serial() {
+    int size = 150;
+    float* source = malloc(size * size * sizeof(float));
+    float* work = malloc(size * size * sizeof(float));
+    assert_non_null(source);
+    assert_non_null(work);
+
+    generate_matrix(source, size);
+
+    float serial_mantissa = 0.0f, pipelined_mantissa = 0.0f;
+    long long int serial_exponent = 0, pipelined_exponent = 0;
+    int serial_sign = 1, pipelined_sign = 1;
+    int error_code;
+
+    lu_solver* solver = lu_solver_create(&error_code);
+    assert_non_null(solver);
+    lu_solver_set_block_size(solver, 16, &error_code);
+    assert_int_equal(error_code, 0);
+
+    solver->pipelined_upload = 0;
+    memcpy(work, source, size * size * sizeof(float));
+    lu_solver_calculate_determinant(solver, work, size, &serial_mantissa, &serial_exponent, &serial_sign, NULL, NULL, NULL, &error_code);
+
+    solver->pipelined_upload = 1;
+    memcpy(work, source, size * size * sizeof(float));
+    lu_solver_calculate_determinant(solver, work, size, &pipelined_mantissa, &pipelined_exponent, &pipelined_sign, NULL, NULL, NULL, &error_code);
+
+    assert_int_equal(pipelined_sign, serial_sign);
+    assert_true(pipelined_exponent == serial_exponent);
+    assert_true(fabs(pipelined_mantissa - serial_mantissa) < 1e-5);
+    assert_true(solver->time_serialized_total > 0.0f);
+
+    lu_solver_release(solver);
+    free(source);
+    free(work);
+}
+
+static void test_gpu_matrix_alloc_transfer_modes() {
+    float test_matrix[16] = {
+        4, 4, 4, 4,
+        6, 4, 1, 9,
+        5, 6, 6, 5,
+        9, 2, 6, 8
+    };
+
+    float mantissa = 0.0f;
+    long long int exponent = 0;
+    int sign = 1;
+    int error_code;
+
+    lu_solver* solver = lu_solver_create(&error_code);
+    assert_non_null(solver);
+
+    for (int unified = 0; unified <= 1; unified++) {
+        solver->host_unified_memory = unified;
+        float* matrix = matrix_alloc(solver, 4, &error_code);
+        assert_int_equal(error_code, 0);
+        assert_non_null(matrix);
+        assert_int_equal((uintptr_t)matrix % 64, 0);
+
+        int leading_dimension = matrix_leading_dimension(solver, matrix, 4);
+        assert_int_equal(leading_dimension, device_leading_dimension(solver, 4));
+
+        matrix_copy(solver, matrix, test_matrix, 4);
+        solver->read_back_matrix = 0;
+        lu_solver_calculate_determinant(solver, matrix, 4, &mantissa, &exponent, &sign, NULL, NULL, NULL, &error_code);
+        assert_string_equal(solver->transfer_mode, unified ? "zero-copy" : "pinned");
+        assert_true(fabs((double)sign * mantissa * pow(10.0, (double)exponent) - 36.0) < 0.0001);
+        int preserved = 1;
+        for (int i = 0; i < 4; i++) {
+            preserved &= memcmp(matrix + i * leading_dimension, test_matrix + i * 4, 4 * sizeof(float)) == 0;
+        }
+        assert_int_equal(preserved, !unified);
+
+        matrix_copy(solver, matrix, test_matrix, 4);
+        solver->read_back_matrix = 1;
+        lu_solver_calculate_determinant(solver, matrix, 4, &mantissa, &exponent, &sign, NULL, NULL, NULL, &error_code);
+        assert_string_equal(solver->transfer_mode, unified ? "zero-copy" : "pinned");
+        assert_true(fabs((double)sign * mantissa * pow(10.0, (double)exponent) - 36.0) < 0.0001);
+        double diagonal_product = 1.0;
+        for (int i = 0; i < 4; i++) {
+            diagonal_product *= matrix[i * leading_dimension + i];
+        }
+        assert_true(fabs(fabs(diagonal_product) - 36.0) < 0.001);
+
+        matrix_free(solver, matrix);
+        assert_int_equal(solver->allocation_count, 0);
+    }
+
+    lu_solver_release(solver);
+}
+
+static void test_gpu_layouts_match_row_major() {
+    static const device_layout layouts[] = {DEVICE_LAYOUT_COLUMN_MAJOR, DEVICE_LAYOUT_TILED};
+    int size = 150;
+    float* source = malloc(size * size * sizeof(float));
+    float* reference = malloc(size * size * sizeof(float));
+    assert_non_null(source);
+    assert_non_null(reference);
+
+    generate_matrix(source, size);
+
+    float reference_mantissa = 0.0f;
+    long long int reference_exponent = 0;
+    int reference_sign = 1;
+    int error_code;
+
+    lu_solver* solver = lu_solver_create(&error_code);
+    assert_non_null(solver);
+    lu_solver_set_block_size(solver, 16, &error_code);
+    assert_int_equal(error_code, 0);
+
+    solver->read_back_matrix = 1;
+    memcpy(reference, source, size * size * sizeof(float));
+    lu_solver_calculate_determinant(solver, reference, size, &reference_mantissa, &reference_exponent, &reference_sign, NULL, NULL, NULL, &error_code);
+    assert_int_equal(solver->padded_size, 160);
+    assert_true(solver->leading_dimension > solver->padded_size);
+
+    for (size_t i = 0; i < sizeof(layouts) / sizeof(layouts[0]); i++) {
+        lu_solver_set_layout(solver, layouts[i], &error_code);
+        assert_int_equal(error_code, 0);
+
+        for (int unified = 0; unified <= 1; unified++) {
+            solver->host_unified_memory = unified;
+            float* work = matrix_alloc(solver, size, &error_code);
+            assert_non_null(work);
+            matrix_copy(solver, work, source, size);
+            int work_leading_dimension = matrix_leading_dimension(solver, work, size);
+
+            float mantissa = 0.0f;
+            long long int exponent = 0;
+            int sign = 1;
+            lu_solver_calculate_determinant(solver, work, size, &mantissa, &exponent, &sign, NULL, NULL, NULL, &error_code);
+
+            assert_int_equal(sign, reference_sign);
+            assert_true(exponent == reference_exponent);
+            assert_true(fabs(mantissa - reference_mantissa) < 1e-4);
+            assert_true(solver->leading_dimension >= size);
+            assert_true(solver->time_layout > 0.0f);
+            for (int j = 0; j < size * size; j++) {
+                float value = work[(j / size) * work_leading_dimension + j % size];
+                assert_true(fabs(value - reference[j]) <= 1e-3 * (1.0 + fabs(reference[j])));
+            }
+
+            matrix_free(solver, work);
+        }
+    }
+
+    assert_int_equal(solver->leading_dimension % solver->block_size, 0);
+
+    lu_solver_set_layout(solver, DEVICE_LAYOUT_COLUMN_MAJOR, &error_code);
+    lu_solver_set_precision(solver, PRECISION_MIXED, &error_code);
+    assert_int_equal(error_code, 0);
+    float mantissa = 0.0f;
+    long long int exponent = 0;
+    int sign = 1;
+    memcpy(reference, source, size * size * sizeof(float));
+    lu_solver_calculate_determinant(solver, reference, size, &mantissa, &exponent, &sign, NULL, NULL, NULL, &error_code);
+    assert_int_equal(sign, reference_sign);
+    assert_true(fabs((double)mantissa * pow(10.0, (double)(exponent - reference_exponent)) - reference_mantissa) < 1e-3 * fabs(reference_mantissa));
+
+    lu_solver_release(solver);
+    free(source);
+    free(reference);
+}
+
+static void test_gpu_padded_sizes_match_cpu() {
+    static const int sizes[] = {63, 64, 65, 100};
+    int error_code;
+
+    lu_solver* solver = lu_solver_create(&error_code);
+    assert_non_null(solver);
+    lu_solver_set_block_size(solver, 16, &error_code);
+    assert_int_equal(error_code, 0);
+
+    for (int size = 4000; size <= 8200; size += 8) {
+        assert_true(device_leading_dimension(solver, size) % LEADING_DIMENSION_CONFLICT_STRIDE != 0);
+        assert_true(device_leading_dimension(solver, size) % LEADING_DIMENSION_ALIGN == 0);
+    }
+
+    solver->read_back_matrix = 1;
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        int size = sizes[i];
+        float* cpu_matrix = malloc(size * size * sizeof(float));
+        float* gpu_matrix = malloc(size * size * sizeof(float));
+        assert_non_null(cpu_matrix);
+        assert_non_null(gpu_matrix);
+
+        generate_matrix(cpu_matrix, size);
+        memcpy(gpu_matrix, cpu_matrix, size * size * sizeof(float));
+
+        float cpu_mantissa = 0.0f, gpu_mantissa = 0.0f;
+        long long int cpu_exponent = 0, gpu_exponent = 0;
+        int cpu_sign = 1, gpu_sign = 1;
+
+        calculate_determinant_gauss(cpu_matrix, size, &cpu_mantissa, &cpu_exponent, &cpu_sign);
+        lu_solver_calculate_determinant(solver, gpu_matrix, size, &gpu_mantissa, &gpu_exponent, &gpu_sign, NULL, NULL, NULL, &error_code);
+
+        assert_int_equal(solver->padded_size % solver->block_size, 0);
+        assert_true(solver->padded_size >= size && solver->padded_size < size + solver->block_size);
+        assert_int_equal(gpu_sign, cpu_sign);
+        assert_true(fabs((double)gpu_mantissa * pow(10.0, (double)(gpu_exponent - cpu_exponent)) - cpu_mantissa) < 1e-3 * fabs(cpu_mantissa));
+
+        for (int j = 0; j < size; j++) {
+            assert_true(fabs(fabs(gpu_matrix[j * size + j]) - fabs(cpu_matrix[j * size + j])) <= 1e-3 * (1.0 + fabs(cpu_matrix[j * size + j])));
+        }
+
+        free(cpu_matrix);
+        free(gpu_matrix);
+    }
+
+    lu_solver_release(solver);
+}
+
+static void test_out_of_core_matches_cpu() {
+    int size = 100;
+    float cpu_matrix[100 * 100];
+    float streamed_matrix[100 * 100];
+
+    generate_matrix(cpu_matrix, size);
+    memcpy(streamed_matrix, cpu_matrix, sizeof(cpu_matrix));
+
+    float cpu_mantissa = 0.0f, streamed_mantissa = 0.0f;
+    long long int cpu_exponent = 0, streamed_exponent = 0;
+    int cpu_sign = 1, streamed_sign = 1;
+    int error_code;
+
+    calculate_determinant_gauss(cpu_matrix, size, &cpu_mantissa, &cpu_exponent, &cpu_sign);
+
+    lu_solver* solver = lu_solver_create(&error_code);
+    assert_non_null(solver);
+
+    size_t budget = OUT_OF_CORE_SLAB_BUFFERS * sizeof(streamed_matrix) / size * 16 + (16 + size) * sizeof(cl_long);
+    assert_true(sizeof(streamed_matrix) > budget);
+
+    out_of_core_stats stats;
+    calculate_determinant_out_of_core(solver, streamed_matrix, size, budget, &streamed_mantissa, &streamed_exponent, &streamed_sign, &stats, &error_code);
+    assert_int_equal(error_code, 0);
+    assert_int_equal(stats.slab_width, 16);
+    assert_int_equal(stats.slab_count, 7);
+    assert_true(stats.working_set_bytes <= budget);
+
+    double cpu_result = (double)cpu_sign * (double)cpu_mantissa * pow(10.0, (double)cpu_exponent);
+    double streamed_result = (double)streamed_sign * (double)streamed_mantissa * pow(10.0, (double)streamed_exponent);
+    assert_true(fabs(cpu_result) > 0.0);
+    assert_true(fabs(streamed_result - cpu_result) / fabs(cpu_result) < 1e-3);
+
+    calculate_determinant_out_of_core(solver, streamed_matrix, size, 64, &streamed_mantissa, &streamed_exponent, &streamed_sign, NULL, &error_code);
+    assert_int_equal(error_code, CL_OUT_OF_RESOURCES);
+
+    lu_solver_release(solver);
+}
+
+static void test_multi_device_weighted_assignment() {
+    double throughput[2] = {3.0, 1.0};
+    int owners[8];
+    int local_indices[8];
+    int block_columns[2];
+
+    assign_block_columns(throughput, 2, 8, owners, local_indices, block_columns);
+    assert_int_equal(block_columns[0], 6);
+    assert_int_equal(block_columns[1], 2);
+    assert_int_equal(owners[0], 0);
+    assert_int_equal(owners[7], 1);
+
+    int seen[2] = {0, 0};
+    for (int block = 0; block < 8; block++) {
+        assert_int_equal(local_indices[block], seen[owners[block]]++);
+    }
+}
+
+static void test_multi_device_matches_cpu() {
+    int size = 50;
+    float cpu_matrix[50 * 50];
+    float device_matrix[50 * 50];
+
+    generate_matrix(cpu_matrix, size);
+    memcpy(device_matrix, cpu_matrix, sizeof(cpu_matrix));
+
+    float cpu_mantissa = 0.0f, device_mantissa = 0.0f;
+    long long int cpu_exponent = 0, device_exponent = 0;
+    int cpu_sign = 1, device_sign = 1;
+    int error_code;
+
+    calculate_determinant_gauss(cpu_matrix, size, &cpu_mantissa, &cpu_exponent, &cpu_sign);
+
+    multi_device_solver* solver = create_multi_device_solver(2, &error_code);
+    assert_non_null(solver);
+    assert_true(solver->device_count >= 1);
+
+    calculate_determinant_multi_device(solver, device_matrix, size, &device_mantissa, &device_exponent, &device_sign, &error_code);
+    assert_int_equal(error_code, 0);
+
+    int total_blocks = 0;
+    for (int d = 0; d < solver->device_count; d++) {
+        total_blocks += solver->block_columns[d];
+        assert_true(solver->throughput[d] > 0.0);
+    }
+    assert_int_equal(total_blocks, (size + solver->block_width - 1) / solver->block_width);
+
+    double cpu_result = (double)cpu_sign * (double)cpu_mantissa * pow(10.0, (double)cpu_exponent);
+    double device_result = (double)device_sign * (double)device_mantissa * pow(10.0, (double)device_exponent);
+    assert_true(fabs(cpu_result) > 0.0);
+    assert_true(fabs(device_result - cpu_result) / fabs(cpu_result) < 1e-3);
+
+    release_multi_device_solver(solver);
+}
+
+static void test_matrix_file_round_trip() {
+    const char* path = "test_matrix_file.bin";
+    float matrix[6 * 6];
+    double wide[6 * 6];
+    int size = 6;
+    int error_code;
+
+    generate_matrix(matrix, size);
+    write_matrix_file(path, matrix, size, &error_code);
+    assert_int_equal(error_code, 0);
+
+    matrix_file file;
+    matrix_file_open(path, &file, &error_code);
+    assert_int_equal(error_code, 0);
+    assert_int_equal(file.header.rows, size);
+    assert_int_equal(file.header.cols, size);
+    assert_int_equal(matrix_file_verify(&file), 0);
+
+    float* loaded = matrix_file_floats(&file, &error_code);
+    assert_int_equal(error_code, 0);
+    assert_memory_equal(loaded, matrix, sizeof(matrix));
+
+    loaded[0] += 1.0f;
+    assert_int_equal(matrix_file_verify(&file), MATRIX_FILE_ERROR_CHECKSUM);
+    matrix_file_close(&file);
+
+    matrix_file_open(path, &file, &error_code);
+    assert_int_equal(error_code, 0);
+    assert_int_equal(matrix_file_verify(&file), 0);
+    matrix_file_close(&file);
+
+    for (int i = 0; i < size * size; i++) {
+        wide[i] = matrix[i];
+    }
+
+    matrix_file_writer writer;
+    matrix_file_writer_open(&writer, path, size, size, MATRIX_ELEMENT_FLOAT64, MATRIX_LAYOUT_COLUMN_MAJOR, MATRIX_FILE_HAS_CHECKSUM, &error_code);
+    assert_int_equal(error_code, 0);
+    matrix_file_writer_write(&writer, wide, 10, &error_code);
+    assert_int_equal(error_code, 0);
+    matrix_file_writer_write(&writer, wide + 10, size * size - 10, &error_code);
+    assert_int_equal(error_code, 0);
+    matrix_file_writer_write(&writer, wide, 1, &error_code);
+    assert_int_equal(error_code, MATRIX_FILE_ERROR_SIZE);
+    matrix_file_writer_close(&writer, &error_code);
+    assert_int_equal(error_code, 0);
+
+    matrix_file_open(path, &file, &error_code);
+    assert_int_equal(error_code, 0);
+    assert_int_equal(file.header.layout, MATRIX_LAYOUT_COLUMN_MAJOR);
+    assert_int_equal(matrix_file_verify(&file), 0);
+    loaded = matrix_file_floats(&file, &error_code);
+    assert_non_null(loaded);
+    assert_memory_equal(loaded, matrix, sizeof(matrix));
+    matrix_file_close(&file);
+
+    uint32_t misaligned_header_size = MATRIX_FILE_HEADER_SIZE + sizeof(double);
+    FILE* misaligned = fopen(path, "r+b");
+    assert_non_null(misaligned);
+    fseek(misaligned, offsetof(matrix_file_header, header_size), SEEK_SET);
+    fwrite(&misaligned_header_size, sizeof(misaligned_header_size), 1, misaligned);
+    fclose(misaligned);
+    matrix_file_open(path, &file, &error_code);
+    assert_int_equal(error_code, MATRIX_FILE_ERROR_FORMAT);
+
+    FILE* truncated = fopen(path, "r+b");
+    assert_non_null(truncated);
+    fputc('X', truncated);
+    fclose(truncated);
+    matrix_file_open(path, &file, &error_code);
+    assert_int_equal(error_code, MATRIX_FILE_ERROR_FORMAT);
+
+    remove(path);
+}
+
+static void test_profiler_records_commands() {
+    int size = 40;
+    float matrix[40 * 40];
+    int error_code;
+
+    lu_solver* solver = lu_solver_create(&error_code);
+    assert_non_null(solver);
+    solver->profiler = create_profiler();
+    assert_non_null(solver->profiler);
+
+    generate_matrix(matrix, size);
+    float mantissa = 0.0f;
+    long long exponent = 0;
+    int sign = 1;
+    lu_solver_calculate_determinant(solver, matrix, size, &mantissa, &exponent, &sign, NULL, NULL, NULL, &error_code);
+
+    const profiler* profiler = solver->profiler;
+    int panel_count = 0;
+    double upload_bytes = 0.0;
+    for (int i = 0; i < profiler->count; i++) {
+        const profile_record* record = &profiler->records[i];
+        assert_true(record->queued <= record->submit);
+        assert_true(record->submit <= record->start);
+        assert_true(record->start <= record->end);
+        if (strcmp(record->name, "lu_factorize_panel") == 0) panel_count++;
+        if (strcmp(record->phase, "upload") == 0) upload_bytes += record->bytes;
+    }
+    assert_int_equal(panel_count, (size + solver->block_size - 1) / solver->block_size);
+    assert_true(fabs(upload_bytes - (double)(sizeof(matrix) + sizeof(int))) < 1.0);
+
+    profile_info info = {"opencl_blocked_lu", solver->device_id, size, solver->block_size, "fp32", 0.01, 2.0 * size * size * size / 3.0};
+    assert_int_equal(write_profile_json(profiler, &info, "test_profile.json"), 0);
+    assert_int_equal(write_profile_csv(profiler, &info, "test_profile.csv"), 0);
+    assert_int_equal(write_chrome_trace(profiler, "test_profile_trace.json"), 0);
+
+    char text[4096];
+    FILE* file = fopen("test_profile.json", "r");
+    assert_non_null(file);
+    size_t length = fread(text, 1, sizeof(text) - 1, file);
+    text[length] = '\0';
+    fclose(file);
+    assert_non_null(strstr(text, "\"matrix_size\": 40"));
+    assert_non_null(strstr(text, "\"phase\": \"trailing\""));
+
+    file = fopen("test_profile_trace.json", "r");
+    assert_non_null(file);
+    length = fread(text, 1, sizeof(text) - 1, file);
+    text[length] = '\0';
+    fclose(file);
+    assert_non_null(strstr(text, "\"traceEvents\""));
+
+    remove("test_profile.json");
+    remove("test_profile.csv");
+    remove("test_profile_trace.json");
+
+    profiler_reset(solver->profiler);
+    assert_int_equal(solver->profiler->count, 0);
+    release_profiler(solver->profiler);
+    lu_solver_release(solver);
+}
+
 int main() {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(test_cpu_determinant_4x4),
         cmocka_unit_test(test_cpu_determinant_5x5),
         cmocka_unit_test(test_cpu_determinant_6x6_zero),
+        cmocka_unit_test(test_cpu_blocked_determinant_4x4),
+        cmocka_unit_test(test_cpu_blocked_determinant_6x6_zero),
+        cmocka_unit_test(test_cpu_blocked_matches_naive),
+        cmocka_unit_test(test_simd_kernels_match_scalar),
+        cmocka_unit_test(test_scaled_product_large_and_signed),
         cmocka_unit_test(test_gpu_determinant_4x4),
         cmocka_unit_test(test_gpu_determinant_5x5),
         cmocka_unit_test(test_gpu_determinant_6x6_zero),
+        cmocka_unit_test(test_gpu_determinant_zero_diagonal),
+        cmocka_unit_test(test_gpu_determinant_multi_block),
+        cmocka_unit_test(test_gpu_solver_reuse),
+        cmocka_unit_test(test_gpu_program_binary_cache),
+        cmocka_unit_test(test_gpu_block_size_override),
+        cmocka_unit_test(test_gpu_matrix_readback_opt_in),
+        cmocka_unit_test(test_correction_trace_probes),
+        cmocka_unit_test(test_gpu_precision_modes),
+        cmocka_unit_test(test_gpu_pipelined_upload_matches_serial),
+        cmocka_unit_test(test_gpu_matrix_alloc_transfer_modes),
+        cmocka_unit_test(test_gpu_layouts_match_row_major),
+        cmocka_unit_test(test_gpu_padded_sizes_match_cpu),
+        cmocka_unit_test(test_out_of_core_matches_cpu),
+        cmocka_unit_test(test_multi_device_weighted_assignment),
+        cmocka_unit_test(test_multi_device_matches_cpu),
+        cmocka_unit_test(test_matrix_file_round_trip),
+        cmocka_unit_test(test_profiler_records_commands),
     };
 
     printf("Matrix Determinant Tests\n");
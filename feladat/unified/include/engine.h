@@ -0,0 +1,66 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#define ENGINE_BENCHMARK_FILE "outputs/engine_benchmarks.txt"
+#define ENGINE_MAX_BENCHMARKS 256
+#define ENGINE_SMALL_MATRIX_SIZE 128
+#define ENGINE_GAUSS_MAX_SIZE 46340
+
+#define ENGINE_ERROR_UNSUPPORTED -10
+#define ENGINE_ERROR_MEMORY -11
+
+typedef enum {
+    ENGINE_AUTO,
+    ENGINE_CPU_NAIVE,
+    ENGINE_CPU_BLOCKED,
+    ENGINE_OPENCL_GAUSS,
+    ENGINE_OPENCL_LU,
+    ENGINE_BATCHED,
+    ENGINE_COUNT
+} engine_kind;
+
+typedef struct {
+    engine_kind engine;
+    int matrix_size;
+    double seconds;
+} engine_benchmark;
+
+typedef struct {
+    char device_name[256];
+    int has_opencl_device;
+    int thread_count;
+    void* gauss_solver;
+    void* lu_solver;
+    engine_benchmark benchmarks[ENGINE_MAX_BENCHMARKS];
+    int benchmark_count;
+} engine_context;
+
+const char* engine_name(engine_kind engine);
+
+int parse_engine_name(const char* name, engine_kind* out_engine);
+
+engine_context* create_engine_context(int thread_count, int* error_code);
+
+int engine_supports(const engine_context* context, engine_kind engine, int size);
+
+engine_kind select_engine(const engine_context* context, int size);
+
+engine_kind select_batch_engine(const engine_context* context, int size, int batch_count);
+
+void prepare_engine(engine_context* context, engine_kind engine, int* error_code);
+
+void calculate_determinant_engine(engine_context* context, engine_kind engine, float* matrix, int size, float* out_mantissa, long long* out_exponent, int* out_sign, int* error_code);
+
+void calculate_determinants_engine_batched(engine_context* context, engine_kind engine, const float* matrices, int batch_count, int size, float* out_mantissas, long long* out_exponents, int* out_signs, int* error_code);
+
+void record_engine_benchmark(engine_context* context, engine_kind engine, int size, double seconds);
+
+int load_engine_benchmarks(engine_context* context, const char* path);
+
+void save_engine_benchmarks(const engine_context* context, const char* path);
+
+void generate_engine_matrix(float* matrix, int size);
+
+void release_engine_context(engine_context* context);
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef ENGINE_BACKENDS_H
+#define ENGINE_BACKENDS_H
+
+void* gauss_backend_create(int* error_code);
+
+void gauss_backend_determinant(void* solver, float* matrix, int size, float* out_mantissa, long long* out_exponent, int* out_sign);
+
+void gauss_backend_determinants_batched(void* solver, const float* matrices, int batch_count, int size, float* out_mantissas, long long* out_exponents, int* out_signs, int* error_code);
+
+void gauss_backend_cpu_determinant(float* matrix, int size, float* out_mantissa, long long* out_exponent, int* out_sign);
+
+int gauss_backend_batch_max_size(void);
+
+void gauss_backend_release(void* solver);
+
+void* lu_backend_create(int* error_code);
+
+void lu_backend_determinant(void* solver, float* matrix, int size, float* out_mantissa, long long* out_exponent, int* out_sign, int* error_code);
+
+void lu_backend_generate_matrix(float* matrix, int size);
+
+void lu_backend_release(void* solver);
+
+#endif
@@ -0,0 +1,275 @@
+#include "engine.h"
+#include "cpu_solver.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #include <direct.h>
+    #define mkdir(path, mode) _mkdir(path)
+#else
+    #include <sys/stat.h>
+    #include <sys/types.h>
+#endif
+
+int MATRIX_SIZE = 1000;
+
+#define MAX_MATRIX_SIZE_CPU 2000
+#define CALIBRATION_MIN_SIZE 16
+#define CALIBRATION_RUNS 3
+
+static void print_determinant(const char* label, float mantissa, long long exponent, int sign) {
+    if (mantissa == 0.0f) {
+        printf("Determinant (%s): 0\n", label);
+    } else {
+        printf("Determinant (%s): %s%.4f * 10^%lld\n", label, sign < 0 ? "-" : "", mantissa, exponent);
+    }
+}
+
+static double time_engine(engine_context* context, engine_kind engine, const float* matrix, float* work, int size, int runs, int* error_code) {
+    float mantissa;
+    long long exponent;
+    int sign;
+    double best_time = 0.0;
+
+    for (int run = 0; run < runs && *error_code == 0; run++) {
+        memcpy(work, matrix, (size_t)size * size * sizeof(float));
+        double start = wall_clock_seconds();
+        calculate_determinant_engine(context, engine, work, size, &mantissa, &exponent, &sign, error_code);
+        double elapsed = wall_clock_seconds() - start;
+        if (run == 0 || elapsed < best_time) {
+            best_time = elapsed;
+        }
+    }
+
+    return best_time;
+}
+
+static void calibrate_size(engine_context* context, int size) {
+    size_t elements = (size_t)size * size;
+    float* matrix = malloc(elements * sizeof(float));
+    float* work = malloc(elements * sizeof(float));
+    if (matrix == NULL || work == NULL) {
+        free(matrix);
+        free(work);
+        return;
+    }
+    generate_engine_matrix(matrix, size);
+
+    engine_kind fastest = ENGINE_AUTO;
+    double fastest_time = 0.0;
+    for (int i = ENGINE_AUTO + 1; i < ENGINE_COUNT; i++) {
+        engine_kind engine = (engine_kind)i;
+        if (!engine_supports(context, engine, size) || (engine == ENGINE_CPU_NAIVE && size > MAX_MATRIX_SIZE_CPU)) continue;
+
+        int error_code;
+        prepare_engine(context, engine, &error_code);
+        if (error_code == 0) {
+            time_engine(context, engine, matrix, work, size, 1, &error_code);
+        }
+        double seconds = error_code == 0 ? time_engine(context, engine, matrix, work, size, CALIBRATION_RUNS, &error_code) : 0.0;
+        if (error_code != 0) {
+            printf("%-6d | %-13s | failed (error %d)\n", size, engine_name(engine), error_code);
+            continue;
+        }
+
+        record_engine_benchmark(context, engine, size, seconds);
+        printf("%-6d | %-13s | %-12.6f | %-10.2f\n", size, engine_name(engine), seconds, seconds > 0.0 ? 2.0 * size * size * size / 3.0 / seconds / 1.0e9 : 0.0);
+        if (fastest == ENGINE_AUTO || seconds < fastest_time) {
+            fastest = engine;
+            fastest_time = seconds;
+        }
+    }
+    printf("%-6d | fastest: %s\n", size, engine_name(fastest));
+
+    free(matrix);
+    free(work);
+}
+
+static void run_calibration(engine_context* context, int max_size) {
+    printf("\n===================================\n");
+    printf("Engine calibration on %s\n", context->device_name);
+    printf("-----------------------------------\n");
+    printf("%-6s | %-13s | %-12s | %-10s\n", "Size", "Engine", "Time (s)", "GFLOP/s");
+    printf("--------------------------------------------------\n");
+
+    int size = CALIBRATION_MIN_SIZE < max_size ? CALIBRATION_MIN_SIZE : max_size;
+    while (1) {
+        calibrate_size(context, size);
+        if (size == max_size) break;
+        size = 2 * size < max_size ? 2 * size : max_size;
+    }
+
+    save_engine_benchmarks(context, ENGINE_BENCHMARK_FILE);
+    printf("Benchmark data saved to %s\n", ENGINE_BENCHMARK_FILE);
+    printf("===================================\n");
+}
+
+static void run_batch(engine_context* context, engine_kind engine, int size, int batch_count) {
+    size_t elements = (size_t)size * size;
+    float* matrices = malloc(batch_count * elements * sizeof(float));
+    float* mantissas = malloc(batch_count * sizeof(float));
+    long long* exponents = malloc(batch_count * sizeof(long long));
+    int* signs = malloc(batch_count * sizeof(int));
+    if (matrices == NULL || mantissas == NULL || exponents == NULL || signs == NULL) {
+        free(matrices);
+        free(mantissas);
+        free(exponents);
+        free(signs);
+        return;
+    }
+
+    for (int i = 0; i < batch_count; i++) {
+        generate_engine_matrix(matrices + i * elements, size);
+    }
+
+    int error_code;
+    engine_kind selected = engine == ENGINE_AUTO ? select_batch_engine(context, size, batch_count) : engine;
+    prepare_engine(context, selected, &error_code);
+
+    double start = wall_clock_seconds();
+    if (error_code == 0) {
+        calculate_determinants_engine_batched(context, selected, matrices, batch_count, size, mantissas, exponents, signs, &error_code);
+    }
+    double elapsed = wall_clock_seconds() - start;
+
+    printf("\n===================================\n");
+    printf("Batch of %d matrices (%dx%d), engine: %s%s\n", batch_count, size, size, engine_name(selected), engine == ENGINE_AUTO ? " (selected automatically)" : "");
+    printf("-----------------------------------\n");
+    if (error_code != 0) {
+        printf("Batch failed (error %d)\n", error_code);
+    } else {
+        print_determinant("first", mantissas[0], exponents[0], signs[0]);
+        printf("Execution time: %.4f s (%.1f det/s)\n", elapsed, elapsed > 0.0 ? batch_count / elapsed : 0.0);
+    }
+    printf("===================================\n");
+
+    free(matrices);
+    free(mantissas);
+    free(exponents);
+    free(signs);
+}
+
+int main(int argc, char* argv[]) {
+    engine_kind engine = ENGINE_AUTO;
+    int threads = 0;
+    int batch_count = 0;
+    int calibrate = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--engine") == 0 && i + 1 < argc) {
+            if (!parse_engine_name(argv[++i], &engine)) {
+                printf("Unknown engine: %s (expected auto, cpu-naive, cpu-blocked, opencl-gauss, opencl-lu or batched)\n", argv[i]);
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batch_count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--calibrate") == 0) {
+            calibrate = 1;
+        } else {
+            MATRIX_SIZE = atoi(argv[i]);
+        }
+    }
+
+    if (MATRIX_SIZE < 1) {
+        printf("Invalid matrix size: %d\n", MATRIX_SIZE);
+        return -1;
+    }
+
+    mkdir("outputs", 0777);
+
+    int error_code;
+    engine_context* context = create_engine_context(threads, &error_code);
+    if (context == NULL) {
+        printf("Failed to create engine context (error %d)\n", error_code);
+        return -1;
+    }
+
+    int loaded = load_engine_benchmarks(context, ENGINE_BENCHMARK_FILE);
+    printf("Device: %s%s\n", context->device_name, context->has_opencl_device ? "" : " (no OpenCL device, CPU engines only)");
+    printf("Benchmark records: %d loaded from %s\n", loaded, ENGINE_BENCHMARK_FILE);
+
+    if (calibrate) {
+        run_calibration(context, MATRIX_SIZE);
+    }
+
+    if (batch_count > 0) {
+        run_batch(context, engine, MATRIX_SIZE, batch_count);
+        release_engine_context(context);
+        return 0;
+    }
+
+    engine_kind selected = engine == ENGINE_AUTO ? select_engine(context, MATRIX_SIZE) : engine;
+    if (!engine_supports(context, selected, MATRIX_SIZE)) {
+        printf("Engine %s does not support a %dx%d matrix on this device\n", engine_name(selected), MATRIX_SIZE, MATRIX_SIZE);
+        release_engine_context(context);
+        return -1;
+    }
+
+    size_t elements = (size_t)MATRIX_SIZE * MATRIX_SIZE;
+    float* matrix = malloc(elements * sizeof(float));
+    float* reference = malloc(elements * sizeof(float));
+    if (matrix == NULL || reference == NULL) {
+        free(matrix);
+        free(reference);
+        release_engine_context(context);
+        return -1;
+    }
+    generate_engine_matrix(matrix, MATRIX_SIZE);
+    memcpy(reference, matrix, elements * sizeof(float));
+
+    double start_setup = wall_clock_seconds();
+    prepare_engine(context, selected, &error_code);
+    double setup_time = wall_clock_seconds() - start_setup;
+    if (error_code != 0) {
+        printf("Failed to initialize engine %s (error %d)\n", engine_name(selected), error_code);
+        free(matrix);
+        free(reference);
+        release_engine_context(context);
+        return -1;
+    }
+
+    float mantissa = 0.0f;
+    long long exponent = 0;
+    int sign = 1;
+
+    printf("\n===================================\n");
+    printf("Engine: %s%s\n", engine_name(selected), engine == ENGINE_AUTO ? " (selected automatically)" : "");
+    printf("-----------------------------------\n");
+
+    double start = wall_clock_seconds();
+    calculate_determinant_engine(context, selected, matrix, MATRIX_SIZE, &mantissa, &exponent, &sign, &error_code);
+    double elapsed = wall_clock_seconds() - start;
+
+    if (error_code != 0) {
+        printf("Determinant failed (error %d)\n", error_code);
+    } else {
+        print_determinant(engine_name(selected), mantissa, exponent, sign);
+        printf("Setup: %.4f s\n", setup_time);
+        printf("Execution time: %.4f s (%.2f GFLOP/s)\n", elapsed, elapsed > 0.0 ? 2.0 * elements * MATRIX_SIZE / 3.0 / elapsed / 1.0e9 : 0.0);
+    }
+
+    if (error_code == 0 && selected != ENGINE_CPU_BLOCKED && MATRIX_SIZE <= MAX_MATRIX_SIZE_CPU) {
+        float reference_mantissa = 0.0f;
+        long long reference_exponent = 0;
+        int reference_sign = 1;
+        calculate_determinant_engine(context, ENGINE_CPU_BLOCKED, reference, MATRIX_SIZE, &reference_mantissa, &reference_exponent, &reference_sign, &error_code);
+        print_determinant(engine_name(ENGINE_CPU_BLOCKED), reference_mantissa, reference_exponent, reference_sign);
+
+        if (reference_mantissa != 0.0f) {
+            double ratio = ((double)sign * mantissa) / ((double)reference_sign * reference_mantissa) * pow(10.0, (double)(exponent - reference_exponent));
+            printf("Relative Error: %.6f %%\n", fabs(ratio - 1.0) * 100.0);
+        }
+    }
+    printf("===================================\n");
+
+    free(matrix);
+    free(reference);
+    release_engine_context(context);
+
+    return 0;
+}
@@ -0,0 +1,320 @@
+#define CL_TARGET_OPENCL_VERSION 220
+
+#include "engine.h"
+#include "engine_backends.h"
+#include "cpu_solver.h"
+
+#include <CL/cl.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* const engine_names[ENGINE_COUNT] = {
+    "auto",
+    "cpu-naive",
+    "cpu-blocked",
+    "opencl-gauss",
+    "opencl-lu",
+    "batched"
+};
+
+const char* engine_name(engine_kind engine) {
+    return engine >= 0 && engine < ENGINE_COUNT ? engine_names[engine] : "unknown";
+}
+
+int parse_engine_name(const char* name, engine_kind* out_engine) {
+    for (int i = 0; i < ENGINE_COUNT; i++) {
+        if (strcmp(name, engine_names[i]) == 0) {
+            *out_engine = (engine_kind)i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int query_default_device_name(char* name, size_t length) {
+    cl_platform_id platform_id;
+    cl_device_id device_id;
+    cl_uint n_platforms = 0, n_devices;
+
+    if (clGetPlatformIDs(1, &platform_id, &n_platforms) != CL_SUCCESS || n_platforms == 0) {
+        return 0;
+    }
+
+    cl_int err = clGetDeviceIDs(platform_id, CL_DEVICE_TYPE_GPU, 1, &device_id, &n_devices);
+    if (err != CL_SUCCESS) err = clGetDeviceIDs(platform_id, CL_DEVICE_TYPE_CPU, 1, &device_id, &n_devices);
+    if (err != CL_SUCCESS) {
+        return 0;
+    }
+
+    return clGetDeviceInfo(device_id, CL_DEVICE_NAME, length, name, NULL) == CL_SUCCESS;
+}
+
+engine_context* create_engine_context(int thread_count, int* error_code) {
+    engine_context* context = (engine_context*)calloc(1, sizeof(engine_context));
+    if (context == NULL) {
+        *error_code = ENGINE_ERROR_MEMORY;
+        return NULL;
+    }
+
+    context->thread_count = thread_count > 0 ? thread_count : cpu_thread_count();
+    context->has_opencl_device = query_default_device_name(context->device_name, sizeof(context->device_name));
+    if (!context->has_opencl_device) {
+        strcpy(context->device_name, "host");
+    }
+
+    *error_code = 0;
+    return context;
+}
+
+int engine_supports(const engine_context* context, engine_kind engine, int size) {
+    switch (engine) {
+        case ENGINE_CPU_NAIVE:
+        case ENGINE_CPU_BLOCKED:
+            return size > 0;
+        case ENGINE_OPENCL_GAUSS:
+            return context->has_opencl_device && size > 0 && size <= ENGINE_GAUSS_MAX_SIZE;
+        case ENGINE_OPENCL_LU:
+            return context->has_opencl_device && size > 0;
+        case ENGINE_BATCHED:
+            return context->has_opencl_device && size > 0 && size <= gauss_backend_batch_max_size();
+        default:
+            return 0;
+    }
+}
+
+static double estimate_engine_time(const engine_context* context, engine_kind engine, int size) {
+    const engine_benchmark* below = NULL;
+    const engine_benchmark* above = NULL;
+
+    for (int i = 0; i < context->benchmark_count; i++) {
+        const engine_benchmark* record = &context->benchmarks[i];
+        if (record->engine != engine || record->seconds <= 0.0) continue;
+
+        if (record->matrix_size <= size && (below == NULL || record->matrix_size > below->matrix_size)) {
+            below = record;
+        }
+        if (record->matrix_size >= size && (above == NULL || record->matrix_size < above->matrix_size)) {
+            above = record;
+        }
+    }
+
+    if (below == NULL && above == NULL) {
+        return -1.0;
+    }
+    if (below == NULL) {
+        return above->seconds;
+    }
+    if (above == NULL) {
+        return below->seconds * pow((double)size / below->matrix_size, 3.0);
+    }
+    if (below->matrix_size == above->matrix_size) {
+        return below->seconds;
+    }
+
+    double t = log((double)size / below->matrix_size) / log((double)above->matrix_size / below->matrix_size);
+    return exp(log(below->seconds) + t * (log(above->seconds) - log(below->seconds)));
+}
+
+engine_kind select_engine(const engine_context* context, int size) {
+    engine_kind best = ENGINE_AUTO;
+    double best_time = 0.0;
+
+    for (int i = ENGINE_AUTO + 1; i < ENGINE_COUNT; i++) {
+        engine_kind engine = (engine_kind)i;
+        if (!engine_supports(context, engine, size)) continue;
+
+        double estimate = estimate_engine_time(context, engine, size);
+        if (estimate >= 0.0 && (best == ENGINE_AUTO || estimate < best_time)) {
+            best = engine;
+            best_time = estimate;
+        }
+    }
+
+    if (best != ENGINE_AUTO) {
+        return best;
+    }
+    if (size <= ENGINE_SMALL_MATRIX_SIZE || !engine_supports(context, ENGINE_OPENCL_LU, size)) {
+        return ENGINE_CPU_BLOCKED;
+    }
+    return ENGINE_OPENCL_LU;
+}
+
+engine_kind select_batch_engine(const engine_context* context, int size, int batch_count) {
+    if (batch_count > 1 && engine_supports(context, ENGINE_BATCHED, size)) {
+        return ENGINE_BATCHED;
+    }
+    return select_engine(context, size);
+}
+
+void prepare_engine(engine_context* context, engine_kind engine, int* error_code) {
+    *error_code = 0;
+
+    if ((engine == ENGINE_OPENCL_GAUSS || engine == ENGINE_BATCHED) && context->gauss_solver == NULL) {
+        context->gauss_solver = gauss_backend_create(error_code);
+    } else if (engine == ENGINE_OPENCL_LU && context->lu_solver == NULL) {
+        context->lu_solver = lu_backend_create(error_code);
+    }
+}
+
+void calculate_determinant_engine(engine_context* context, engine_kind engine, float* matrix, int size, float* out_mantissa, long long* out_exponent, int* out_sign, int* error_code) {
+    if (engine == ENGINE_AUTO) {
+        engine = select_engine(context, size);
+    }
+    if (!engine_supports(context, engine, size)) {
+        *error_code = ENGINE_ERROR_UNSUPPORTED;
+        return;
+    }
+
+    prepare_engine(context, engine, error_code);
+    if (*error_code != 0) {
+        return;
+    }
+
+    switch (engine) {
+        case ENGINE_CPU_NAIVE:
+            gauss_backend_cpu_determinant(matrix, size, out_mantissa, out_exponent, out_sign);
+            break;
+        case ENGINE_CPU_BLOCKED:
+            calculate_determinant_blocked(matrix, size, context->thread_count, out_mantissa, out_exponent, out_sign);
+            break;
+        case ENGINE_OPENCL_GAUSS:
+            gauss_backend_determinant(context->gauss_solver, matrix, size, out_mantissa, out_exponent, out_sign);
+            break;
+        case ENGINE_OPENCL_LU:
+            lu_backend_determinant(context->lu_solver, matrix, size, out_mantissa, out_exponent, out_sign, error_code);
+            break;
+        case ENGINE_BATCHED:
+            gauss_backend_determinants_batched(context->gauss_solver, matrix, 1, size, out_mantissa, out_exponent, out_sign, error_code);
+            break;
+        default:
+            *error_code = ENGINE_ERROR_UNSUPPORTED;
+            break;
+    }
+}
+
+void calculate_determinants_engine_batched(engine_context* context, engine_kind engine, const float* matrices, int batch_count, int size, float* out_mantissas, long long* out_exponents, int* out_signs, int* error_code) {
+    if (engine == ENGINE_AUTO) {
+        engine = select_batch_engine(context, size, batch_count);
+    }
+
+    if (engine == ENGINE_BATCHED) {
+        if (!engine_supports(context, engine, size)) {
+            *error_code = ENGINE_ERROR_UNSUPPORTED;
+            return;
+        }
+        prepare_engine(context, engine, error_code);
+        if (*error_code == 0) {
+            gauss_backend_determinants_batched(context->gauss_solver, matrices, batch_count, size, out_mantissas, out_exponents, out_signs, error_code);
+        }
+        return;
+    }
+
+    size_t elements = (size_t)size * size;
+    float* work = (float*)malloc(elements * sizeof(float));
+    if (work == NULL) {
+        *error_code = ENGINE_ERROR_MEMORY;
+        return;
+    }
+
+    *error_code = 0;
+    for (int i = 0; i < batch_count && *error_code == 0; i++) {
+        memcpy(work, matrices + i * elements, elements * sizeof(float));
+        calculate_determinant_engine(context, engine, work, size, &out_mantissas[i], &out_exponents[i], &out_signs[i], error_code);
+    }
+
+    free(work);
+}
+
+void record_engine_benchmark(engine_context* context, engine_kind engine, int size, double seconds) {
+    for (int i = 0; i < context->benchmark_count; i++) {
+        if (context->benchmarks[i].engine == engine && context->benchmarks[i].matrix_size == size) {
+            context->benchmarks[i].seconds = seconds;
+            return;
+        }
+    }
+
+    if (context->benchmark_count < ENGINE_MAX_BENCHMARKS) {
+        engine_benchmark* record = &context->benchmarks[context->benchmark_count++];
+        record->engine = engine;
+        record->matrix_size = size;
+        record->seconds = seconds;
+    }
+}
+
+int load_engine_benchmarks(engine_context* context, const char* path) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        return 0;
+    }
+
+    char line[512];
+    char engine_text[32];
+    char name[256];
+    int matrix_size;
+    double seconds;
+    int loaded = 0;
+
+    while (fgets(line, sizeof(line), file)) {
+        engine_kind engine;
+        if (sscanf(line, "%31s %d %lf %255[^\n]", engine_text, &matrix_size, &seconds, name) == 4 &&
+            strcmp(name, context->device_name) == 0 && parse_engine_name(engine_text, &engine) && engine != ENGINE_AUTO) {
+            record_engine_benchmark(context, engine, matrix_size, seconds);
+            loaded++;
+        }
+    }
+
+    fclose(file);
+    return loaded;
+}
+
+void save_engine_benchmarks(const engine_context* context, const char* path) {
+    char kept[ENGINE_MAX_BENCHMARKS][512];
+    int kept_count = 0;
+
+    FILE* file = fopen(path, "r");
+    if (file) {
+        char line[512];
+        char engine_text[32];
+        char name[256];
+        int matrix_size;
+        double seconds;
+
+        while (fgets(line, sizeof(line), file) && kept_count < ENGINE_MAX_BENCHMARKS) {
+            if (sscanf(line, "%31s %d %lf %255[^\n]", engine_text, &matrix_size, &seconds, name) == 4 && strcmp(name, context->device_name) != 0) {
+                strcpy(kept[kept_count++], line);
+            }
+        }
+        fclose(file);
+    }
+
+    file = fopen(path, "w");
+    if (!file) {
+        printf("Failed to open file: %s\n", path);
+        return;
+    }
+
+    for (int i = 0; i < kept_count; i++) {
+        fputs(kept[i], file);
+    }
+    for (int i = 0; i < context->benchmark_count; i++) {
+        const engine_benchmark* record = &context->benchmarks[i];
+        fprintf(file, "%s %d %.9f %s\n", engine_name(record->engine), record->matrix_size, record->seconds, context->device_name);
+    }
+
+    fclose(file);
+}
+
+void generate_engine_matrix(float* matrix, int size) {
+    lu_backend_generate_matrix(matrix, size);
+}
+
+void release_engine_context(engine_context* context) {
+    if (context == NULL) return;
+
+    if (context->gauss_solver != NULL) gauss_backend_release(context->gauss_solver);
+    if (context->lu_solver != NULL) lu_backend_release(context->lu_solver);
+    free(context);
+}
@@ -0,0 +1,28 @@
+#define CL_TARGET_OPENCL_VERSION 220
+
+#include "matrix.h"
+#include "engine_backends.h"
+
+void* gauss_backend_create(int* error_code) {
+    return gauss_solver_create(error_code);
+}
+
+void gauss_backend_determinant(void* solver, float* matrix, int size, float* out_mantissa, long long* out_exponent, int* out_sign) {
+    gauss_solver_calculate_determinant((gauss_solver*)solver, matrix, size, out_mantissa, out_exponent, out_sign, NULL, NULL, NULL);
+}
+
+void gauss_backend_determinants_batched(void* solver, const float* matrices, int batch_count, int size, float* out_mantissas, long long* out_exponents, int* out_signs, int* error_code) {
+    gauss_solver_calculate_determinants_batched((gauss_solver*)solver, matrices, batch_count, size, NULL, NULL, out_mantissas, out_exponents, out_signs, NULL, error_code);
+}
+
+void gauss_backend_cpu_determinant(float* matrix, int size, float* out_mantissa, long long* out_exponent, int* out_sign) {
+    calculate_determinant_gauss(matrix, size, out_mantissa, out_exponent, out_sign);
+}
+
+int gauss_backend_batch_max_size(void) {
+    return BATCH_MAX_SIZE;
+}
+
+void gauss_backend_release(void* solver) {
+    gauss_solver_release((gauss_solver*)solver);
+}
@@ -0,0 +1,20 @@
+#define CL_TARGET_OPENCL_VERSION 220
+
+#include "matrix.h"
+#include "engine_backends.h"
+
+void* lu_backend_create(int* error_code) {
+    return lu_solver_create(error_code);
+}
+
+void lu_backend_determinant(void* solver, float* matrix, int size, float* out_mantissa, long long* out_exponent, int* out_sign, int* error_code) {
+    lu_solver_calculate_determinant((lu_solver*)solver, matrix, size, out_mantissa, out_exponent, out_sign, NULL, NULL, NULL, error_code);
+}
+
+void lu_backend_generate_matrix(float* matrix, int size) {
+    generate_matrix(matrix, size);
+}
+
+void lu_backend_release(void* solver) {
+    lu_solver_release((lu_solver*)solver);
+}
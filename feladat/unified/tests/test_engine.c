@@ -0,0 +1,178 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <cmocka.h>
+
+#include "engine.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static double determinant_value(float mantissa, long long exponent, int sign) {
+    return (double)sign * (double)mantissa * pow(10.0, (double)exponent);
+}
+
+static void test_engine_names_round_trip() {
+    for (int i = 0; i < ENGINE_COUNT; i++) {
+        engine_kind engine;
+        assert_true(parse_engine_name(engine_name((engine_kind)i), &engine));
+        assert_int_equal(engine, i);
+    }
+
+    engine_kind engine = ENGINE_CPU_NAIVE;
+    assert_false(parse_engine_name("gpu", &engine));
+    assert_int_equal(engine, ENGINE_CPU_NAIVE);
+}
+
+static void test_all_engines_agree() {
+    int size = 40;
+    float matrix[40 * 40];
+    float work[40 * 40];
+    int error_code;
+
+    engine_context* context = create_engine_context(2, &error_code);
+    assert_non_null(context);
+    generate_engine_matrix(matrix, size);
+
+    memcpy(work, matrix, sizeof(matrix));
+    float reference_mantissa;
+    long long reference_exponent;
+    int reference_sign;
+    calculate_determinant_engine(context, ENGINE_CPU_NAIVE, work, size, &reference_mantissa, &reference_exponent, &reference_sign, &error_code);
+    assert_int_equal(error_code, 0);
+    double reference = determinant_value(reference_mantissa, reference_exponent, reference_sign);
+    assert_true(fabs(reference) > 0.0);
+
+    for (int i = ENGINE_AUTO; i < ENGINE_COUNT; i++) {
+        if (i != ENGINE_AUTO && !engine_supports(context, (engine_kind)i, size)) continue;
+
+        float mantissa = 0.0f;
+        long long exponent = 0;
+        int sign = 1;
+        memcpy(work, matrix, sizeof(matrix));
+        calculate_determinant_engine(context, (engine_kind)i, work, size, &mantissa, &exponent, &sign, &error_code);
+        assert_int_equal(error_code, 0);
+        assert_true(fabs(determinant_value(mantissa, exponent, sign) - reference) / fabs(reference) < 1e-3);
+    }
+
+    release_engine_context(context);
+}
+
+static void test_batched_engine_matches_single() {
+    int size = 12;
+    int batch_count = 5;
+    float matrices[5 * 12 * 12];
+    float mantissas[5];
+    long long exponents[5];
+    int signs[5];
+    int error_code;
+
+    engine_context* context = create_engine_context(1, &error_code);
+    assert_non_null(context);
+    for (int i = 0; i < batch_count; i++) {
+        generate_engine_matrix(matrices + i * size * size, size);
+    }
+
+    engine_kind engine = select_batch_engine(context, size, batch_count);
+    calculate_determinants_engine_batched(context, engine, matrices, batch_count, size, mantissas, exponents, signs, &error_code);
+    assert_int_equal(error_code, 0);
+
+    for (int i = 0; i < batch_count; i++) {
+        float work[12 * 12];
+        float mantissa;
+        long long exponent;
+        int sign;
+        memcpy(work, matrices + i * size * size, sizeof(work));
+        calculate_determinant_engine(context, ENGINE_CPU_NAIVE, work, size, &mantissa, &exponent, &sign, &error_code);
+        assert_int_equal(error_code, 0);
+
+        double expected = determinant_value(mantissa, exponent, sign);
+        assert_true(fabs(determinant_value(mantissas[i], exponents[i], signs[i]) - expected) <= 1e-3 * fabs(expected) + 1e-6);
+    }
+
+    release_engine_context(context);
+}
+
+static void test_select_engine_from_benchmarks() {
+    int error_code;
+    engine_context* context = create_engine_context(1, &error_code);
+    assert_non_null(context);
+    context->has_opencl_device = 1;
+
+    assert_int_equal(select_engine(context, 64), ENGINE_CPU_BLOCKED);
+    assert_int_equal(select_engine(context, 4000), ENGINE_OPENCL_LU);
+
+    record_engine_benchmark(context, ENGINE_CPU_BLOCKED, 128, 0.0005);
+    record_engine_benchmark(context, ENGINE_CPU_BLOCKED, 1024, 0.5);
+    record_engine_benchmark(context, ENGINE_OPENCL_LU, 128, 0.004);
+    record_engine_benchmark(context, ENGINE_OPENCL_LU, 1024, 0.05);
+    record_engine_benchmark(context, ENGINE_OPENCL_GAUSS, 1024, 0.2);
+
+    assert_int_equal(select_engine(context, 128), ENGINE_CPU_BLOCKED);
+    assert_int_equal(select_engine(context, 200), ENGINE_CPU_BLOCKED);
+    assert_int_equal(select_engine(context, 1024), ENGINE_OPENCL_LU);
+    assert_int_equal(select_engine(context, 8000), ENGINE_OPENCL_LU);
+
+    record_engine_benchmark(context, ENGINE_OPENCL_LU, 1024, 0.9);
+    assert_int_equal(context->benchmark_count, 5);
+    assert_int_equal(select_engine(context, 1024), ENGINE_OPENCL_GAUSS);
+
+    context->has_opencl_device = 0;
+    assert_int_equal(select_engine(context, 1024), ENGINE_CPU_BLOCKED);
+
+    release_engine_context(context);
+}
+
+static void test_engine_benchmarks_round_trip() {
+    const char* path = "test_engine_benchmarks.txt";
+    int error_code;
+
+    FILE* file = fopen(path, "w");
+    assert_non_null(file);
+    fprintf(file, "opencl-lu 512 0.010000000 Other Device\n");
+    fclose(file);
+
+    engine_context* context = create_engine_context(1, &error_code);
+    assert_non_null(context);
+    assert_int_equal(load_engine_benchmarks(context, path), 0);
+
+    record_engine_benchmark(context, ENGINE_CPU_BLOCKED, 256, 0.004);
+    record_engine_benchmark(context, ENGINE_BATCHED, 16, 0.0000125);
+    save_engine_benchmarks(context, path);
+    release_engine_context(context);
+
+    context = create_engine_context(1, &error_code);
+    assert_non_null(context);
+    assert_int_equal(load_engine_benchmarks(context, path), 2);
+    assert_int_equal(context->benchmarks[0].engine, ENGINE_CPU_BLOCKED);
+    assert_int_equal(context->benchmarks[0].matrix_size, 256);
+    assert_true(fabs(context->benchmarks[1].seconds - 0.0000125) < 1e-12);
+    release_engine_context(context);
+
+    char line[256];
+    int other_device_kept = 0;
+    file = fopen(path, "r");
+    assert_non_null(file);
+    while (fgets(line, sizeof(line), file)) {
+        if (strstr(line, "Other Device") != NULL) other_device_kept = 1;
+    }
+    fclose(file);
+    assert_true(other_device_kept);
+
+    remove(path);
+}
+
+int main() {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_engine_names_round_trip),
+        cmocka_unit_test(test_all_engines_agree),
+        cmocka_unit_test(test_batched_engine_matches_single),
+        cmocka_unit_test(test_select_engine_from_benchmarks),
+        cmocka_unit_test(test_engine_benchmarks_round_trip),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}